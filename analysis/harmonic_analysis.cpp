@@ -0,0 +1,137 @@
+#include "harmonic_analysis.h"
+#include "util/math_constants.h"
+#include "util/rotation.h"
+#include <cmath>
+
+namespace {
+
+// logical element idx of a strided rolling buffer
+inline Scalar get_element(const Scalar* data, const int idx, const int count,
+                          const int offset, const int stride) {
+    const int physical_idx = (offset + idx) % count;
+    return *reinterpret_cast<const Scalar*>(
+        reinterpret_cast<const char*>(data) + physical_idx * stride);
+}
+
+} // namespace
+
+void init_harmonic_analyzer(HarmonicAnalyzer* analyzer) {
+    analyzer->fft.SetFlag(Eigen::FFT<Scalar>::HalfSpectrum);
+}
+
+bool analyze_harmonics(HarmonicAnalyzer* analyzer, const Scalar electrical_freq,
+                       const Scalar* timestamps, const Scalar* values,
+                       const int count, const int offset, const int stride,
+                       HarmonicSpectrum* spectrum) {
+    spectrum->num_periods = 0;
+    spectrum->undersampled = false;
+    spectrum->magnitudes.clear();
+    spectrum->thd = 0;
+    spectrum->ripple = 0;
+
+    const Scalar abs_freq = std::abs(electrical_freq);
+    if (count < 2 || abs_freq == 0) {
+        return false;
+    }
+
+    const Scalar begin_time = get_element(timestamps, 0, count, offset, stride);
+    const Scalar end_time =
+        get_element(timestamps, count - 1, count, offset, stride);
+
+    const int num_periods =
+        std::min<int>(analyzer->max_periods,
+                      int((end_time - begin_time) * abs_freq));
+    if (num_periods <= 0) {
+        return false;
+    }
+
+    // resample the window uniformly, ending on the latest sample
+    const int num_samples = num_periods * analyzer->samples_per_period;
+    const Scalar window_begin = end_time - num_periods / abs_freq;
+    const Scalar sample_dt = num_periods / abs_freq / num_samples;
+
+    analyzer->window_samples.resize(num_samples);
+
+    // find the last recorded sample at or before the window start
+    int lo = 0;
+    int hi = count - 1;
+    while (hi - lo > 1) {
+        const int mid = (lo + hi) / 2;
+        if (get_element(timestamps, mid, count, offset, stride) <=
+            window_begin) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    // harmonic k of the electrical frequency lands in bin k * num_periods
+    const int max_harmonic =
+        std::min(analyzer->max_harmonic, analyzer->samples_per_period / 2 - 1);
+
+    // resampling can not recover harmonics the recording did not resolve
+    const int num_recorded_intervals = count - 1 - lo;
+    if (num_recorded_intervals < 2 * max_harmonic * num_periods) {
+        spectrum->undersampled = true;
+        return false;
+    }
+
+    int idx = lo;
+    for (int i = 0; i < num_samples; ++i) {
+        const Scalar t = window_begin + i * sample_dt;
+        while (idx + 2 < count &&
+               get_element(timestamps, idx + 1, count, offset, stride) <= t) {
+            ++idx;
+        }
+        const Scalar t0 = get_element(timestamps, idx, count, offset, stride);
+        const Scalar t1 =
+            get_element(timestamps, idx + 1, count, offset, stride);
+        const Scalar v0 = get_element(values, idx, count, offset, stride);
+        const Scalar v1 = get_element(values, idx + 1, count, offset, stride);
+        const Scalar alpha = t1 > t0 ? (t - t0) / (t1 - t0) : 0;
+        analyzer->window_samples[i] = v0 + alpha * (v1 - v0);
+    }
+
+    Scalar amplitude_scale = 1.0 / num_samples;
+    if (analyzer->use_hann_window) {
+        RotationRecurrence<Scalar> rotation;
+        init_rotation_recurrence<Scalar>(0, 2 * kPI / num_samples, &rotation);
+        for (int i = 0; i < num_samples; ++i) {
+            analyzer->window_samples[i] *= 0.5 * (1 - rotation.rotation.real());
+            advance_rotation_recurrence(&rotation);
+        }
+        // compensate for the coherent gain of the hann window
+        amplitude_scale *= 2;
+    }
+
+    analyzer->spectrum.resize(num_samples / 2 + 1);
+    analyzer->fft.fwd(analyzer->spectrum.data(),
+                      analyzer->window_samples.data(), num_samples);
+
+    spectrum->num_periods = num_periods;
+    spectrum->magnitudes.resize(max_harmonic + 1);
+    spectrum->magnitudes[0] =
+        analyzer->spectrum[0].real() * amplitude_scale;
+    for (int k = 1; k <= max_harmonic; ++k) {
+        spectrum->magnitudes[k] = 2 * amplitude_scale *
+                                  std::abs(analyzer->spectrum[k * num_periods]);
+    }
+
+    Scalar distortion_sq = 0;
+    for (int k = 2; k <= max_harmonic; ++k) {
+        distortion_sq += spectrum->magnitudes[k] * spectrum->magnitudes[k];
+    }
+    if (spectrum->magnitudes[1] > 0) {
+        spectrum->thd = std::sqrt(distortion_sq) / spectrum->magnitudes[1];
+    }
+
+    const Scalar abs_mean = std::abs(spectrum->magnitudes[0]);
+    if (abs_mean > 0) {
+        const Scalar ac_sq =
+            distortion_sq + spectrum->magnitudes[1] * spectrum->magnitudes[1];
+        // amplitudes are peak values, rms is peak / sqrt(2)
+        spectrum->ripple = std::sqrt(ac_sq / 2) / abs_mean;
+    }
+
+    return true;
+}
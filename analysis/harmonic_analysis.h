@@ -0,0 +1,49 @@
+#pragma once
+
+#include "config/scalar.h"
+#include <complex>
+#include <unsupported/Eigen/FFT>
+#include <vector>
+
+// Amplitudes of the harmonics of the electrical frequency, measured over an
+// integer number of electrical periods.
+struct HarmonicSpectrum {
+    int num_periods = 0; // 0 if there was not enough history to analyze
+    // the history had fewer than two samples per period of the highest
+    // harmonic, so the bins would alias and were not computed
+    bool undersampled = false;
+
+    // magnitudes[0] is the signed mean of the signal,
+    // magnitudes[k] is the amplitude of the k-th electrical harmonic
+    std::vector<Scalar> magnitudes;
+
+    Scalar thd = 0;    // total harmonic distortion, relative to harmonic 1
+    Scalar ripple = 0; // rms of all harmonics, relative to the |mean|
+};
+
+struct HarmonicAnalyzer {
+    int samples_per_period = 64; // must be even
+    int max_periods = 4;
+    int max_harmonic = 15;
+    bool use_hann_window = false; // only useful with max_periods > 1
+
+    // fft plans are cached inside Eigen::FFT per transform size,
+    // so reusing the analyzer reuses the plans and buffers
+    Eigen::FFT<Scalar> fft;
+    std::vector<Scalar> window_samples;
+    std::vector<std::complex<Scalar>> spectrum;
+};
+
+void init_harmonic_analyzer(HarmonicAnalyzer* analyzer);
+
+// Resamples the latest whole electrical periods of a signal and computes its
+// harmonic spectrum. The timestamps and values are read in place, using the
+// same count/offset/stride convention as ImPlot, so rolling buffers can be
+// analyzed without copying them out first. Timestamps must be increasing.
+// Returns false if the signal is too short to contain an electrical period, or
+// too sparsely sampled to resolve analyzer->max_harmonic.
+bool analyze_harmonics(HarmonicAnalyzer* analyzer,
+                       const Scalar electrical_freq, // Hz
+                       const Scalar* timestamps, const Scalar* values,
+                       const int count, const int offset, const int stride,
+                       HarmonicSpectrum* spectrum);
@@ -0,0 +1,130 @@
+#include "harmonic_analysis.h"
+#include "config/scalar.h"
+#include "util/math_constants.h"
+#include <array>
+#include <cmath>
+#include <gtest/gtest.h>
+
+constexpr Scalar kElectricalFreq = 50;
+constexpr int kNumPts = 1000;
+
+Scalar test_signal(const Scalar t) {
+    const Scalar e = 2 * kPI * kElectricalFreq * t;
+    return 0.5 + 2.0 * std::sin(e) + 0.2 * std::sin(3 * e + 0.3) +
+           0.1 * std::cos(5 * e);
+}
+
+TEST(analyze_harmonics, rolling_buffer) {
+    // interleaved timestamp, value pairs, wrapped around at an offset
+    std::array<std::array<Scalar, 2>, kNumPts> samples;
+    const int offset = 123;
+    for (int i = 0; i < kNumPts; ++i) {
+        const Scalar t = 1e-4 * i;
+        samples[(offset + i) % kNumPts] = {t, test_signal(t)};
+    }
+
+    HarmonicAnalyzer analyzer;
+    init_harmonic_analyzer(&analyzer);
+
+    HarmonicSpectrum spectrum;
+    ASSERT_TRUE(analyze_harmonics(&analyzer, kElectricalFreq, &samples[0][0],
+                                  &samples[0][1], kNumPts, offset,
+                                  sizeof(samples[0]), &spectrum));
+
+    EXPECT_EQ(spectrum.num_periods, 4);
+    EXPECT_NEAR(spectrum.magnitudes[0], 0.5, 1e-2);
+    EXPECT_NEAR(spectrum.magnitudes[1], 2.0, 1e-2);
+    EXPECT_NEAR(spectrum.magnitudes[2], 0.0, 1e-2);
+    EXPECT_NEAR(spectrum.magnitudes[3], 0.2, 1e-2);
+    EXPECT_NEAR(spectrum.magnitudes[5], 0.1, 1e-2);
+    EXPECT_NEAR(spectrum.thd, std::sqrt(0.2 * 0.2 + 0.1 * 0.1) / 2.0, 1e-2);
+}
+
+TEST(analyze_harmonics, hann_window) {
+    std::array<Scalar, kNumPts> timestamps;
+    std::array<Scalar, kNumPts> values;
+    for (int i = 0; i < kNumPts; ++i) {
+        timestamps[i] = 1e-4 * i;
+        values[i] = test_signal(timestamps[i]);
+    }
+
+    HarmonicAnalyzer analyzer;
+    analyzer.use_hann_window = true;
+    init_harmonic_analyzer(&analyzer);
+
+    HarmonicSpectrum spectrum;
+    ASSERT_TRUE(analyze_harmonics(&analyzer, kElectricalFreq, timestamps.data(),
+                                  values.data(), kNumPts, 0, sizeof(Scalar),
+                                  &spectrum));
+
+    EXPECT_NEAR(spectrum.magnitudes[1], 2.0, 1e-2);
+    EXPECT_NEAR(spectrum.magnitudes[3], 0.2, 1e-2);
+}
+
+TEST(analyze_harmonics, too_short) {
+    std::array<Scalar, 10> timestamps;
+    std::array<Scalar, 10> values;
+    for (int i = 0; i < 10; ++i) {
+        timestamps[i] = 1e-4 * i;
+        values[i] = test_signal(timestamps[i]);
+    }
+
+    HarmonicAnalyzer analyzer;
+    init_harmonic_analyzer(&analyzer);
+
+    HarmonicSpectrum spectrum;
+    EXPECT_FALSE(analyze_harmonics(&analyzer, kElectricalFreq,
+                                   timestamps.data(), values.data(), 10, 0,
+                                   sizeof(Scalar), &spectrum));
+    EXPECT_EQ(spectrum.num_periods, 0);
+}
+
+TEST(analyze_harmonics, negative_mean) {
+    std::array<Scalar, kNumPts> timestamps;
+    std::array<Scalar, kNumPts> values;
+    for (int i = 0; i < kNumPts; ++i) {
+        timestamps[i] = 1e-4 * i;
+        values[i] = test_signal(timestamps[i]) - 1.0;
+    }
+
+    HarmonicAnalyzer analyzer;
+    init_harmonic_analyzer(&analyzer);
+
+    HarmonicSpectrum spectrum;
+    ASSERT_TRUE(analyze_harmonics(&analyzer, kElectricalFreq, timestamps.data(),
+                                  values.data(), kNumPts, 0, sizeof(Scalar),
+                                  &spectrum));
+
+    EXPECT_NEAR(spectrum.magnitudes[0], -0.5, 1e-2);
+    const Scalar ac_rms = std::sqrt((2.0 * 2.0 + 0.2 * 0.2 + 0.1 * 0.1) / 2);
+    EXPECT_NEAR(spectrum.ripple, ac_rms / 0.5, 5e-2);
+}
+
+TEST(analyze_harmonics, undersampled) {
+    // 20 samples per electrical period can not resolve harmonic 15
+    std::array<Scalar, kNumPts> timestamps;
+    std::array<Scalar, kNumPts> values;
+    for (int i = 0; i < kNumPts; ++i) {
+        timestamps[i] = 1e-3 * i;
+        values[i] = test_signal(timestamps[i]);
+    }
+
+    HarmonicAnalyzer analyzer;
+    init_harmonic_analyzer(&analyzer);
+
+    HarmonicSpectrum spectrum;
+    EXPECT_FALSE(analyze_harmonics(&analyzer, kElectricalFreq,
+                                   timestamps.data(), values.data(), kNumPts,
+                                   0, sizeof(Scalar), &spectrum));
+    EXPECT_TRUE(spectrum.undersampled);
+    EXPECT_TRUE(spectrum.magnitudes.empty());
+
+    // asking only for what the recording resolves is fine
+    analyzer.max_harmonic = 5;
+    EXPECT_TRUE(analyze_harmonics(&analyzer, kElectricalFreq, timestamps.data(),
+                                  values.data(), kNumPts, 0, sizeof(Scalar),
+                                  &spectrum));
+    EXPECT_FALSE(spectrum.undersampled);
+    // linear interpolation of a coarse recording loses a little amplitude
+    EXPECT_NEAR(spectrum.magnitudes[1], 2.0, 5e-2);
+}
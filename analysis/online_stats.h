@@ -0,0 +1,69 @@
+#pragma once
+
+#include "config/scalar.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+// Constant memory summary statistics of a stream of samples.
+// Mean and variance are accumulated with Welford's method.
+struct OnlineStats {
+    int64_t count = 0;
+    Scalar mean = 0;
+    Scalar m2 = 0;      // sum of squared deviations from the mean
+    Scalar mean_sq = 0; // running mean of x^2, for rms
+    Scalar min = std::numeric_limits<Scalar>::infinity();
+    Scalar max = -std::numeric_limits<Scalar>::infinity();
+};
+
+inline void update_online_stats(const Scalar x, OnlineStats* stats) {
+    ++stats->count;
+    const Scalar delta = x - stats->mean;
+    stats->mean += delta / stats->count;
+    stats->m2 += delta * (x - stats->mean);
+    stats->mean_sq += (x * x - stats->mean_sq) / stats->count;
+    stats->min = std::min(stats->min, x);
+    stats->max = std::max(stats->max, x);
+}
+
+// population variance
+inline Scalar get_variance(const OnlineStats& stats) {
+    if (stats.count == 0) {
+        return 0;
+    }
+    return stats.m2 / stats.count;
+}
+
+inline Scalar get_std_dev(const OnlineStats& stats) {
+    return std::sqrt(get_variance(stats));
+}
+
+inline Scalar get_rms(const OnlineStats& stats) {
+    return std::sqrt(stats.mean_sq);
+}
+
+inline Scalar get_peak_to_peak(const OnlineStats& stats) {
+    if (stats.count == 0) {
+        return 0;
+    }
+    return stats.max - stats.min;
+}
+
+// Statistics since the last reset, plus statistics windowed over the
+// most recently completed cycle (eg. an electrical period).
+struct CycleStats {
+    OnlineStats total;
+    OnlineStats cycle;      // in progress
+    OnlineStats last_cycle; // most recently completed
+};
+
+inline void update_cycle_stats(const Scalar x, const bool new_cycle,
+                               CycleStats* stats) {
+    if (new_cycle) {
+        stats->last_cycle = stats->cycle;
+        stats->cycle = {};
+    }
+    update_online_stats(x, &stats->total);
+    update_online_stats(x, &stats->cycle);
+}
@@ -0,0 +1,54 @@
+#include "online_stats.h"
+#include <array>
+#include <cmath>
+#include <gtest/gtest.h>
+
+TEST(online_stats, matches_batch) {
+    const std::array<Scalar, 6> xs = {1.0, -2.0, 3.5, 0.25, 4.0, -1.5};
+
+    OnlineStats stats;
+    for (const Scalar x : xs) {
+        update_online_stats(x, &stats);
+    }
+
+    Scalar mean = 0;
+    Scalar mean_sq = 0;
+    for (const Scalar x : xs) {
+        mean += x / xs.size();
+        mean_sq += x * x / xs.size();
+    }
+    Scalar variance = 0;
+    for (const Scalar x : xs) {
+        variance += (x - mean) * (x - mean) / xs.size();
+    }
+
+    EXPECT_EQ(stats.count, 6);
+    EXPECT_NEAR(stats.mean, mean, 1e-12);
+    EXPECT_NEAR(get_variance(stats), variance, 1e-12);
+    EXPECT_NEAR(get_rms(stats), std::sqrt(mean_sq), 1e-12);
+    EXPECT_EQ(stats.min, -2.0);
+    EXPECT_EQ(stats.max, 4.0);
+    EXPECT_EQ(get_peak_to_peak(stats), 6.0);
+}
+
+TEST(online_stats, large_offset) {
+    // naive sum of squares loses all precision here
+    OnlineStats stats;
+    for (int i = 0; i < 1000; ++i) {
+        update_online_stats(1e9 + (i % 2), &stats);
+    }
+    EXPECT_NEAR(get_variance(stats), 0.25, 1e-6);
+}
+
+TEST(cycle_stats, windowing) {
+    CycleStats stats;
+    update_cycle_stats(1.0, false, &stats);
+    update_cycle_stats(3.0, false, &stats);
+    update_cycle_stats(10.0, true, &stats);
+
+    EXPECT_EQ(stats.total.count, 3);
+    EXPECT_EQ(stats.last_cycle.count, 2);
+    EXPECT_NEAR(stats.last_cycle.mean, 2.0, 1e-12);
+    EXPECT_EQ(stats.cycle.count, 1);
+    EXPECT_NEAR(stats.cycle.mean, 10.0, 1e-12);
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "config/scalar.h"
+#include "util/rolling_buffer.h"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+// trigger conditions
+constexpr int kTriggerRisingEdge = 0;    // crosses level going up
+constexpr int kTriggerFallingEdge = 1;   // crosses level going down
+constexpr int kTriggerEitherEdge = 2;    // crosses level
+constexpr int kTriggerAboveLevel = 3;    // is above level
+constexpr int kTriggerBelowLevel = 4;    // is below level
+constexpr int kTriggerEnterWindow = 5;   // enters [level, level_high]
+constexpr int kTriggerExitWindow = 6;    // leaves [level, level_high]
+
+// capture status
+constexpr int kTriggerIdle = 0;      // not capturing
+constexpr int kTriggerArmed = 1;     // filling pre-trigger buffer, waiting
+constexpr int kTriggerCapturing = 2; // triggered, capturing post-trigger
+
+struct TriggerParams {
+    int signal = 0; // column of the sample to watch
+    int condition = kTriggerRisingEdge;
+    Scalar level = 0;
+    Scalar level_high = 1; // upper bound of window conditions
+    int pre_trigger_samples = 100;
+    int post_trigger_samples = 400;
+    bool auto_rearm = false;
+};
+
+// Oscilloscope style capture of the samples around a trigger event.
+// Samples are any indexable row type, eg. std::array<Scalar, N>.
+template <typename TSample> struct TriggerCapture {
+    // edits apply from the next arm, except auto_rearm which is read when a
+    // capture completes
+    TriggerParams params;
+    int status = kTriggerIdle;
+
+    // copy of params taken when armed, so the buffer sizes and trigger
+    // condition stay fixed for the whole capture
+    TriggerParams armed_params;
+
+    // circular history while armed
+    std::vector<TSample> pre_trigger;
+    RollingBufferContext pre_trigger_ctx{0};
+    int num_armed_samples = 0; // samples seen since arming
+
+    // capture in progress, oldest sample first
+    std::vector<TSample> capture;
+    int capture_trigger_idx = 0;
+    int post_trigger_remaining = 0;
+
+    Scalar last_value = 0;
+
+    // the most recently completed capture, for display
+    std::vector<TSample> snapshot;
+    int snapshot_trigger_idx = 0; // index of the triggering sample
+    int num_captures = 0;
+};
+
+inline bool evaluate_trigger_condition(const TriggerParams& params,
+                                       const Scalar last_value,
+                                       const Scalar value) {
+    const auto in_window = [&params](const Scalar v) {
+        return v >= params.level && v <= params.level_high;
+    };
+    switch (params.condition) {
+    case kTriggerRisingEdge:
+        return last_value < params.level && value >= params.level;
+    case kTriggerFallingEdge:
+        return last_value > params.level && value <= params.level;
+    case kTriggerEitherEdge:
+        return (last_value < params.level) != (value < params.level);
+    case kTriggerAboveLevel:
+        return value > params.level;
+    case kTriggerBelowLevel:
+        return value < params.level;
+    case kTriggerEnterWindow:
+        return !in_window(last_value) && in_window(value);
+    case kTriggerExitWindow:
+        return in_window(last_value) && !in_window(value);
+    default:
+        return false;
+    }
+}
+
+// Start waiting for the next trigger event.
+// All capture memory is allocated here, not while stepping.
+template <typename TSample>
+void arm_trigger_capture(TriggerCapture<TSample>* scope) {
+    scope->armed_params = scope->params;
+    const int pre = std::max(scope->armed_params.pre_trigger_samples, 0);
+    const int post = std::max(scope->armed_params.post_trigger_samples, 0);
+    scope->pre_trigger.resize(pre);
+    scope->pre_trigger_ctx = RollingBufferContext(pre);
+    scope->num_armed_samples = 0;
+    scope->capture.clear();
+    scope->capture.reserve(pre + 1 + post);
+    scope->snapshot.reserve(pre + 1 + post);
+    scope->status = kTriggerArmed;
+}
+
+template <typename TSample>
+void disarm_trigger_capture(TriggerCapture<TSample>* scope) {
+    scope->status = kTriggerIdle;
+}
+
+// Call once per simulation step.
+// Returns true when a capture has just been completed into the snapshot.
+template <typename TSample>
+bool step_trigger_capture(const TSample& sample,
+                          TriggerCapture<TSample>* scope) {
+    if (scope->status == kTriggerIdle) {
+        return false;
+    }
+
+    const TriggerParams& params = scope->armed_params;
+    const Scalar value = sample[params.signal];
+    const Scalar last_value = scope->last_value;
+    scope->last_value = value;
+
+    if (scope->status == kTriggerArmed) {
+        const RollingBufferContext& ctx = scope->pre_trigger_ctx;
+
+        // only trigger once the pre-trigger history is full,
+        // and there is a previous value to detect edges against
+        const bool ready = scope->num_armed_samples >= int(ctx.capacity) &&
+                           scope->num_armed_samples > 0;
+        if (!ready ||
+            !evaluate_trigger_condition(params, last_value, value)) {
+            if (ctx.capacity > 0) {
+                scope->pre_trigger[ctx.next_idx] = sample;
+                rolling_buffer_advance_idx(&scope->pre_trigger_ctx);
+            }
+            ++scope->num_armed_samples;
+            return false;
+        }
+
+        // triggered, unroll the pre-trigger history oldest first
+        const int count = get_rolling_buffer_count(ctx);
+        const int begin = get_rolling_buffer_begin(ctx);
+        for (int i = 0; i < count; ++i) {
+            scope->capture.push_back(
+                scope->pre_trigger[(begin + i) % ctx.capacity]);
+        }
+        scope->capture_trigger_idx = int(scope->capture.size());
+        scope->capture.push_back(sample);
+        scope->post_trigger_remaining = params.post_trigger_samples;
+        scope->status = kTriggerCapturing;
+    } else {
+        scope->capture.push_back(sample);
+        --scope->post_trigger_remaining;
+    }
+
+    if (scope->post_trigger_remaining > 0) {
+        return false;
+    }
+
+    // capture complete
+    scope->snapshot_trigger_idx = scope->capture_trigger_idx;
+    std::swap(scope->snapshot, scope->capture);
+    ++scope->num_captures;
+
+    if (scope->params.auto_rearm) {
+        arm_trigger_capture(scope);
+    } else {
+        scope->status = kTriggerIdle;
+    }
+    return true;
+}
@@ -0,0 +1,123 @@
+#include "trigger.h"
+#include <array>
+#include <gtest/gtest.h>
+
+// time, value
+using Sample = std::array<Scalar, 2>;
+
+TriggerCapture<Sample> make_capture(const int condition) {
+    TriggerCapture<Sample> scope;
+    scope.params.signal = 1;
+    scope.params.condition = condition;
+    scope.params.level = 0.5;
+    scope.params.pre_trigger_samples = 3;
+    scope.params.post_trigger_samples = 2;
+    return scope;
+}
+
+TEST(evaluate_trigger_condition, edges) {
+    TriggerParams params;
+    params.level = 1;
+
+    params.condition = kTriggerRisingEdge;
+    EXPECT_TRUE(evaluate_trigger_condition(params, 0, 1));
+    EXPECT_FALSE(evaluate_trigger_condition(params, 1, 0));
+
+    params.condition = kTriggerFallingEdge;
+    EXPECT_TRUE(evaluate_trigger_condition(params, 2, 1));
+    EXPECT_FALSE(evaluate_trigger_condition(params, 0, 2));
+
+    params.condition = kTriggerEitherEdge;
+    EXPECT_TRUE(evaluate_trigger_condition(params, 0, 2));
+    EXPECT_TRUE(evaluate_trigger_condition(params, 2, 0));
+    EXPECT_FALSE(evaluate_trigger_condition(params, 2, 3));
+}
+
+TEST(evaluate_trigger_condition, window) {
+    TriggerParams params;
+    params.level = -1;
+    params.level_high = 1;
+
+    params.condition = kTriggerEnterWindow;
+    EXPECT_TRUE(evaluate_trigger_condition(params, 3, 0));
+    EXPECT_FALSE(evaluate_trigger_condition(params, 0, 0.5));
+
+    params.condition = kTriggerExitWindow;
+    EXPECT_TRUE(evaluate_trigger_condition(params, 0, -3));
+    EXPECT_FALSE(evaluate_trigger_condition(params, 3, 4));
+}
+
+TEST(step_trigger_capture, pre_and_post_trigger) {
+    TriggerCapture<Sample> scope = make_capture(kTriggerRisingEdge);
+    arm_trigger_capture(&scope);
+
+    // rising edge at t = 10
+    bool completed = false;
+    int t = 0;
+    for (; t < 20 && !completed; ++t) {
+        completed = step_trigger_capture(Sample{Scalar(t), t < 10 ? 0.0 : 1.0},
+                                         &scope);
+    }
+
+    ASSERT_TRUE(completed);
+    EXPECT_EQ(t, 13); // completed on the second post trigger sample
+    EXPECT_EQ(scope.status, kTriggerIdle);
+    EXPECT_EQ(scope.num_captures, 1);
+    ASSERT_EQ(scope.snapshot.size(), 6);
+    EXPECT_EQ(scope.snapshot_trigger_idx, 3);
+    for (int i = 0; i < 6; ++i) {
+        EXPECT_EQ(scope.snapshot[i][0], 7 + i);
+    }
+}
+
+TEST(step_trigger_capture, waits_for_pre_trigger_history) {
+    TriggerCapture<Sample> scope = make_capture(kTriggerAboveLevel);
+    arm_trigger_capture(&scope);
+
+    // condition is true immediately, but history is not full
+    for (int t = 0; t < 3; ++t) {
+        step_trigger_capture(Sample{Scalar(t), 1.0}, &scope);
+        EXPECT_EQ(scope.status, kTriggerArmed);
+    }
+    step_trigger_capture(Sample{3, 1.0}, &scope);
+    EXPECT_EQ(scope.status, kTriggerCapturing);
+}
+
+TEST(step_trigger_capture, auto_rearm) {
+    TriggerCapture<Sample> scope = make_capture(kTriggerEitherEdge);
+    scope.params.auto_rearm = true;
+    arm_trigger_capture(&scope);
+
+    // square wave with period 20
+    for (int t = 0; t < 100; ++t) {
+        step_trigger_capture(Sample{Scalar(t), (t / 10) % 2 ? 1.0 : 0.0},
+                             &scope);
+    }
+    EXPECT_EQ(scope.status, kTriggerArmed);
+    EXPECT_EQ(scope.num_captures, 9);
+}
+
+TEST(step_trigger_capture, edits_apply_from_next_arm) {
+    TriggerCapture<Sample> scope = make_capture(kTriggerRisingEdge);
+    arm_trigger_capture(&scope);
+
+    // the gui can edit the params while armed
+    int t = 0;
+    for (; t < 5; ++t) {
+        step_trigger_capture(Sample{Scalar(t), 0.0}, &scope);
+    }
+    scope.params.post_trigger_samples = 1000;
+    scope.params.level = 2;
+
+    // rising edge at t = 10
+    bool completed = false;
+    for (; t < 20 && !completed; ++t) {
+        completed = step_trigger_capture(Sample{Scalar(t), t < 10 ? 0.0 : 1.0},
+                                         &scope);
+    }
+    ASSERT_TRUE(completed);
+    EXPECT_EQ(scope.snapshot.size(), size_t(3 + 1 + 2));
+
+    arm_trigger_capture(&scope);
+    EXPECT_EQ(scope.armed_params.post_trigger_samples, 1000);
+}
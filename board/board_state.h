@@ -4,9 +4,12 @@
 #include "gate_state.h"
 #include "pwm_state.h"
 
-struct BoardState {
+template <int kNumPhases>
+struct BasicBoardState {
     Scalar bus_voltage = 24;
 
-    PwmState pwm;
-    GateState gate;
+    BasicPwmState<kNumPhases> pwm;
+    BasicGateState<kNumPhases> gate;
 };
+
+using BoardState = BasicBoardState<3>;
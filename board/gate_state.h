@@ -2,17 +2,33 @@
 
 #include "config/scalar.h"
 #include <Eigen/Dense>
+#include <algorithm>
 #include <array>
+#include <bitset>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 
 // literals for use with switch states
 constexpr int LOW = 0;
 constexpr int HIGH = 1;
 constexpr int OFF = 2;
 
-struct GateState {
+// one bit per phase, bit i for phase i
+using GateMask = uint32_t;
+
+template <int kNumPhases>
+constexpr GateMask kAllPhasesMask = (GateMask(1) << kNumPhases) - 1;
+
+template <int kNumPhases>
+struct BasicGateState {
+    static_assert(kNumPhases < 32, "phases must fit in a GateMask");
+
     // time between commutations when gate is neither
     // high nor low, to prevent shoot-through current
     Scalar dead_time = 0; // sec
+    // number of steps a switching gate spends off, see set_dead_time
+    int dead_time_ticks = 0;
 
     Scalar diode_active_voltage = 1;    // voltage drop,
                                         // which develops current flows across
@@ -21,70 +37,189 @@ struct GateState {
                                         // above which diode develops the
                                         // v_diode_active voltage
 
-    std::array<bool, 3> commanded = {};
-    std::array<int, 3> actual = {OFF, OFF, OFF};
-    std::array<Scalar, 3> dead_time_remaining = {};
+    GateMask commanded = 0; // set bits are commanded high, the rest low
+
+    // actual switch states. phases in neither mask are OFF
+    GateMask high = 0;
+    GateMask low = 0;
+    std::array<int, kNumPhases> dead_time_remaining = {}; // ticks
+
+    // gates turned off so far, for comparing modulation strategies
+    int64_t num_switching_events = 0;
 };
 
-inline void update_gate_state(const Scalar dt, GateState* gate_state) {
-    for (int i = 0; i < 3; ++i) {
-        const int command = gate_state->commanded[i] ? HIGH : LOW;
+using GateState = BasicGateState<3>;
 
-        if (gate_state->actual[i] == command) {
-            // nothing to do here
-            continue;
-        }
+template <int kNumPhases>
+inline void set_dead_time(const Scalar dead_time, const Scalar dt,
+                          BasicGateState<kNumPhases>* gate_state) {
+    gate_state->dead_time = dead_time;
+    // the step that turns a gate off already accounts for one dt
+    gate_state->dead_time_ticks =
+        std::max(0, int(std::ceil(dead_time / dt)) - 1);
+}
 
-        if (gate_state->actual[i] == OFF) {
-            gate_state->dead_time_remaining[i] -= dt;
-
-            // see if sufficient dead time has been acheived
-            if (gate_state->dead_time_remaining[i] <= 0) {
-                gate_state->actual[i] = command;
-            }
-        } else {
-            // gate is actually on - need to enter dead time
-            gate_state->actual[i] = OFF;
-            gate_state->dead_time_remaining[i] = gate_state->dead_time - dt;
-
-            // see if sufficient dead time has been acheived
-            // simulation speed is too coarse to see the dead time
-            if (gate_state->dead_time_remaining[i] <= 0) {
-                gate_state->actual[i] = command;
-            }
-        }
+template <int kNumPhases>
+inline GateMask get_off_mask(const BasicGateState<kNumPhases>& gate_state) {
+    return kAllPhasesMask<kNumPhases> & ~(gate_state.high | gate_state.low);
+}
+
+// LOW, HIGH or OFF
+template <int kNumPhases>
+inline int get_gate(const BasicGateState<kNumPhases>& gate_state,
+                    const int phase) {
+    return ((gate_state.high >> phase) & 1) |
+           (((get_off_mask(gate_state) >> phase) & 1) << 1);
+}
+
+template <size_t kNumPhases>
+inline GateMask to_gate_mask(const std::array<bool, kNumPhases>& commanded) {
+    GateMask mask = 0;
+    for (size_t i = 0; i < kNumPhases; ++i) {
+        mask |= GateMask(commanded[i]) << i;
+    }
+    return mask;
+}
+
+template <int kNumPhases>
+inline void update_gate_state(BasicGateState<kNumPhases>* gate_state) {
+    const GateMask command_high =
+        gate_state->commanded & kAllPhasesMask<kNumPhases>;
+    const GateMask command_low =
+        ~gate_state->commanded & kAllPhasesMask<kNumPhases>;
+
+    // gates conducting against the command enter dead time
+    const GateMask turning_off =
+        (gate_state->high & command_low) | (gate_state->low & command_high);
+    gate_state->high &= ~turning_off;
+    gate_state->low &= ~turning_off;
+    gate_state->num_switching_events += std::bitset<32>(turning_off).count();
+
+    // count down the dead time of every phase, restarting it for the
+    // phases that just turned off. the count only matters while off
+    GateMask settled = 0;
+    for (int i = 0; i < kNumPhases; ++i) {
+        const bool restart = (turning_off >> i) & 1;
+        const int remaining =
+            restart ? gate_state->dead_time_ticks
+                    : std::max(gate_state->dead_time_remaining[i] - 1, 0);
+        gate_state->dead_time_remaining[i] = remaining;
+        settled |= GateMask(remaining == 0) << i;
+    }
+
+    settled &= get_off_mask(*gate_state);
+    gate_state->high |= settled & command_high;
+    gate_state->low |= settled & command_low;
+}
+
+namespace gate_internal {
+
+// pole voltage = bus voltage * kBusFactor - diode voltage * kDiodeFactor,
+// indexed by (gate state) * 4 + (current > 0) * 2 + (diode conducting).
+// an off gate conducts through the high side diode when current flows
+// into the pole, and through the low side diode when it flows out
+constexpr Scalar kBusFactor[] = {
+    0, 0, 0, 0, // LOW
+    1, 1, 1, 1, // HIGH
+    1, 1, 0, 0, // OFF
+};
+constexpr Scalar kDiodeFactor[] = {
+    0, 0,  0, 0, // LOW
+    0, 0,  0, 0, // HIGH
+    0, -1, 0, 1, // OFF
+};
+
+} // namespace gate_internal
+
+// off gates without current are open, neither diode conducts
+template <int kNumPhases>
+inline GateMask
+get_open_mask(const Eigen::Matrix<Scalar, kNumPhases, 1>& phase_currents,
+              const BasicGateState<kNumPhases>& gate) {
+    GateMask zero_current = 0;
+    for (int i = 0; i < kNumPhases; ++i) {
+        zero_current |= GateMask(phase_currents(i) == 0) << i;
     }
+    return zero_current & get_off_mask(gate);
 }
 
-inline Eigen::Matrix<Scalar, 3, 1>
+template <int kNumPhases>
+inline Eigen::Matrix<Scalar, kNumPhases, 1>
 get_pole_voltages(const Scalar bus_voltage,
-                  const Eigen::Matrix<Scalar, 3, 1>& phase_currents,
-                  const GateState& gate) {
-    Eigen::Matrix<Scalar, 3, 1> pole_voltages;
-    for (int i = 0; i < 3; ++i) {
-        Scalar v_pole = 0;
-        switch (gate.actual[i]) {
-        case OFF:
-            // todo: derivation
-            if (phase_currents(i) > 0) {
-                pole_voltages(i) = 0;
-            } else {
-                pole_voltages(i) = bus_voltage;
-            }
-            if (std::abs(phase_currents(i)) > gate.diode_active_current) {
-                pole_voltages(i) -= gate.diode_active_voltage;
-            }
-            break;
-        case HIGH:
-            pole_voltages(i) = bus_voltage;
-            break;
-        case LOW:
-            pole_voltages(i) = 0;
-            break;
-        default:
-            printf("Unhandled switch case!");
-            exit(-1);
+                  const Eigen::Matrix<Scalar, kNumPhases, 1>& phase_currents,
+                  const Eigen::Matrix<Scalar, kNumPhases, 1>& bEmfs,
+                  const BasicGateState<kNumPhases>& gate) {
+    Eigen::Matrix<Scalar, kNumPhases, 1> pole_voltages;
+    for (int i = 0; i < kNumPhases; ++i) {
+        const int index =
+            get_gate(gate, i) * 4 + int(phase_currents(i) > 0) * 2 +
+            int(std::abs(phase_currents(i)) > gate.diode_active_current);
+        pole_voltages(i) =
+            bus_voltage * gate_internal::kBusFactor[index] -
+            gate.diode_active_voltage * gate_internal::kDiodeFactor[index];
+    }
+
+    const GateMask open = get_open_mask(phase_currents, gate);
+    if (open == 0) {
+        return pole_voltages;
+    }
+
+    // an open phase floats at the neutral voltage plus its bEmf, which
+    // keeps its current at zero. the neutral voltage is set by the
+    // phases still conducting
+    Scalar neutral_voltage = 0;
+    int num_conducting = 0;
+    for (int i = 0; i < kNumPhases; ++i) {
+        const bool conducting = !((open >> i) & 1);
+        neutral_voltage += conducting * (pole_voltages(i) - bEmfs(i));
+        num_conducting += conducting;
+    }
+    if (num_conducting > 0) {
+        neutral_voltage /= num_conducting;
+    } else {
+        // nothing conducts, center the bEmfs between the rails
+        neutral_voltage =
+            (bus_voltage - bEmfs.maxCoeff() - bEmfs.minCoeff()) / 2;
+    }
+
+    // past the rails a diode starts conducting
+    for (int i = 0; i < kNumPhases; ++i) {
+        if ((open >> i) & 1) {
+            pole_voltages(i) =
+                std::clamp(neutral_voltage + bEmfs(i),
+                           -gate.diode_active_voltage,
+                           bus_voltage + gate.diode_active_voltage);
         }
     }
     return pole_voltages;
 }
+
+// bounds on the phase currents at the end of a step. current through an
+// off gate flows through one of its diodes and can not reverse, so
+// reaching zero ends conduction until a diode is forward biased again
+template <int kNumPhases>
+inline void get_phase_current_bounds(
+    const Scalar bus_voltage,
+    const Eigen::Matrix<Scalar, kNumPhases, 1>& pole_voltages,
+    const Eigen::Matrix<Scalar, kNumPhases, 1>& phase_currents,
+    const BasicGateState<kNumPhases>& gate,
+    Eigen::Matrix<Scalar, kNumPhases, 1>* min_phase_currents,
+    Eigen::Matrix<Scalar, kNumPhases, 1>* max_phase_currents) {
+    constexpr Scalar kInf = std::numeric_limits<Scalar>::infinity();
+    const GateMask off = get_off_mask(gate);
+
+    for (int i = 0; i < kNumPhases; ++i) {
+        const bool low_diode =
+            phase_currents(i) > 0 ||
+            (phase_currents(i) == 0 &&
+             pole_voltages(i) <= -gate.diode_active_voltage);
+        const bool high_diode =
+            phase_currents(i) < 0 ||
+            (phase_currents(i) == 0 &&
+             pole_voltages(i) >= bus_voltage + gate.diode_active_voltage);
+
+        const bool is_off = (off >> i) & 1;
+        (*min_phase_currents)(i) = is_off && !high_diode ? 0 : -kInf;
+        (*max_phase_currents)(i) = is_off && !low_diode ? 0 : kInf;
+    }
+}
@@ -0,0 +1,112 @@
+#include "gate_state.h"
+#include <gtest/gtest.h>
+
+TEST(update_gate_state, dead_time) {
+    GateState gate;
+    set_dead_time(/*dead_time=*/3e-6, /*dt=*/1e-6, &gate);
+    EXPECT_EQ(gate.dead_time_ticks, 2);
+
+    // gates start off and settle on the first update
+    gate.commanded = 0b011;
+    update_gate_state(&gate);
+    EXPECT_EQ(get_gate(gate, 0), HIGH);
+    EXPECT_EQ(get_gate(gate, 1), HIGH);
+    EXPECT_EQ(get_gate(gate, 2), LOW);
+
+    // switching phase 1 low holds it off for the dead time
+    gate.commanded = 0b001;
+    update_gate_state(&gate);
+    EXPECT_EQ(get_gate(gate, 1), OFF);
+    update_gate_state(&gate);
+    EXPECT_EQ(get_gate(gate, 1), OFF);
+    update_gate_state(&gate);
+    EXPECT_EQ(get_gate(gate, 1), LOW);
+
+    EXPECT_EQ(get_gate(gate, 0), HIGH);
+    EXPECT_EQ(get_gate(gate, 2), LOW);
+}
+
+TEST(update_gate_state, no_dead_time) {
+    GateState gate;
+    set_dead_time(/*dead_time=*/0, /*dt=*/1e-6, &gate);
+
+    gate.commanded = 0b101;
+    update_gate_state(&gate);
+    gate.commanded = 0b010;
+    update_gate_state(&gate);
+    EXPECT_EQ(gate.high, 0b010u);
+    EXPECT_EQ(gate.low, 0b101u);
+}
+
+TEST(get_pole_voltages, gate_states) {
+    const Scalar bus_voltage = 24;
+    const Eigen::Matrix<Scalar, 3, 1> bEmfs = {0, 0, 0};
+    GateState gate;
+    gate.diode_active_voltage = 0.7;
+    gate.high = 0b001;
+    gate.low = 0b010;
+
+    // phase 2 is off, so its voltage follows the current direction
+    Eigen::Matrix<Scalar, 3, 1> currents = {1, -1, 1};
+    Eigen::Matrix<Scalar, 3, 1> voltages =
+        get_pole_voltages(bus_voltage, currents, bEmfs, gate);
+    EXPECT_EQ(voltages(0), bus_voltage);
+    EXPECT_EQ(voltages(1), 0);
+    EXPECT_NEAR(voltages(2), -0.7, 1e-12);
+
+    currents(2) = -1;
+    voltages = get_pole_voltages(bus_voltage, currents, bEmfs, gate);
+    EXPECT_NEAR(voltages(2), bus_voltage + 0.7, 1e-12);
+
+    // below the diode threshold there is no drop
+    currents(2) = -1e-4;
+    voltages = get_pole_voltages(bus_voltage, currents, bEmfs, gate);
+    EXPECT_EQ(voltages(2), bus_voltage);
+}
+
+TEST(get_pole_voltages, open_phase_floats) {
+    const Scalar bus_voltage = 24;
+    GateState gate;
+    gate.diode_active_voltage = 0.7;
+    gate.high = 0b001;
+    gate.low = 0b010;
+
+    // the open phase sits at the neutral voltage plus its bEmf
+    const Eigen::Matrix<Scalar, 3, 1> currents = {1, -1, 0};
+    Eigen::Matrix<Scalar, 3, 1> bEmfs = {2, -1, 3};
+    Eigen::Matrix<Scalar, 3, 1> voltages =
+        get_pole_voltages(bus_voltage, currents, bEmfs, gate);
+    const Scalar neutral_voltage = ((bus_voltage - 2) + (0 + 1)) / 2;
+    EXPECT_NEAR(voltages(2), neutral_voltage + 3, 1e-12);
+
+    // until the bEmf forward biases a diode
+    bEmfs(2) = 20;
+    voltages = get_pole_voltages(bus_voltage, currents, bEmfs, gate);
+    EXPECT_NEAR(voltages(2), bus_voltage + 0.7, 1e-12);
+}
+
+TEST(get_phase_current_bounds, diode_direction) {
+    const Scalar bus_voltage = 24;
+    GateState gate;
+    gate.diode_active_voltage = 0.7;
+    gate.high = 0b001;
+
+    const Eigen::Matrix<Scalar, 3, 1> currents = {1, 1, 0};
+    const Eigen::Matrix<Scalar, 3, 1> voltages = {bus_voltage, -0.7, 5};
+    Eigen::Matrix<Scalar, 3, 1> min_currents;
+    Eigen::Matrix<Scalar, 3, 1> max_currents;
+    get_phase_current_bounds(bus_voltage, voltages, currents, gate,
+                             &min_currents, &max_currents);
+
+    // on gates are unbounded
+    EXPECT_TRUE(std::isinf(min_currents(0)));
+    EXPECT_TRUE(std::isinf(max_currents(0)));
+
+    // the low side diode can not reverse
+    EXPECT_EQ(min_currents(1), 0);
+    EXPECT_TRUE(std::isinf(max_currents(1)));
+
+    // open between the rails
+    EXPECT_EQ(min_currents(2), 0);
+    EXPECT_EQ(max_currents(2), 0);
+}
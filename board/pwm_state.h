@@ -1,12 +1,14 @@
 #pragma once
 
 #include "config/scalar.h"
+#include "gate_state.h"
 #include "util/quantization.h"
 #include "util/time.h"
 #include <array>
 
-struct PwmState {
-    std::array<Scalar, 3> duties = {};
+template <int kNumPhases>
+struct BasicPwmState {
+    std::array<Scalar, kNumPhases> duties = {};
     Scalar period = 1.0 / 15000; // sec, 15kHz
     Scalar timer = 0;            // 0 to 1
 
@@ -14,7 +16,10 @@ struct PwmState {
     Scalar resolution = 0; // quantization, when positive
 };
 
-inline bool step_pwm_state(const Scalar dt, PwmState* state) {
+using PwmState = BasicPwmState<3>;
+
+template <int kNumPhases>
+inline bool step_pwm_state(const Scalar dt, BasicPwmState<kNumPhases>* state) {
     const bool ticked = periodic_timer(state->period, dt, &state->timer);
     const Scalar progress = state->timer / state->period;
     state->level = progress < 0.5 ? 2.0 * progress : 2.0 * (1.0 - progress);
@@ -26,10 +31,11 @@ inline bool step_pwm_state(const Scalar dt, PwmState* state) {
     return ticked;
 }
 
-inline std::array<bool, 3> get_pwm_gate_command(const PwmState& state) {
-    std::array<bool, 3> commanded;
-    for (int i = 0; i < 3; ++i) {
-        commanded[i] = state.duties[i] > state.level;
+template <int kNumPhases>
+inline GateMask get_pwm_gate_command(const BasicPwmState<kNumPhases>& state) {
+    GateMask commanded = 0;
+    for (int i = 0; i < kNumPhases; ++i) {
+        commanded |= GateMask(state.duties[i] > state.level) << i;
     }
     return commanded;
 }
@@ -0,0 +1,80 @@
+#pragma once
+
+// Stable C ABI for controllers built as shared objects and loaded by the
+// simulator at runtime, see simulator/controller_plugin_host.h. Plain C so
+// that plugins can be built by any compiler, in any language with C
+// linkage. Bump the version on any change to these structs, appending
+// included: the host only loads plugins built against its own version.
+// The api also records its size, which the host checks, to catch plugins
+// built against a header whose layout changed without a bump.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BIRO_CONTROLLER_ABI_VERSION 2
+
+// the one symbol a plugin exports, of type BiroGetControllerApiFn
+#define BIRO_CONTROLLER_API_SYMBOL "biro_get_controller_api"
+
+#define BIRO_CONTROLLER_NUM_PHASES 3
+
+// what the host knows about the motor when creating a controller
+typedef struct BiroControllerConfig {
+    double period; // sec between steps
+    int32_t num_pole_pairs;
+    double phase_resistance;  // ohm
+    double phase_inductance;  // H
+    double normed_bEmf0;      // fundamental of the normed bEmf, V . s
+    double rotor_inertia;     // kg . m^2
+} BiroControllerConfig;
+
+// measured each step
+typedef struct BiroControllerInputs {
+    double time; // sec
+    double phase_currents[BIRO_CONTROLLER_NUM_PHASES];
+    double rotor_angle;       // mechanical, in [0, 2pi)
+    double rotor_angular_vel; // mechanical, rad / sec
+    double bus_voltage;
+    double desired_torque; // N . m
+} BiroControllerInputs;
+
+// outputs are either pwm duties, or gates driven directly
+#define BIRO_CONTROLLER_OUTPUT_DUTIES 0
+#define BIRO_CONTROLLER_OUTPUT_GATES 1
+
+typedef struct BiroControllerOutputs {
+    int32_t mode; // BIRO_CONTROLLER_OUTPUT_*
+    // in [0, 1], compared against the pwm carrier until the next step
+    double duties[BIRO_CONTROLLER_NUM_PHASES];
+    // bit i set commands phase i high, clear commands it low
+    uint32_t gates;
+} BiroControllerOutputs;
+
+typedef struct BiroControllerApi {
+    uint32_t abi_version; // BIRO_CONTROLLER_ABI_VERSION of the plugin
+    uint32_t struct_size; // sizeof(BiroControllerApi) of the plugin
+    const char* name;     // may be null
+
+    // returns null on failure
+    void* (*create)(const BiroControllerConfig* config);
+    void (*destroy)(void* controller);
+
+    void (*step)(void* controller, const BiroControllerInputs* inputs,
+                 BiroControllerOutputs* outputs);
+
+    // Steps count independent controllers, controllers[i] with inputs[i]
+    // into outputs[i], as lane parallel simulations do. Optional, the host
+    // calls step for each lane when null.
+    void (*step_batch)(void* const* controllers,
+                       const BiroControllerInputs* inputs,
+                       BiroControllerOutputs* outputs, int32_t count);
+} BiroControllerApi;
+
+typedef const BiroControllerApi* (*BiroGetControllerApiFn)(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
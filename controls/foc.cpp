@@ -1,19 +1,13 @@
 #include "foc.h"
 #include "util/clarke_transform.h"
-#include "util/rotation.h"
-
-std::complex<Scalar>
-get_desired_current_qd_non_sinusoidal(const Scalar desired_torque,
-                                      const MotorState& motor) {
-    const Scalar q_axis_electrical_angle = get_q_axis_electrical_angle(
-        motor.params.num_pole_pairs, motor.kinematic.rotor_angle);
-    const std::complex<Scalar> park_transform =
-        get_rotation(-q_axis_electrical_angle);
 
+std::complex<Scalar> get_desired_current_qd_non_sinusoidal(
+    const Scalar desired_torque, const std::complex<Scalar>& park_transform,
+    const Eigen::Matrix<Scalar, 3, 1>& normed_bEmfs) {
     // try to generate torque only along the q axis, even if there are
     // d-axis harmonics present
     const std::complex<Scalar> normed_bEmf_qd =
-        park_transform * clarke_transform(motor.electrical.normed_bEmfs);
+        park_transform * clarke_transform(normed_bEmfs);
     // todo: handle when normed_bEmf_qd.real() == 0
     const Scalar desired_current_q = desired_torque / normed_bEmf_qd.real();
 
@@ -28,13 +22,8 @@ std::complex<Scalar> get_desired_current_qd(const Scalar desired_torque,
 }
 
 void step_foc_current_controller(const std::complex<Scalar>& desired_current_qd,
-                                 const MotorState& motor, FocState* foc_state) {
-    const Scalar q_axis_electrical_angle = get_q_axis_electrical_angle(
-        motor.params.num_pole_pairs, motor.kinematic.rotor_angle);
-    const std::complex<Scalar> park_transform =
-        get_rotation(-q_axis_electrical_angle);
-    const std::complex<Scalar> current_qd =
-        park_transform * clarke_transform(motor.electrical.phase_currents);
+                                 const std::complex<Scalar>& current_qd,
+                                 FocState* foc_state) {
     const Scalar voltage_q = pi_control(
         foc_state->i_controller_params, &foc_state->iq_controller,
         foc_state->period, current_qd.real(), desired_current_qd.real());
@@ -43,3 +32,17 @@ void step_foc_current_controller(const std::complex<Scalar>& desired_current_qd,
         foc_state->period, current_qd.imag(), desired_current_qd.imag());
     foc_state->voltage_qd = {voltage_q, voltage_d};
 }
+
+void unwind_foc_current_controller(const Scalar bus_voltage,
+                                   FocState* foc_state) {
+    const Scalar voltage_qd_norm = std::abs(foc_state->voltage_qd);
+    if (voltage_qd_norm > bus_voltage * kClarkeScale) {
+        const std::complex<Scalar> voltage_qd_saturation =
+            foc_state->voltage_qd *
+            (bus_voltage * kClarkeScale / voltage_qd_norm);
+        pi_unwind(foc_state->i_controller_params, voltage_qd_saturation.real(),
+                  &foc_state->iq_controller);
+        pi_unwind(foc_state->i_controller_params, voltage_qd_saturation.imag(),
+                  &foc_state->id_controller);
+    }
+}
@@ -2,15 +2,22 @@
 
 #include "config/scalar.h"
 #include "foc_state.h"
-#include "simulator/motor_state.h"
+#include <Eigen/Dense>
 #include <complex>
 
-std::complex<Scalar>
-get_desired_current_qd_non_sinusoidal(const Scalar desired_torque,
-                                      const MotorState& motor);
+// park_transform rotates the ab frame into the rotor qd frame
+std::complex<Scalar> get_desired_current_qd_non_sinusoidal(
+    const Scalar desired_torque, const std::complex<Scalar>& park_transform,
+    const Eigen::Matrix<Scalar, 3, 1>& normed_bEmfs);
 
 std::complex<Scalar> get_desired_current_qd(const Scalar desired_torque,
                                             const Scalar normed_bEmf0);
 
 void step_foc_current_controller(const std::complex<Scalar>& desired_current_qd,
-                                 const MotorState& motor, FocState* foc_state);
+                                 const std::complex<Scalar>& current_qd,
+                                 FocState* foc_state);
+
+// anti-windup. when voltage_qd is more than the bus can apply, back
+// calculates the integrators from the saturated voltage
+void unwind_foc_current_controller(const Scalar bus_voltage,
+                                   FocState* foc_state);
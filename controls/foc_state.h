@@ -14,4 +14,7 @@ struct FocState {
 
     // output command
     std::complex<Scalar> voltage_qd;
+
+    // of the last pwm cycle, see get_modulation_index
+    Scalar modulation_index = 0;
 };
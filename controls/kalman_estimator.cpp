@@ -0,0 +1,103 @@
+#include "kalman_estimator.h"
+#include <cmath>
+
+namespace {
+
+// into [-pi, pi], given both angles are in [0, 2pi)
+Scalar wrap_angle_error(const Scalar error) {
+    if (error > kPI) {
+        return error - 2 * kPI;
+    }
+    if (error < -kPI) {
+        return error + 2 * kPI;
+    }
+    return error;
+}
+
+// into [0, 2pi), given the angle moves less than a turn per update
+Scalar wrap_angle(const Scalar angle) {
+    if (angle < 0) {
+        return angle + 2 * kPI;
+    }
+    if (angle >= 2 * kPI) {
+        return angle - 2 * kPI;
+    }
+    return angle;
+}
+
+// predicts the covariance and returns the gain of the measurement, updating
+// the covariance with it
+EstimatorVector step_covariance(const KalmanEstimator& estimator,
+                                EstimatorMatrix* covariance) {
+    *covariance = estimator.transition * *covariance *
+                      estimator.transition.transpose() +
+                  estimator.process_noise;
+    // only the angle is measured, so the innovation is a scalar
+    const EstimatorVector gain =
+        covariance->col(kEstimateAngle) /
+        ((*covariance)(kEstimateAngle, kEstimateAngle) +
+         estimator.measurement_variance);
+    *covariance -= gain * covariance->row(kEstimateAngle);
+    return gain;
+}
+
+} // namespace
+
+void init_kalman_estimator(const KalmanEstimatorParams& params,
+                           const Scalar initial_angle,
+                           KalmanEstimator* estimator) {
+    *estimator = {};
+    const Scalar dt = params.dt;
+    estimator->transition << 1, dt, dt * dt / 2, //
+        0, 1, dt,                                 //
+        0, 0, 1;
+    // white jerk integrated over dt
+    const Scalar dt2 = dt * dt;
+    const Scalar dt3 = dt2 * dt;
+    estimator->process_noise << dt3 * dt2 / 20, dt2 * dt2 / 8, dt3 / 6, //
+        dt2 * dt2 / 8, dt3 / 3, dt2 / 2,                                //
+        dt3 / 6, dt2 / 2, dt;
+    estimator->process_noise *= params.jerk_density;
+    estimator->measurement_variance = params.measurement_variance;
+    estimator->steady_state_gain = params.steady_state_gain;
+
+    estimator->estimate(kEstimateAngle) =
+        initial_angle - 2 * kPI * std::floor(initial_angle / (2 * kPI));
+    estimator->covariance.diagonal() << params.measurement_variance, 1e4, 1e8;
+
+    if (params.steady_state_gain) {
+        // iterate the riccati recursion to its fixed point
+        EstimatorMatrix covariance = estimator->covariance;
+        for (int i = 0; i < 100000; ++i) {
+            const EstimatorVector gain =
+                step_covariance(*estimator, &covariance);
+            const bool converged =
+                (gain - estimator->gain).cwiseAbs().maxCoeff() <=
+                1e-14 * gain.cwiseAbs().maxCoeff();
+            estimator->gain = gain;
+            if (converged) {
+                break;
+            }
+        }
+        estimator->covariance = covariance;
+    }
+}
+
+void step_kalman_estimator(const Scalar measured_angle,
+                           KalmanEstimator* estimator) {
+    if (!estimator->steady_state_gain) {
+        estimator->gain =
+            step_covariance(*estimator, &estimator->covariance);
+    }
+    EstimatorVector& estimate = estimator->estimate;
+    estimate = estimator->transition * estimate;
+    estimate += estimator->gain *
+                wrap_angle_error(measured_angle - estimate(kEstimateAngle));
+    estimate(kEstimateAngle) = wrap_angle(estimate(kEstimateAngle));
+}
+
+Scalar extrapolate_kalman_angle(const KalmanEstimator& estimator,
+                                const Scalar dt) {
+    const EstimatorVector& estimate = estimator.estimate;
+    return wrap_angle(estimate(kEstimateAngle) + estimate(kEstimateVel) * dt);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "config/scalar.h"
+#include "util/math_constants.h"
+#include <Eigen/Dense>
+
+// Rotor angle, velocity and acceleration from a quantized encoder, by a
+// Kalman filter over a constant acceleration model driven by white jerk.
+// Everything is fixed size, and with the steady state gain an update is a
+// handful of multiply adds. The angle is mechanical and wraps in [0, 2pi).
+
+constexpr int kEstimateAngle = 0;
+constexpr int kEstimateVel = 1;
+constexpr int kEstimateAccel = 2;
+
+using EstimatorVector = Eigen::Matrix<Scalar, 3, 1>;
+using EstimatorMatrix = Eigen::Matrix<Scalar, 3, 3>;
+
+struct KalmanEstimatorParams {
+    Scalar dt = 1.0 / 10000; // sec, one update per encoder reading
+    // spectral density of the jerk, (rad/s^3)^2 / Hz. larger tracks
+    // faster, smaller averages away more of the quantization
+    Scalar jerk_density = 1e6;
+    Scalar measurement_variance = 1e-6; // rad^2, see get_encoder_variance
+    // the gain the covariance converges to, precomputed at init, instead of
+    // propagating the covariance every update
+    bool steady_state_gain = true;
+};
+
+struct KalmanEstimator {
+    EstimatorMatrix transition = EstimatorMatrix::Identity();
+    EstimatorMatrix process_noise = EstimatorMatrix::Zero();
+    Scalar measurement_variance = 0;
+    bool steady_state_gain = true;
+    EstimatorVector gain = EstimatorVector::Zero();
+
+    EstimatorVector estimate = EstimatorVector::Zero();
+    EstimatorMatrix covariance = EstimatorMatrix::Zero();
+};
+
+// uniform quantization error of an encoder with this many counts per
+// revolution
+inline Scalar get_encoder_variance(const int counts_per_rev) {
+    const Scalar resolution = 2 * kPI / counts_per_rev;
+    return resolution * resolution / 12;
+}
+
+// Starts at rest at initial_angle. With the steady state gain the filter
+// is converged from the first reading, so a wrong initial_angle decays at
+// the steady state rate. Otherwise the covariance starts wide enough that
+// the first few readings take over.
+void init_kalman_estimator(const KalmanEstimatorParams& params,
+                           const Scalar initial_angle,
+                           KalmanEstimator* estimator);
+
+// predicts over dt, then corrects with the measured angle
+void step_kalman_estimator(const Scalar measured_angle,
+                           KalmanEstimator* estimator);
+
+// the estimated angle dt after the last update, wrapped in [0, 2pi)
+Scalar extrapolate_kalman_angle(const KalmanEstimator& estimator,
+                                const Scalar dt);
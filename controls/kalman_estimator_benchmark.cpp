@@ -0,0 +1,24 @@
+#include "controls/kalman_estimator.h"
+#include "util/math_constants.h"
+#include <benchmark/benchmark.h>
+
+// one update per controller cycle, so this shares the current loop budget
+static void BM_KalmanEstimator(benchmark::State& state) {
+    KalmanEstimatorParams params;
+    params.measurement_variance = get_encoder_variance(4096);
+    params.steady_state_gain = state.range(0);
+    KalmanEstimator estimator;
+    init_kalman_estimator(params, 0, &estimator);
+
+    Scalar angle = 0;
+    for (auto _ : state) {
+        angle += 0.01;
+        if (angle >= 2 * kPI) {
+            angle -= 2 * kPI;
+        }
+        step_kalman_estimator(angle, &estimator);
+        benchmark::DoNotOptimize(estimator.estimate);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_KalmanEstimator)->ArgName("steady_state_gain")->Arg(1)->Arg(0);
@@ -0,0 +1,98 @@
+#include "controls/kalman_estimator.h"
+#include "util/math_constants.h"
+#include "util/quantization.h"
+#include <cmath>
+#include <gtest/gtest.h>
+
+namespace {
+
+constexpr int kEncoderCounts = 4096;
+
+// what a real encoder reports, the middle of the count the angle is in
+Scalar read_encoder(const Scalar angle) {
+    const Scalar resolution = 2 * kPI / kEncoderCounts;
+    const Scalar wrapped = angle - 2 * kPI * std::floor(angle / (2 * kPI));
+    return quantize(resolution, wrapped) + resolution / 2;
+}
+
+KalmanEstimatorParams get_params(const bool steady_state_gain) {
+    KalmanEstimatorParams params;
+    params.measurement_variance = get_encoder_variance(kEncoderCounts);
+    params.steady_state_gain = steady_state_gain;
+    return params;
+}
+
+} // namespace
+
+TEST(kalman_estimator, tracks_constant_velocity) {
+    for (bool steady_state_gain : {true, false}) {
+        const KalmanEstimatorParams params = get_params(steady_state_gain);
+        KalmanEstimator estimator;
+        init_kalman_estimator(params, /*initial_angle=*/1, &estimator);
+
+        // several revolutions, so the angle wraps many times
+        const Scalar vel = 100;
+        Scalar max_vel_error = 0;
+        Scalar max_angle_error = 0;
+        for (int i = 1; i <= 10000; ++i) {
+            const Scalar angle = 1 + vel * i * params.dt;
+            step_kalman_estimator(read_encoder(angle), &estimator);
+            if (i > 2000) {
+                const Scalar angle_error = std::remainder(
+                    estimator.estimate(kEstimateAngle) - angle, 2 * kPI);
+                max_angle_error =
+                    std::max(max_angle_error, std::abs(angle_error));
+                max_vel_error = std::max(
+                    max_vel_error,
+                    std::abs(estimator.estimate(kEstimateVel) - vel));
+            }
+            ASSERT_GE(estimator.estimate(kEstimateAngle), 0);
+            ASSERT_LT(estimator.estimate(kEstimateAngle), 2 * kPI);
+        }
+        // a plain difference of counts would be off by up to
+        // resolution / dt, about 15 rad/s
+        EXPECT_LT(max_vel_error, 1);
+        EXPECT_LT(max_angle_error, 2 * kPI / kEncoderCounts);
+    }
+}
+
+TEST(kalman_estimator, tracks_acceleration) {
+    const KalmanEstimatorParams params = get_params(true);
+    KalmanEstimator estimator;
+    init_kalman_estimator(params, /*initial_angle=*/0, &estimator);
+
+    const Scalar accel = 500;
+    for (int i = 1; i <= 10000; ++i) {
+        const Scalar t = i * params.dt;
+        step_kalman_estimator(read_encoder(accel * t * t / 2), &estimator);
+    }
+    EXPECT_NEAR(estimator.estimate(kEstimateVel), accel * 10000 * params.dt,
+                1);
+    EXPECT_NEAR(estimator.estimate(kEstimateAccel), accel, 50);
+}
+
+TEST(kalman_estimator, extrapolated_angle_wraps) {
+    KalmanEstimator estimator;
+    init_kalman_estimator(get_params(true), 0, &estimator);
+    estimator.estimate(kEstimateAngle) = 2 * kPI - 0.01;
+    estimator.estimate(kEstimateVel) = 100;
+    EXPECT_NEAR(extrapolate_kalman_angle(estimator, 1e-3), 0.09, 1e-12);
+    estimator.estimate(kEstimateAngle) = 0.01;
+    estimator.estimate(kEstimateVel) = -100;
+    EXPECT_NEAR(extrapolate_kalman_angle(estimator, 1e-3), 2 * kPI - 0.09,
+                1e-12);
+}
+
+TEST(kalman_estimator, steady_state_gain_matches_converged_gain) {
+    KalmanEstimator steady;
+    init_kalman_estimator(get_params(true), 0, &steady);
+    KalmanEstimator varying;
+    init_kalman_estimator(get_params(false), 0, &varying);
+    for (int i = 0; i < 20000; ++i) {
+        step_kalman_estimator(0, &varying);
+    }
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_NEAR(varying.gain(i), steady.gain(i),
+                    1e-9 * std::abs(steady.gain(i)));
+    }
+}
@@ -4,18 +4,12 @@
 #include "util/conversions.h"
 #include "util/math_constants.h"
 #include <Eigen/Dense>
-
-const std::array<std::complex<Scalar>, 6> kSvmVectors = []() {
-    std::array<std::complex<Scalar>, 6> result;
-    result[0] = {1, 0};
-    for (int i = 0; i < 6; ++i) {
-        result[i] = {std::cos(i * 2 * kPI / 6), std::sin(i * 2 * kPI / 6)};
-    }
-    return result;
-}();
+#include <algorithm>
+#include <cmath>
 
 int get_sector(const std::complex<Scalar>& voltage_ab) {
-    const std::complex<Scalar> rot_60_deg = std::conj(kSvmVectors[1]);
+    constexpr std::complex<Scalar> rot_60_deg = {kSvmVectors[1].real(),
+                                                 -kSvmVectors[1].imag()};
 
     std::complex<Scalar> curr = voltage_ab;
     std::complex<Scalar> next = voltage_ab * rot_60_deg;
@@ -33,9 +27,170 @@ int get_sector(const std::complex<Scalar>& voltage_ab) {
     return sector;
 }
 
+namespace {
+
+// |voltage_ab| of the six step fundamental
+Scalar get_six_step_voltage(const Scalar bus_voltage) {
+    return kClarkeScale * 3 / kPI * bus_voltage;
+}
+
+// radius of the circle inscribed in the hexagon, the linear limit
+Scalar get_inscribed_voltage(const Scalar bus_voltage) {
+    return kClarkeScale * std::sqrt(3.0) / 2 * bus_voltage;
+}
+
+// Fundamentals below are relative to the inscribed radius.
+
+// fundamental of a circle of radius r clipped to the hexagon. the clipped
+// part follows the sides, from the midpoint out to angle acos(1 / r)
+Scalar get_clipped_fundamental(const Scalar r) {
+    const Scalar clip_angle = std::acos(1 / r);
+    const Scalar clipped =
+        std::log(1 / std::cos(clip_angle) + std::tan(clip_angle));
+    return 6 / kPI * (clipped + r * (kPI / 6 - clip_angle));
+}
+
+// the reference radius whose clipped fundamental is the given one,
+// by newton's method. the slope is the share of the cycle not clipped
+Scalar get_mode_i_radius(const Scalar fundamental) {
+    Scalar r = fundamental;
+    for (int i = 0; i < 8; ++i) {
+        const Scalar slope = 6 / kPI * (kPI / 6 - std::acos(1 / r));
+        r -= (get_clipped_fundamental(r) - fundamental) / slope;
+        r = std::clamp<Scalar>(r, 1, 2 / std::sqrt(3.0));
+    }
+    return r;
+}
+
+constexpr int kNumHoldAngles = 64;
+constexpr Scalar kMaxHoldAngle = kPI / 6;
+
+// fundamental of mode II, holding each active vector for hold_angle on
+// either side and sweeping the hexagon sides in between
+Scalar get_mode_ii_fundamental(const Scalar hold_angle) {
+    // holding the vertex, projected onto the reference
+    const Scalar vertex = 2 / std::sqrt(3.0);
+    Scalar fundamental = vertex * std::sin(hold_angle);
+
+    // sweeping the side, midpoint rule over the rest of the half sector
+    constexpr int kNumSteps = 64;
+    const Scalar step = (kPI / 6 - hold_angle) / kNumSteps;
+    for (int i = 0; i < kNumSteps; ++i) {
+        const Scalar angle = hold_angle + (i + 0.5) * step;
+        const Scalar swept_angle =
+            (angle - hold_angle) / (kPI / 3 - 2 * hold_angle) * (kPI / 3);
+        fundamental += std::cos(swept_angle - angle) /
+                       std::cos(kPI / 6 - swept_angle) * step;
+    }
+    return 6 / kPI * fundamental;
+}
+
+// hold angle by fundamental, from a table over evenly spaced hold angles
+Scalar get_mode_ii_hold_angle(const Scalar fundamental) {
+    static const std::array<Scalar, kNumHoldAngles + 1> fundamentals = [] {
+        std::array<Scalar, kNumHoldAngles + 1> table;
+        for (int i = 0; i <= kNumHoldAngles; ++i) {
+            table[i] = get_mode_ii_fundamental(i * kMaxHoldAngle /
+                                               kNumHoldAngles);
+        }
+        return table;
+    }();
+
+    const auto upper = std::upper_bound(fundamentals.begin(),
+                                        fundamentals.end(), fundamental);
+    if (upper == fundamentals.begin()) {
+        return 0;
+    }
+    if (upper == fundamentals.end()) {
+        return kMaxHoldAngle;
+    }
+    const int i = upper - fundamentals.begin() - 1;
+    const Scalar t = (fundamental - fundamentals[i]) /
+                     (fundamentals[i + 1] - fundamentals[i]);
+    return (i + t) * kMaxHoldAngle / kNumHoldAngles;
+}
+
+// the s7 share that puts phase a on its sinusoidal reference less a sixth
+// of the third harmonic, given its duty with centered zero vectors
+Scalar get_third_harmonic_share(const Scalar bus_voltage,
+                                const std::complex<Scalar>& voltage_ab,
+                                const Scalar centered_duty_a, const Scalar c0) {
+    const Scalar magnitude = std::abs(voltage_ab);
+    if (c0 <= 0 || magnitude == 0) {
+        return 0.5;
+    }
+    const std::complex<Scalar> unit = voltage_ab / magnitude;
+    const Scalar cos_3x = unit.real() * (unit.real() * unit.real() -
+                                         3 * unit.imag() * unit.imag());
+    const Scalar amplitude = kClarkeScale * magnitude / bus_voltage;
+    const Scalar duty_a = 0.5 + amplitude * (unit.real() - cos_3x / 6);
+    return std::clamp<Scalar>(0.5 + (duty_a - centered_duty_a) / c0, 0, 1);
+}
+
+} // namespace
+
+Scalar get_modulation_index(const Scalar bus_voltage,
+                            const std::complex<Scalar>& voltage_ab) {
+    return std::abs(voltage_ab) / get_six_step_voltage(bus_voltage);
+}
+
+std::complex<Scalar>
+get_overmodulated_voltage(const Scalar bus_voltage,
+                          const std::complex<Scalar>& voltage_ab,
+                          const int overmodulation_mode) {
+    const Scalar inscribed_voltage = get_inscribed_voltage(bus_voltage);
+    const Scalar magnitude = std::abs(voltage_ab);
+    if (overmodulation_mode == kOvermodulationClip ||
+        magnitude <= inscribed_voltage) {
+        return voltage_ab;
+    }
+
+    const Scalar fundamental = magnitude / inscribed_voltage;
+    const Scalar max_mode_i_fundamental =
+        get_clipped_fundamental(2 / std::sqrt(3.0));
+    if (overmodulation_mode == kOvermodulationModeI ||
+        fundamental <= max_mode_i_fundamental) {
+        // clipping to the hexagon happens in get_pwm_duties
+        const Scalar radius = get_mode_i_radius(
+            std::min(fundamental, max_mode_i_fundamental));
+        return voltage_ab * (radius / fundamental);
+    }
+
+    // mode II, angle relative to the first vector of the sector
+    const int sector = get_sector(voltage_ab);
+    const std::complex<Scalar> sector_start = kSvmVectors[sector];
+    const Scalar angle = std::arg(voltage_ab * std::conj(sector_start));
+    const Scalar hold_angle = get_mode_ii_hold_angle(fundamental);
+
+    Scalar swept_angle;
+    if (angle < hold_angle) {
+        swept_angle = 0;
+    } else if (angle > kPI / 3 - hold_angle) {
+        swept_angle = kPI / 3;
+    } else {
+        swept_angle =
+            (angle - hold_angle) / (kPI / 3 - 2 * hold_angle) * (kPI / 3);
+    }
+
+    // anywhere beyond the hexagon, clipping brings it onto the side
+    const std::complex<Scalar> swept = {std::cos(swept_angle),
+                                        std::sin(swept_angle)};
+    return 2 * inscribed_voltage *
+           std::complex<Scalar>(
+               sector_start.real() * swept.real() -
+                   sector_start.imag() * swept.imag(),
+               sector_start.real() * swept.imag() +
+                   sector_start.imag() * swept.real());
+}
+
 std::array<Scalar, 3> get_pwm_duties(const Scalar bus_voltage,
-                                     const std::complex<Scalar>& voltage_ab) {
-    const int sector_x = get_sector(voltage_ab);
+                                     const std::complex<Scalar>& voltage_ab,
+                                     const int strategy,
+                                     const int overmodulation_mode) {
+    const std::complex<Scalar> modulated_ab = get_overmodulated_voltage(
+        bus_voltage, voltage_ab, overmodulation_mode);
+
+    const int sector_x = get_sector(modulated_ab);
     const int sector_y = (sector_x + 1) % 6;
 
     const std::complex<Scalar> boundary_x =
@@ -51,7 +206,7 @@ std::array<Scalar, 3> get_pwm_duties(const Scalar bus_voltage,
         // clang-format on
         ;
     Eigen::Matrix<Scalar, 2, 1> v_ab;
-    v_ab << voltage_ab.real(), voltage_ab.imag();
+    v_ab << modulated_ab.real(), modulated_ab.imag();
 
     Eigen::Matrix<Scalar, 2, 1> coeffs = boundaries.inverse() * v_ab;
     Scalar cx = coeffs(0);
@@ -67,9 +222,18 @@ std::array<Scalar, 3> get_pwm_duties(const Scalar bus_voltage,
     const auto& gx = kSvmStates[sector_x];
     const auto& gy = kSvmStates[sector_y];
 
+    Scalar s7_share;
+    if (strategy == kPwmThirdHarmonic) {
+        s7_share = get_third_harmonic_share(bus_voltage, modulated_ab,
+                                            c0 / 2 + gx[0] * cx + gy[0] * cy,
+                                            c0);
+    } else {
+        s7_share = kZeroVectorShare[strategy][sector_x * 2 + (cy > cx)];
+    }
+
     std::array<Scalar, 3> duties;
     for (int i = 0; i < 3; ++i) {
-        duties[i] = c0 / 2 + gx[i] * cx + gy[i] * cy;
+        duties[i] = c0 * s7_share + gx[i] * cx + gy[i] * cy;
     }
     return duties;
 }
@@ -103,5 +267,5 @@ std::complex<Scalar> get_avg_voltage_ab(const Scalar bus_voltage,
         pole_voltages_x * (duties[first_gate_on] - duties[second_gate_on]) +
         pole_voltages_y * (duties[second_gate_on] - duties[third_gate_on]);
 
-    return to_complex<Scalar>(kClarkeTransform2x3 * pole_voltages_avg);
+    return clarke_transform(pole_voltages_avg);
 }
@@ -1,6 +1,11 @@
 #pragma once
 
 #include "config/scalar.h"
+#include "util/clarke_transform.h"
+#include "util/constexpr_math.h"
+#include "util/math_constants.h"
+#include <Eigen/Dense>
+#include <algorithm>
 #include <array>
 #include <complex>
 
@@ -18,12 +23,110 @@ constexpr std::array<std::array<bool, 3>, 6> kSvmStates = {
     // s7 = 1, 1, 1
 };
 
-extern const std::array<std::complex<Scalar>, 6> kSvmVectors;
+namespace svm_internal {
+constexpr std::complex<Scalar> make_svm_vector(const int i) {
+    return {static_cast<Scalar>(constexpr_cos(i * 2 * kPI / 6)),
+            static_cast<Scalar>(constexpr_sin(i * 2 * kPI / 6))};
+}
+} // namespace svm_internal
+
+// unit vectors in the direction of the active states s1..s6
+constexpr std::array<std::complex<Scalar>, 6> kSvmVectors = {
+    svm_internal::make_svm_vector(0), svm_internal::make_svm_vector(1),
+    svm_internal::make_svm_vector(2), svm_internal::make_svm_vector(3),
+    svm_internal::make_svm_vector(4), svm_internal::make_svm_vector(5),
+};
+
+// placement of the zero vectors s0 and s7 within a pwm period
+constexpr int kPwmCentered = 0;      // split equally, conventional SVPWM
+constexpr int kPwmDpwm0 = 1;         // DPWM1 clamping, 30 degrees earlier
+constexpr int kPwmDpwm1 = 2;         // clamp the phase nearest its peak
+constexpr int kPwmDpwm2 = 3;         // DPWM1 clamping, 30 degrees later
+constexpr int kPwmDpwmMin = 4;       // s0 only, lowest phase clamped low
+constexpr int kPwmDpwmMax = 5;       // s7 only, highest phase clamped high
+constexpr int kPwmThirdHarmonic = 6; // sinusoidal + 1/6 third harmonic
+constexpr int kNumPwmStrategies = 7;
+
+constexpr std::array<const char*, kNumPwmStrategies> kPwmStrategyNames = {
+    "Centered", "DPWM0",   "DPWM1",           "DPWM2",
+    "DPWMMIN",  "DPWMMAX", "Third Harmonic",
+};
+
+// handling of voltages beyond the hexagon of the active vectors
+constexpr int kOvermodulationClip = 0;  // scale back onto the hexagon
+constexpr int kOvermodulationModeI = 1; // boost the reference to recover
+                                        // the fundamental lost to clipping
+constexpr int kOvermodulationModeII = 2; // mode I, then hold the active
+                                         // vectors up to six step
+constexpr int kNumOvermodulationModes = 3;
+
+constexpr std::array<const char*, kNumOvermodulationModes>
+    kOvermodulationModeNames = {"Clip", "Mode I", "Mode I/II"};
+
+// share of the zero vector time given to s7, indexed by
+// [strategy][sector * 2 + (closer to the sector's second vector)].
+// kPwmThirdHarmonic has no entry, its share is computed
+constexpr std::array<std::array<Scalar, 12>, kPwmThirdHarmonic>
+    kZeroVectorShare = {{
+        // clang-format off
+        {.5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5}, // centered
+        { 0,  0,  1,  1,  0,  0,  1,  1,  0,  0,  1,  1}, // DPWM0
+        { 1,  0,  0,  1,  1,  0,  0,  1,  1,  0,  0,  1}, // DPWM1
+        { 1,  1,  0,  0,  1,  1,  0,  0,  1,  1,  0,  0}, // DPWM2
+        { 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0}, // DPWMMIN
+        { 1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1}, // DPWMMAX
+        // clang-format on
+    }};
 
 int get_sector(const std::complex<Scalar>& voltage_ab);
 
-std::array<Scalar, 3> get_pwm_duties(const Scalar bus_voltage,
-                                     const std::complex<Scalar>& voltage_ab);
+// fundamental voltage relative to six step operation, which is the most
+// a 3 phase bridge can produce. the linear region ends at pi / sqrt(12)
+Scalar get_modulation_index(const Scalar bus_voltage,
+                            const std::complex<Scalar>& voltage_ab);
+
+// the reference to modulate so that the average over an electrical
+// cycle has the fundamental of voltage_ab, for the kOvermodulation* mode
+std::complex<Scalar>
+get_overmodulated_voltage(const Scalar bus_voltage,
+                          const std::complex<Scalar>& voltage_ab,
+                          const int overmodulation_mode);
+
+std::array<Scalar, 3>
+get_pwm_duties(const Scalar bus_voltage,
+               const std::complex<Scalar>& voltage_ab,
+               const int strategy = kPwmCentered,
+               const int overmodulation_mode = kOvermodulationClip);
 
 std::complex<Scalar> get_avg_voltage_ab(const Scalar bus_voltage,
                                         const std::array<Scalar, 3>& duties);
+
+// Carrier based modulation for any number of phases: sinusoidal references
+// with min-max zero sequence injection, clipped to [0, 1] when
+// overmodulating. In the linear region this gives the same duties as the
+// 3 phase space vector modulation above.
+template <int kNumPhases>
+std::array<Scalar, kNumPhases>
+get_pwm_duties(const Scalar bus_voltage,
+               const std::complex<Scalar>& voltage_ab) {
+    const Eigen::Matrix<Scalar, kNumPhases, 1> references =
+        inverse_clarke_transform<kNumPhases>(voltage_ab) / bus_voltage;
+    const Scalar offset =
+        0.5 - (references.maxCoeff() + references.minCoeff()) / 2;
+
+    std::array<Scalar, kNumPhases> duties;
+    for (int i = 0; i < kNumPhases; ++i) {
+        duties[i] = std::clamp<Scalar>(references(i) + offset, 0, 1);
+    }
+    return duties;
+}
+
+template <size_t kNumPhases>
+std::complex<Scalar>
+get_avg_voltage_ab(const Scalar bus_voltage,
+                   const std::array<Scalar, kNumPhases>& duties) {
+    const Eigen::Matrix<Scalar, kNumPhases, 1> pole_voltages =
+        Eigen::Map<const Eigen::Matrix<Scalar, kNumPhases, 1>>(duties.data()) *
+        bus_voltage;
+    return clarke_transform(pole_voltages);
+}
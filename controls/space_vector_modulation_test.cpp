@@ -129,11 +129,10 @@ TEST(dt_simulation, 0) {
         const auto gates = get_pwm_gate_command(pwm);
 
         Eigen::Matrix<Scalar, 3, 1> pole_voltages;
-        pole_voltages << gates[0], gates[1], gates[2];
+        pole_voltages << (gates & 1), (gates >> 1) & 1, (gates >> 2) & 1;
         pole_voltages *= bus_voltage;
 
-        auto voltage_sv =
-            to_complex<Scalar>(kClarkeTransform2x3 * pole_voltages);
+        auto voltage_sv = clarke_transform(pole_voltages);
         avg += voltage_sv * dt;
 
         time_elapsed += dt;
@@ -143,3 +142,108 @@ TEST(dt_simulation, 0) {
 
     EXPECT_LT(std::norm(avg - target), 1e-3);
 }
+
+TEST(get_pwm_duties, n_phase_matches_svm) {
+    const Scalar bus_voltage = 24;
+    for (Scalar angle = 0; angle < 2 * kPI; angle += 0.1) {
+        const std::complex<Scalar> target =
+            get_rotation(angle) * bus_voltage * 0.5;
+        const std::array<Scalar, 3> svm = get_pwm_duties(bus_voltage, target);
+        const std::array<Scalar, 3> carrier =
+            get_pwm_duties<3>(bus_voltage, target);
+        for (int i = 0; i < 3; ++i) {
+            EXPECT_NEAR(svm[i], carrier[i], 1e-9);
+        }
+    }
+}
+
+TEST(get_pwm_duties, five_phase_average_voltage) {
+    const Scalar bus_voltage = 24;
+    const std::complex<Scalar> target = get_rotation(2.0) * bus_voltage * 0.4;
+    const std::array<Scalar, 5> duties =
+        get_pwm_duties<5>(bus_voltage, target);
+    const std::complex<Scalar> avg = get_avg_voltage_ab(bus_voltage, duties);
+
+    EXPECT_NEAR(avg.real(), target.real(), 1e-9);
+    EXPECT_NEAR(avg.imag(), target.imag(), 1e-9);
+}
+
+TEST(get_pwm_duties, strategies_keep_average_voltage) {
+    const Scalar bus_voltage = 24;
+    for (int strategy = 0; strategy < kNumPwmStrategies; ++strategy) {
+        for (Scalar angle = 0; angle < 2 * kPI; angle += 0.1) {
+            const std::complex<Scalar> target =
+                get_rotation(angle) * bus_voltage * 0.5;
+            const std::array<Scalar, 3> duties =
+                get_pwm_duties(bus_voltage, target, strategy);
+            const std::complex<Scalar> avg =
+                get_avg_voltage_ab(bus_voltage, duties);
+            EXPECT_NEAR(avg.real(), target.real(), 1e-9);
+            EXPECT_NEAR(avg.imag(), target.imag(), 1e-9);
+            for (int i = 0; i < 3; ++i) {
+                EXPECT_GE(duties[i], -1e-12);
+                EXPECT_LE(duties[i], 1 + 1e-12);
+            }
+        }
+    }
+}
+
+TEST(get_pwm_duties, dpwm_clamps_a_phase) {
+    const Scalar bus_voltage = 24;
+    for (int strategy : {kPwmDpwm0, kPwmDpwm1, kPwmDpwm2, kPwmDpwmMin,
+                         kPwmDpwmMax}) {
+        for (Scalar angle = 0.05; angle < 2 * kPI; angle += 0.1) {
+            const std::array<Scalar, 3> duties = get_pwm_duties(
+                bus_voltage, get_rotation(angle) * bus_voltage * 0.5,
+                strategy);
+            const Scalar max_duty =
+                *std::max_element(duties.begin(), duties.end());
+            const Scalar min_duty =
+                *std::min_element(duties.begin(), duties.end());
+            EXPECT_TRUE(std::abs(max_duty - 1) < 1e-9 ||
+                        std::abs(min_duty) < 1e-9);
+        }
+    }
+
+    // DPWM1 clamps phase a high around its peak
+    const std::array<Scalar, 3> duties = get_pwm_duties(
+        bus_voltage, get_rotation(0.2) * bus_voltage * 0.5, kPwmDpwm1);
+    EXPECT_NEAR(duties[0], 1, 1e-9);
+}
+
+TEST(get_pwm_duties, third_harmonic_injection) {
+    const Scalar bus_voltage = 24;
+    const Scalar angle = 0.3;
+    const std::complex<Scalar> target = get_rotation(angle) * bus_voltage * 0.5;
+    const std::array<Scalar, 3> duties =
+        get_pwm_duties(bus_voltage, target, kPwmThirdHarmonic);
+
+    const Scalar amplitude = kClarkeScale * 0.5;
+    EXPECT_NEAR(duties[0],
+                0.5 + amplitude * (std::cos(angle) - std::cos(3 * angle) / 6),
+                1e-9);
+}
+
+TEST(get_overmodulated_voltage, fundamental) {
+    const Scalar bus_voltage = 24;
+    const Scalar six_step_voltage = kClarkeScale * 3 / kPI * bus_voltage;
+
+    // the fundamental of the modulated voltage over a cycle tracks the
+    // request through both overmodulation modes, up to six step
+    for (Scalar modulation_index : {0.93, 0.95, 0.97, 0.99, 1.0}) {
+        const int kNumSteps = 3600;
+        std::complex<Scalar> fundamental = 0;
+        for (int i = 0; i < kNumSteps; ++i) {
+            const std::complex<Scalar> unit =
+                get_rotation(2 * kPI * (i + 0.5) / kNumSteps);
+            const std::complex<Scalar> target =
+                unit * modulation_index * six_step_voltage;
+            const std::complex<Scalar> avg = get_avg_voltage_ab(
+                bus_voltage, get_pwm_duties(bus_voltage, target, kPwmCentered,
+                                            kOvermodulationModeII));
+            fundamental += avg * std::conj(unit) / Scalar(kNumSteps);
+        }
+        EXPECT_NEAR(get_modulation_index(bus_voltage, fundamental),
+                    modulation_index, 1e-3);
+    }
+}
@@ -0,0 +1,88 @@
+// The simulator's own FOC current controller, as a controller plugin.
+// Build it and load it from the Commutation Control tab.
+// bazel build //examples:libfoc_controller_plugin.so
+
+#include "controls/controller_plugin.h"
+#include "controls/foc.h"
+#include "controls/space_vector_modulation.h"
+#include "simulator/motor.h"
+#include "util/clarke_transform.h"
+#include "util/rotation.h"
+#include <new>
+
+namespace {
+
+struct FocController {
+    BiroControllerConfig config;
+    FocState foc;
+};
+
+void* create(const BiroControllerConfig* config) {
+    if (config->normed_bEmf0 == 0) {
+        return nullptr;
+    }
+    // exceptions must not cross the C boundary
+    FocController* controller = new (std::nothrow) FocController;
+    if (controller == nullptr) {
+        return nullptr;
+    }
+    controller->config = *config;
+    controller->foc.period = config->period;
+    controller->foc.i_controller_params =
+        make_motor_pi_params(/*bandwidth=*/10000, config->phase_resistance,
+                             config->phase_inductance);
+    return controller;
+}
+
+void destroy(void* controller) {
+    delete static_cast<FocController*>(controller);
+}
+
+void step(void* controller_ptr, const BiroControllerInputs* inputs,
+          BiroControllerOutputs* outputs) {
+    FocController& controller = *static_cast<FocController*>(controller_ptr);
+
+    const Scalar electrical_angle = get_electrical_angle(
+        controller.config.num_pole_pairs, inputs->rotor_angle);
+    const std::complex<Scalar> park_transform =
+        get_rotation(-(electrical_angle + kQAxisOffset));
+    const std::complex<Scalar> current_qd = abc_to_qd(
+        inputs->phase_currents[0], inputs->phase_currents[1],
+        inputs->phase_currents[2], park_transform);
+
+    step_foc_current_controller(
+        get_desired_current_qd(inputs->desired_torque,
+                               controller.config.normed_bEmf0),
+        current_qd, &controller.foc);
+    unwind_foc_current_controller(inputs->bus_voltage, &controller.foc);
+
+    const std::array<Scalar, 3> duties =
+        get_pwm_duties(inputs->bus_voltage,
+                       std::conj(park_transform) * controller.foc.voltage_qd);
+    outputs->mode = BIRO_CONTROLLER_OUTPUT_DUTIES;
+    for (int i = 0; i < 3; ++i) {
+        outputs->duties[i] = duties[i];
+    }
+}
+
+void step_batch(void* const* controllers, const BiroControllerInputs* inputs,
+                BiroControllerOutputs* outputs, const int32_t count) {
+    // one call across the boundary for all lanes
+    for (int i = 0; i < count; ++i) {
+        step(controllers[i], &inputs[i], &outputs[i]);
+    }
+}
+
+const BiroControllerApi kApi = {
+    /*abi_version=*/BIRO_CONTROLLER_ABI_VERSION,
+    /*struct_size=*/sizeof(BiroControllerApi),
+    /*name=*/"foc",
+    /*create=*/create,
+    /*destroy=*/destroy,
+    /*step=*/step,
+    /*step_batch=*/step_batch,
+};
+
+} // namespace
+
+extern "C" const BiroControllerApi* biro_get_controller_api() { return &kApi; }
@@ -0,0 +1,54 @@
+#include "controls/controller_plugin.h"
+#include "ipc/lockstep_channel.h"
+#include "simulator/controller_plugin_host.h"
+#include <cstdio>
+#include <gflags/gflags.h>
+
+// The controller side of a lockstep co-simulation. Attaches to the channel
+// the simulator created and answers its requests with a controller
+// plugin, which can wrap the firmware control code built for the host.
+// bazel run //ipc:cosim_controller -- --channel biro --plugin libfoc.so
+
+DEFINE_string(channel, "biro", "name the simulator created the channel with");
+DEFINE_string(plugin, "", "shared object implementing controller_plugin.h");
+DEFINE_int32(spin_count, 20000, "polls before sleeping on the futex");
+
+int main(int argc, char* argv[]) {
+    gflags::ParseCommandLineFlags(&argc, &argv, /*remove_flags*/ true);
+
+    LockstepEndpoint endpoint;
+    std::string error;
+    if (!open_lockstep_channel(FLAGS_channel, &endpoint, &error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    endpoint.spin_count = FLAGS_spin_count;
+
+    ControllerPlugin plugin;
+    if (!load_controller_plugin(FLAGS_plugin, endpoint.region->config, &plugin,
+                                &error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        close_lockstep_channel(&endpoint);
+        return 1;
+    }
+    std::printf("serving %s on %s\n", get_controller_plugin_name(*plugin.api),
+                endpoint.memory.name.c_str());
+
+    int64_t num_steps = 0;
+    BiroControllerInputs inputs;
+    while (!endpoint.region->closed.load()) {
+        // the simulator may be paused, keep waiting
+        if (!receive_lockstep_inputs(/*timeout_sec=*/1, &endpoint, &inputs)) {
+            continue;
+        }
+        BiroControllerOutputs outputs = {};
+        plugin.api->step(plugin.controller, &inputs, &outputs);
+        send_lockstep_outputs(outputs, &endpoint);
+        ++num_steps;
+    }
+    std::printf("channel closed after %ld steps\n", long(num_steps));
+
+    unload_controller_plugin(&plugin);
+    close_lockstep_channel(&endpoint);
+    return 0;
+}
@@ -0,0 +1,251 @@
+#include "lockstep_channel.h"
+#include <chrono>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#ifdef __linux__
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+// on one core the peer can not make progress while we poll
+bool is_spinning_useful() {
+    static const bool useful = std::thread::hardware_concurrency() > 1;
+    return useful;
+}
+
+// not FUTEX_PRIVATE, the word is shared between processes
+void futex_wait(std::atomic<uint32_t>* word, const uint32_t value,
+                const double timeout_sec) {
+    timespec timeout;
+    timeout.tv_sec = time_t(timeout_sec);
+    timeout.tv_nsec = long((timeout_sec - timeout.tv_sec) * 1e9);
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, value,
+            &timeout, nullptr, 0);
+}
+
+void futex_wake(std::atomic<uint32_t>* word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE,
+            INT32_MAX, nullptr, nullptr, 0);
+}
+
+// Waits until the word differs from last, returning its value through
+// value. The waiting flag and the word are both sequentially consistent,
+// pairing with publish below, so either the waiter sees the new value or
+// the publisher sees the flag and wakes it.
+bool wait_for_change(std::atomic<uint32_t>* word, const uint32_t last,
+                     std::atomic<uint32_t>* waiting,
+                     const std::atomic<uint32_t>& closed, const int spin_count,
+                     const double timeout_sec, uint32_t* value) {
+    const int num_spins = is_spinning_useful() ? spin_count : 0;
+    for (int i = 0; i < num_spins; ++i) {
+        *value = word->load(std::memory_order_acquire);
+        if (*value != last) {
+            return true;
+        }
+        cpu_relax();
+    }
+
+    const Clock::time_point deadline =
+        Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                           std::chrono::duration<double>(timeout_sec));
+    bool changed = false;
+    while (true) {
+        waiting->store(1);
+        *value = word->load();
+        if (*value != last) {
+            changed = true;
+            break;
+        }
+        const double remaining_sec =
+            std::chrono::duration<double>(deadline - Clock::now()).count();
+        if (closed.load() || remaining_sec <= 0) {
+            break;
+        }
+        futex_wait(word, last, remaining_sec);
+    }
+    waiting->store(0);
+    return changed;
+}
+
+void publish(std::atomic<uint32_t>* word, const uint32_t value,
+             const std::atomic<uint32_t>& waiting) {
+    word->store(value);
+    if (waiting.load()) {
+        futex_wake(word);
+    }
+}
+
+} // namespace
+
+bool create_lockstep_channel(const std::string& name,
+                             const BiroControllerConfig& config,
+                             LockstepEndpoint* endpoint, std::string* error) {
+    *endpoint = {};
+    // fresh shared memory reads as zeros
+    SharedMemory memory;
+    if (!create_shared_memory(name, sizeof(LockstepRegion), &memory, error)) {
+        return false;
+    }
+    LockstepRegion* region = static_cast<LockstepRegion*>(memory.data);
+
+    region->config = config;
+    region->abi_version = BIRO_CONTROLLER_ABI_VERSION;
+    // last, so a controller that sees the magic sees the rest
+    std::atomic_thread_fence(std::memory_order_release);
+    region->magic = kLockstepMagic;
+
+    endpoint->region = region;
+    endpoint->memory = memory;
+    return true;
+}
+
+bool open_lockstep_channel(const std::string& name,
+                           LockstepEndpoint* endpoint, std::string* error) {
+    *endpoint = {};
+    SharedMemory memory;
+    if (!open_shared_memory(name, /*writable=*/true, &memory, error)) {
+        return false;
+    }
+    LockstepRegion* region = static_cast<LockstepRegion*>(memory.data);
+    // the magic is written last: load it, then fence, then read the rest.
+    // smaller objects of the same name are not read past their end
+    const bool has_magic = memory.size >= sizeof(LockstepRegion) &&
+                           region->magic == kLockstepMagic;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!has_magic || region->abi_version != BIRO_CONTROLLER_ABI_VERSION) {
+        *error = memory.name + " is not a lockstep channel of abi version " +
+                 std::to_string(BIRO_CONTROLLER_ABI_VERSION);
+        close_shared_memory(&memory);
+        return false;
+    }
+
+    endpoint->region = region;
+    endpoint->memory = memory;
+    // requests answered so far, any newer one is pending
+    endpoint->seq = region->response_seq.load();
+    return true;
+}
+
+void close_lockstep_channel(LockstepEndpoint* endpoint) {
+    LockstepRegion* region = endpoint->region;
+    if (region == nullptr) {
+        return;
+    }
+    if (endpoint->memory.is_owner) {
+        region->closed.store(1);
+        futex_wake(&region->request_seq);
+    }
+    close_shared_memory(&endpoint->memory);
+    *endpoint = {};
+}
+
+bool exchange_lockstep(const BiroControllerInputs& inputs,
+                       const double timeout_sec, LockstepEndpoint* endpoint,
+                       BiroControllerOutputs* outputs) {
+    LockstepRegion& region = *endpoint->region;
+    const Clock::time_point begin = Clock::now();
+
+    const uint32_t seq = ++endpoint->seq;
+    region.inputs = inputs;
+    publish(&region.request_seq, seq, region.controller_waiting);
+
+    // answers to requests that timed out earlier are skipped
+    uint32_t response_seq = region.response_seq.load();
+    while (response_seq != seq) {
+        const double remaining_sec =
+            timeout_sec -
+            std::chrono::duration<double>(Clock::now() - begin).count();
+        if (!wait_for_change(&region.response_seq, response_seq,
+                             &region.plant_waiting, region.closed,
+                             endpoint->spin_count, remaining_sec,
+                             &response_seq)) {
+            return false;
+        }
+    }
+    *outputs = region.outputs;
+
+    update_online_stats(
+        std::chrono::duration<double, std::micro>(Clock::now() - begin)
+            .count(),
+        &endpoint->round_trip_us);
+    return true;
+}
+
+bool receive_lockstep_inputs(const double timeout_sec,
+                             LockstepEndpoint* endpoint,
+                             BiroControllerInputs* inputs) {
+    LockstepRegion& region = *endpoint->region;
+    uint32_t seq;
+    if (!wait_for_change(&region.request_seq, endpoint->seq,
+                         &region.controller_waiting, region.closed,
+                         endpoint->spin_count, timeout_sec, &seq)) {
+        return false;
+    }
+    endpoint->seq = seq;
+    *inputs = region.inputs;
+    return true;
+}
+
+void send_lockstep_outputs(const BiroControllerOutputs& outputs,
+                           LockstepEndpoint* endpoint) {
+    LockstepRegion& region = *endpoint->region;
+    region.outputs = outputs;
+    publish(&region.response_seq, endpoint->seq, region.plant_waiting);
+}
+
+#else
+
+namespace {
+const char* kUnsupported = "lockstep co-simulation needs linux futexes";
+} // namespace
+
+bool create_lockstep_channel(const std::string& name,
+                             const BiroControllerConfig& config,
+                             LockstepEndpoint* endpoint, std::string* error) {
+    *endpoint = {};
+    *error = kUnsupported;
+    return false;
+}
+
+bool open_lockstep_channel(const std::string& name,
+                           LockstepEndpoint* endpoint, std::string* error) {
+    *endpoint = {};
+    *error = kUnsupported;
+    return false;
+}
+
+void close_lockstep_channel(LockstepEndpoint* endpoint) { *endpoint = {}; }
+
+bool exchange_lockstep(const BiroControllerInputs& inputs,
+                       const double timeout_sec, LockstepEndpoint* endpoint,
+                       BiroControllerOutputs* outputs) {
+    return false;
+}
+
+bool receive_lockstep_inputs(const double timeout_sec,
+                             LockstepEndpoint* endpoint,
+                             BiroControllerInputs* inputs) {
+    return false;
+}
+
+void send_lockstep_outputs(const BiroControllerOutputs& outputs,
+                           LockstepEndpoint* endpoint) {}
+
+#endif
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "analysis/online_stats.h"
+#include "controls/controller_plugin.h"
+#include "shared_memory.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Lockstep co-simulation with a controller in another process. The plant
+// and the controller share a small region of memory holding one request,
+// the controller inputs, and one response, the controller outputs, in the
+// fixed layouts of controls/controller_plugin.h. The plant publishes a
+// request and blocks until the controller answers it, so the two advance
+// together at the controller rate.
+//
+// Each side polls for a while before sleeping on a futex, and the other
+// side only makes the wake syscall when its peer is asleep. With both
+// processes on idle cores a round trip then never enters the kernel.
+
+constexpr uint32_t kLockstepMagic = 0x6c6f636b; // "lock"
+constexpr int kCacheLineSize = 64;
+
+// Layout of the shared region, zero initialized by the plant. Both sides
+// are built from this header, so only append fields.
+struct LockstepRegion {
+    uint32_t magic;
+    uint32_t abi_version; // BIRO_CONTROLLER_ABI_VERSION
+    BiroControllerConfig config;
+    std::atomic<uint32_t> closed; // set by the plant when it goes away
+
+    // written by the plant. the inputs share the line of the sequence so a
+    // request moves between cores in one transfer
+    alignas(kCacheLineSize) std::atomic<uint32_t> request_seq;
+    std::atomic<uint32_t> controller_waiting; // asleep on request_seq
+    BiroControllerInputs inputs;
+
+    // written by the controller, response_seq is the request it answers
+    alignas(kCacheLineSize) std::atomic<uint32_t> response_seq;
+    std::atomic<uint32_t> plant_waiting; // asleep on response_seq
+    BiroControllerOutputs outputs;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "futexes need plain 32 bit words");
+
+struct LockstepEndpoint {
+    LockstepRegion* region = nullptr; // in memory
+    SharedMemory memory; // owned by the plant
+
+    // the plant's last request, or the last request the controller answered
+    uint32_t seq = 0;
+
+    // polls before sleeping, a futex wakeup costs several microseconds.
+    // ignored on a single core
+    int spin_count = 20000;
+
+    // plant side, of each exchange
+    OnlineStats round_trip_us;
+};
+
+// Plant side, creates the named region, replacing any stale one, with the
+// config for the controller. Returns false with the reason in error.
+bool create_lockstep_channel(const std::string& name,
+                             const BiroControllerConfig& config,
+                             LockstepEndpoint* endpoint, std::string* error);
+
+// Controller side, attaches to a region the plant created.
+bool open_lockstep_channel(const std::string& name,
+                           LockstepEndpoint* endpoint, std::string* error);
+
+// The plant also marks the channel closed, waking the controller, and
+// removes the name.
+void close_lockstep_channel(LockstepEndpoint* endpoint);
+
+inline bool is_lockstep_channel_open(const LockstepEndpoint& endpoint) {
+    return endpoint.region != nullptr;
+}
+
+// Plant side, sends the inputs and waits for the controller's outputs.
+// Returns false if the controller does not answer within the timeout.
+bool exchange_lockstep(const BiroControllerInputs& inputs,
+                       const double timeout_sec, LockstepEndpoint* endpoint,
+                       BiroControllerOutputs* outputs);
+
+// Controller side, waits for the next request. Returns false on timeout or
+// when the plant closes the channel.
+bool receive_lockstep_inputs(const double timeout_sec,
+                             LockstepEndpoint* endpoint,
+                             BiroControllerInputs* inputs);
+
+// Controller side, answers the request last received.
+void send_lockstep_outputs(const BiroControllerOutputs& outputs,
+                           LockstepEndpoint* endpoint);
@@ -0,0 +1,54 @@
+#include "ipc/lockstep_channel.h"
+#include <benchmark/benchmark.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+// round trips to a controller thread that answers immediately, so the time
+// is all handshake. with spin_count 0 every handoff sleeps on the futex
+static void BM_LockstepRoundTrip(benchmark::State& state) {
+    const std::string name =
+        "/biro_lockstep_benchmark_" + std::to_string(getpid());
+    LockstepEndpoint plant;
+    std::string error;
+    if (!create_lockstep_channel(name, {}, &plant, &error)) {
+        state.SkipWithError(error.c_str());
+        return;
+    }
+    plant.spin_count = state.range(0);
+
+    std::thread controller_thread([&]() {
+        LockstepEndpoint controller;
+        std::string error;
+        if (!open_lockstep_channel(name, &controller, &error)) {
+            return;
+        }
+        controller.spin_count = state.range(0);
+        BiroControllerInputs inputs;
+        while (receive_lockstep_inputs(/*timeout_sec=*/10, &controller,
+                                       &inputs)) {
+            BiroControllerOutputs outputs = {};
+            outputs.duties[0] = inputs.phase_currents[0];
+            send_lockstep_outputs(outputs, &controller);
+        }
+        close_lockstep_channel(&controller);
+    });
+
+    BiroControllerInputs inputs = {};
+    BiroControllerOutputs outputs;
+    for (auto _ : state) {
+        inputs.phase_currents[0] += 1;
+        if (!exchange_lockstep(inputs, /*timeout_sec=*/10, &plant, &outputs)) {
+            state.SkipWithError("controller did not answer");
+            break;
+        }
+    }
+    state.counters["max_us"] = plant.round_trip_us.max;
+    close_lockstep_channel(&plant);
+    controller_thread.join();
+}
+BENCHMARK(BM_LockstepRoundTrip)
+    ->ArgName("spin_count")
+    ->Arg(0)
+    ->Arg(20000)
+    ->UseRealTime();
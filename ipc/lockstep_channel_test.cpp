@@ -0,0 +1,144 @@
+#include "ipc/lockstep_channel.h"
+#include "ipc/telemetry_feed.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+
+namespace {
+
+std::string get_channel_name(const char* test) {
+    return "/biro_lockstep_test_" + std::string(test) + "_" +
+           std::to_string(getpid());
+}
+
+// answers each request with duties copied from the currents, until the
+// plant closes the channel
+void run_echo_controller(const std::string& name, const int spin_count) {
+    LockstepEndpoint endpoint;
+    std::string error;
+    ASSERT_TRUE(open_lockstep_channel(name, &endpoint, &error)) << error;
+    endpoint.spin_count = spin_count;
+    BiroControllerInputs inputs;
+    while (receive_lockstep_inputs(/*timeout_sec=*/10, &endpoint, &inputs)) {
+        BiroControllerOutputs outputs = {};
+        outputs.mode = BIRO_CONTROLLER_OUTPUT_DUTIES;
+        for (int i = 0; i < 3; ++i) {
+            outputs.duties[i] = inputs.phase_currents[i];
+        }
+        outputs.gates = uint32_t(inputs.time);
+        send_lockstep_outputs(outputs, &endpoint);
+    }
+    close_lockstep_channel(&endpoint);
+}
+
+} // namespace
+
+TEST(lockstep_channel, exchanges_in_order) {
+    // spinning, and sleeping on the futex every time
+    for (int spin_count : {20000, 0}) {
+        const std::string name = get_channel_name("order");
+        BiroControllerConfig config = {};
+        config.period = 1e-4;
+        LockstepEndpoint plant;
+        std::string error;
+        ASSERT_TRUE(create_lockstep_channel(name, config, &plant, &error))
+            << error;
+        plant.spin_count = spin_count;
+        std::thread controller(run_echo_controller, name, spin_count);
+
+        for (int i = 0; i < 1000; ++i) {
+            BiroControllerInputs inputs = {};
+            inputs.time = i;
+            inputs.phase_currents[1] = 0.5 * i;
+            BiroControllerOutputs outputs;
+            ASSERT_TRUE(exchange_lockstep(inputs, /*timeout_sec=*/10, &plant,
+                                          &outputs));
+            ASSERT_EQ(outputs.gates, uint32_t(i));
+            ASSERT_EQ(outputs.duties[1], 0.5 * i);
+        }
+        EXPECT_EQ(plant.round_trip_us.count, 1000);
+
+        close_lockstep_channel(&plant);
+        controller.join();
+    }
+}
+
+TEST(lockstep_channel, controller_sees_config) {
+    const std::string name = get_channel_name("config");
+    BiroControllerConfig config = {};
+    config.num_pole_pairs = 7;
+    LockstepEndpoint plant;
+    std::string error;
+    ASSERT_TRUE(create_lockstep_channel(name, config, &plant, &error));
+
+    LockstepEndpoint controller;
+    ASSERT_TRUE(open_lockstep_channel(name, &controller, &error));
+    EXPECT_EQ(controller.region->config.num_pole_pairs, 7);
+    close_lockstep_channel(&controller);
+    close_lockstep_channel(&plant);
+
+    EXPECT_FALSE(open_lockstep_channel(name, &controller, &error));
+    EXPECT_FALSE(error.empty());
+}
+
+TEST(lockstep_channel, times_out_without_controller) {
+    const std::string name = get_channel_name("timeout");
+    LockstepEndpoint plant;
+    std::string error;
+    ASSERT_TRUE(create_lockstep_channel(name, {}, &plant, &error));
+    plant.spin_count = 100;
+    BiroControllerOutputs outputs;
+    EXPECT_FALSE(exchange_lockstep({}, /*timeout_sec=*/0.01, &plant, &outputs));
+
+    // the late answer to the missed request is skipped
+    std::thread controller(run_echo_controller, name, 100);
+    BiroControllerInputs inputs = {};
+    inputs.time = 5;
+    ASSERT_TRUE(exchange_lockstep(inputs, /*timeout_sec=*/10, &plant,
+                                  &outputs));
+    EXPECT_EQ(outputs.gates, 5u);
+    close_lockstep_channel(&plant);
+    controller.join();
+}
+
+TEST(lockstep_channel, close_wakes_controller) {
+    const std::string name = get_channel_name("close");
+    LockstepEndpoint plant;
+    std::string error;
+    ASSERT_TRUE(create_lockstep_channel(name, {}, &plant, &error));
+
+    // asleep on the futex well within its timeout
+    std::thread controller(run_echo_controller, name, /*spin_count=*/0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const auto begin = std::chrono::steady_clock::now();
+    close_lockstep_channel(&plant);
+    controller.join();
+    EXPECT_LT(std::chrono::steady_clock::now() - begin,
+              std::chrono::seconds(5));
+}
+
+TEST(lockstep_channel, rejects_smaller_objects) {
+    // mapping past the end of the object would raise SIGBUS on access
+    const std::string name = get_channel_name("small");
+    SharedMemory memory;
+    std::string error;
+    ASSERT_TRUE(create_shared_memory(name, 16, &memory, &error)) << error;
+
+    LockstepEndpoint controller;
+    EXPECT_FALSE(open_lockstep_channel(name, &controller, &error));
+    EXPECT_FALSE(is_lockstep_channel_open(controller));
+    close_shared_memory(&memory);
+}
+
+TEST(lockstep_channel, rejects_other_protocols) {
+    // large enough for a region, but a telemetry feed
+    const std::string name = get_channel_name("feed");
+    TelemetryFeedWriter writer;
+    std::string error;
+    ASSERT_TRUE(create_telemetry_feed(name, {"time"}, 1024, &writer, &error))
+        << error;
+
+    LockstepEndpoint controller;
+    EXPECT_FALSE(open_lockstep_channel(name, &controller, &error));
+    close_telemetry_feed(&writer);
+}
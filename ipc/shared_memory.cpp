@@ -0,0 +1,114 @@
+#include "shared_memory.h"
+
+#ifdef __linux__
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+std::string get_shm_name(const std::string& name) {
+    return name.empty() || name[0] != '/' ? "/" + name : name;
+}
+
+std::string get_errno_message(const char* action, const std::string& name) {
+    return std::string(action) + " " + name + ": " + std::strerror(errno);
+}
+
+} // namespace
+
+bool create_shared_memory(const std::string& name, const size_t size,
+                          SharedMemory* memory, std::string* error) {
+    *memory = {};
+    const std::string shm_name = get_shm_name(name);
+    shm_unlink(shm_name.c_str());
+    const int fd = shm_open(shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        *error = get_errno_message("shm_open", shm_name);
+        return false;
+    }
+    if (ftruncate(fd, size) != 0) {
+        *error = get_errno_message("ftruncate", shm_name);
+        close(fd);
+        shm_unlink(shm_name.c_str());
+        return false;
+    }
+    void* data =
+        mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        *error = get_errno_message("mmap", shm_name);
+        shm_unlink(shm_name.c_str());
+        return false;
+    }
+
+    memory->data = data;
+    memory->size = size;
+    memory->name = shm_name;
+    memory->is_owner = true;
+    return true;
+}
+
+bool open_shared_memory(const std::string& name, const bool writable,
+                        SharedMemory* memory, std::string* error) {
+    *memory = {};
+    const std::string shm_name = get_shm_name(name);
+    const int fd = shm_open(shm_name.c_str(), writable ? O_RDWR : O_RDONLY, 0);
+    if (fd < 0) {
+        *error = get_errno_message("shm_open", shm_name);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        *error = get_errno_message("fstat", shm_name);
+        close(fd);
+        return false;
+    }
+    const int protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* data = mmap(nullptr, info.st_size, protection, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        *error = get_errno_message("mmap", shm_name);
+        return false;
+    }
+
+    memory->data = data;
+    memory->size = info.st_size;
+    memory->name = shm_name;
+    return true;
+}
+
+void close_shared_memory(SharedMemory* memory) {
+    if (memory->data == nullptr) {
+        return;
+    }
+    if (memory->is_owner) {
+        shm_unlink(memory->name.c_str());
+    }
+    munmap(memory->data, memory->size);
+    *memory = {};
+}
+
+#else
+
+bool create_shared_memory(const std::string& name, const size_t size,
+                          SharedMemory* memory, std::string* error) {
+    *memory = {};
+    *error = "shared memory needs linux";
+    return false;
+}
+
+bool open_shared_memory(const std::string& name, const bool writable,
+                        SharedMemory* memory, std::string* error) {
+    *memory = {};
+    *error = "shared memory needs linux";
+    return false;
+}
+
+void close_shared_memory(SharedMemory* memory) { *memory = {}; }
+
+#endif
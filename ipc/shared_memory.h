@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Named POSIX shared memory mapped into this process. Names are a single
+// component, a leading slash is added if missing.
+//
+// Like the rest of ipc/, which also relies on futexes and Unix domain
+// sockets, this needs Linux. Elsewhere the functions fail with an error.
+
+struct SharedMemory {
+    void* data = nullptr;
+    size_t size = 0;
+    std::string name; // with the leading slash
+    bool is_owner = false; // created it, removes the name on close
+};
+
+// Creates the named memory, replacing any stale object of that name, and
+// maps it read write. Fresh memory reads as zeros. Returns false with the
+// reason in error.
+bool create_shared_memory(const std::string& name, const size_t size,
+                          SharedMemory* memory, std::string* error);
+
+// Maps all of existing named memory, read only unless writable.
+bool open_shared_memory(const std::string& name, const bool writable,
+                        SharedMemory* memory, std::string* error);
+
+void close_shared_memory(SharedMemory* memory);
+
+inline bool is_shared_memory_open(const SharedMemory& memory) {
+    return memory.data != nullptr;
+}
@@ -0,0 +1,83 @@
+#include "ipc/telemetry_feed.h"
+#include <chrono>
+#include <cstdio>
+#include <gflags/gflags.h>
+#include <sstream>
+#include <thread>
+
+// Prints a live telemetry feed as csv until the writer closes it.
+// bazel run //ipc:tail_telemetry -- --signals time,torque --decimation 100
+
+DEFINE_string(feed, "/biro_telemetry", "name the simulator publishes under");
+DEFINE_string(signals, "", "comma separated signals to print, or all");
+DEFINE_int32(decimation, 1, "prints every nth sample");
+DEFINE_int32(poll_ms, 10, "sleep when caught up");
+
+int main(int argc, char* argv[]) {
+    gflags::ParseCommandLineFlags(&argc, &argv, /*remove_flags*/ true);
+
+    TelemetryFeedReader reader;
+    std::string error;
+    if (!open_telemetry_feed(FLAGS_feed, &reader, &error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    std::vector<int> columns;
+    if (FLAGS_signals.empty()) {
+        for (uint32_t i = 0; i < reader.header->num_signals; ++i) {
+            columns.push_back(i);
+        }
+    } else {
+        std::stringstream names(FLAGS_signals);
+        std::string name;
+        while (std::getline(names, name, ',')) {
+            const int column = find_telemetry_feed_signal(reader, name);
+            if (column < 0) {
+                std::fprintf(stderr, "no signal %s\n", name.c_str());
+                return 1;
+            }
+            columns.push_back(column);
+        }
+    }
+    for (int i = 0; i < int(columns.size()); ++i) {
+        std::printf("%s%s", i > 0 ? ", " : "",
+                    reader.header->signal_names[columns[i]]);
+    }
+    std::printf("\n");
+
+    std::vector<double> values;
+    const int num_signals = reader.header->num_signals;
+    int64_t num_seen = 0;
+    while (true) {
+        // checked first, so the samples before the close are all printed
+        const bool closed = reader.header->closed.load();
+        values.clear();
+        const int num_read = read_telemetry_feed(1024, &reader, &values);
+        for (int s = 0; s < num_read; ++s) {
+            if (num_seen++ % FLAGS_decimation != 0) {
+                continue;
+            }
+            const double* sample = &values[s * num_signals];
+            for (int i = 0; i < int(columns.size()); ++i) {
+                std::printf("%s%g", i > 0 ? ", " : "", sample[columns[i]]);
+            }
+            std::printf("\n");
+        }
+        if (num_read == 0) {
+            if (closed) {
+                break;
+            }
+            std::fflush(stdout);
+            std::this_thread::sleep_for(
+                std::chrono::milliseconds(FLAGS_poll_ms));
+        }
+    }
+
+    if (reader.num_dropped > 0) {
+        std::fprintf(stderr, "dropped %lu samples\n",
+                     (unsigned long)reader.num_dropped);
+    }
+    close_telemetry_feed(&reader);
+    return 0;
+}
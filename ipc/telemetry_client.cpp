@@ -0,0 +1,84 @@
+#include "ipc/telemetry_stream.h"
+#include <cstdio>
+#include <gflags/gflags.h>
+#include <sstream>
+
+// Prints a telemetry stream as csv, with the step index of each sample,
+// until the server goes away.
+// bazel run //ipc:telemetry_client -- --signals time,torque --decimation 10
+
+DEFINE_string(socket, "/tmp/biro_telemetry.sock", "path the server listens on");
+DEFINE_string(signals, "", "comma separated signals to stream, or all");
+DEFINE_int32(decimation, 1, "streams every nth step");
+DEFINE_int32(batch_size, 64, "samples per frame");
+
+int main(int argc, char* argv[]) {
+    gflags::ParseCommandLineFlags(&argc, &argv, /*remove_flags*/ true);
+
+    TelemetryStreamClient client;
+    std::string error;
+    if (!connect_telemetry_stream(FLAGS_socket, &client, &error) ||
+        !wait_for_telemetry_schema(/*timeout_sec=*/5, &client, &error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    std::vector<std::string> names;
+    if (FLAGS_signals.empty()) {
+        names = client.signal_names;
+    } else {
+        std::stringstream list(FLAGS_signals);
+        std::string name;
+        while (std::getline(list, name, ',')) {
+            names.push_back(name);
+        }
+    }
+    TelemetrySubscribePayload subscription = {};
+    subscription.decimation = FLAGS_decimation;
+    subscription.batch_size = FLAGS_batch_size;
+    if (!get_telemetry_signal_mask(names, client,
+                                   &subscription.signal_mask, &error) ||
+        !subscribe_telemetry_stream(subscription, &client, &error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    // columns arrive in schema order
+    std::printf("index");
+    for (int i = 0; i < int(client.signal_names.size()); ++i) {
+        if ((subscription.signal_mask >> i) & 1) {
+            std::printf(", %s", client.signal_names[i].c_str());
+        }
+    }
+    std::printf("\n");
+
+    TelemetryBatch batch;
+    uint64_t num_dropped = 0;
+    while (true) {
+        if (!receive_telemetry_batch(/*timeout_sec=*/1, &client, &batch,
+                                     &error)) {
+            if (error.empty()) {
+                continue; // paused
+            }
+            break;
+        }
+        if (batch.info.num_dropped != num_dropped) {
+            std::fprintf(stderr, "dropped %lu samples, decimation %u\n",
+                         (unsigned long)(batch.info.num_dropped - num_dropped),
+                         batch.info.decimation);
+            num_dropped = batch.info.num_dropped;
+        }
+        for (uint32_t k = 0; k < batch.info.num_samples; ++k) {
+            std::printf("%lu", (unsigned long)(batch.info.first_index +
+                                               k * batch.info.decimation));
+            for (int i = 0; i < batch.num_columns; ++i) {
+                std::printf(", %g", batch.values[k * batch.num_columns + i]);
+            }
+            std::printf("\n");
+        }
+    }
+    std::fprintf(stderr, "%s\n", error.c_str());
+
+    disconnect_telemetry_stream(&client);
+    return 0;
+}
@@ -0,0 +1,134 @@
+#include "telemetry_feed.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+uint32_t round_up_to_power_of_two(const int value) {
+    uint32_t result = 1;
+    while (result < uint32_t(std::max(value, 1))) {
+        result *= 2;
+    }
+    return result;
+}
+
+size_t get_feed_size(const uint32_t num_signals, const uint32_t capacity) {
+    return sizeof(TelemetryFeedHeader) +
+           sizeof(double) * size_t(num_signals) * capacity;
+}
+
+} // namespace
+
+bool create_telemetry_feed(const std::string& name,
+                           const std::vector<std::string>& signal_names,
+                           const int capacity, TelemetryFeedWriter* writer,
+                           std::string* error) {
+    *writer = {};
+    if (signal_names.empty() ||
+        signal_names.size() > kMaxTelemetryFeedSignals) {
+        *error = "a feed has 1 to " +
+                 std::to_string(kMaxTelemetryFeedSignals) + " signals";
+        return false;
+    }
+    const uint32_t num_signals = signal_names.size();
+    const uint32_t ring_capacity = round_up_to_power_of_two(capacity);
+
+    SharedMemory memory;
+    if (!create_shared_memory(name, get_feed_size(num_signals, ring_capacity),
+                              &memory, error)) {
+        return false;
+    }
+
+    TelemetryFeedHeader* header =
+        static_cast<TelemetryFeedHeader*>(memory.data);
+    header->version = kTelemetryFeedVersion;
+    header->num_signals = num_signals;
+    header->capacity = ring_capacity;
+    for (uint32_t i = 0; i < num_signals; ++i) {
+        // fresh memory is zeroed, so the names stay terminated
+        std::strncpy(header->signal_names[i], signal_names[i].c_str(),
+                     kTelemetryFeedNameSize - 1);
+    }
+    // last, so a reader that sees the magic sees the schema
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = kTelemetryFeedMagic;
+
+    writer->header = header;
+    writer->ring = reinterpret_cast<double*>(header + 1);
+    writer->memory = memory;
+    return true;
+}
+
+void close_telemetry_feed(TelemetryFeedWriter* writer) {
+    if (writer->header != nullptr) {
+        writer->header->closed.store(1);
+    }
+    close_shared_memory(&writer->memory);
+    *writer = {};
+}
+
+bool open_telemetry_feed(const std::string& name, TelemetryFeedReader* reader,
+                         std::string* error) {
+    *reader = {};
+    SharedMemory memory;
+    if (!open_shared_memory(name, /*writable=*/false, &memory, error)) {
+        return false;
+    }
+    const TelemetryFeedHeader* header =
+        static_cast<const TelemetryFeedHeader*>(memory.data);
+    // the magic is written last: load it, then fence, then read the rest
+    const bool has_magic = memory.size >= sizeof(TelemetryFeedHeader) &&
+                           header->magic == kTelemetryFeedMagic;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!has_magic || header->version != kTelemetryFeedVersion ||
+        memory.size < get_feed_size(header->num_signals, header->capacity)) {
+        *error = memory.name + " is not a telemetry feed of version " +
+                 std::to_string(kTelemetryFeedVersion);
+        close_shared_memory(&memory);
+        return false;
+    }
+
+    reader->header = header;
+    reader->ring = reinterpret_cast<const double*>(header + 1);
+    reader->memory = memory;
+    const uint64_t end = header->end_count.load(std::memory_order_acquire);
+    reader->next = end > 0 ? end - 1 : 0;
+    return true;
+}
+
+void close_telemetry_feed(TelemetryFeedReader* reader) {
+    close_shared_memory(&reader->memory);
+    *reader = {};
+}
+
+int find_telemetry_feed_signal(const TelemetryFeedReader& reader,
+                               const std::string& name) {
+    for (uint32_t i = 0; i < reader.header->num_signals; ++i) {
+        if (name == reader.header->signal_names[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int read_telemetry_feed(const int max_samples, TelemetryFeedReader* reader,
+                        std::vector<double>* values) {
+    const int num_signals = reader->header->num_signals;
+    int num_read = 0;
+    uint64_t index;
+    while (num_read < max_samples) {
+        const double* sample = peek_telemetry_sample(reader, &index);
+        if (sample == nullptr) {
+            break;
+        }
+        values->insert(values->end(), sample, sample + num_signals);
+        if (!is_telemetry_sample_intact(*reader, index)) {
+            // lapped while copying, the next peek skips ahead
+            values->resize(values->size() - num_signals);
+            ++reader->num_dropped;
+            continue;
+        }
+        ++num_read;
+    }
+    return num_read;
+}
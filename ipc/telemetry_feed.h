@@ -0,0 +1,135 @@
+#pragma once
+
+#include "config/scalar.h"
+#include "shared_memory.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Live telemetry in shared memory. One writer appends fixed width samples
+// of doubles to a ring, and any number of reader processes map the ring
+// read only and tail it in place. The writer never waits for readers, a
+// reader that falls more than a ring behind loses the oldest samples.
+//
+// The writer counts each sample in begin_count before overwriting its slot
+// and in end_count once it is written, a seqlock over the ring. A reader
+// that finds begin_count still within a ring of a sample after reading it
+// knows the slot was not overwritten underneath it.
+
+constexpr uint32_t kTelemetryFeedMagic = 0x66656564; // "feed"
+constexpr uint32_t kTelemetryFeedVersion = 1;
+constexpr int kMaxTelemetryFeedSignals = 64;
+constexpr int kTelemetryFeedNameSize = 32; // with the terminator
+
+// Layout of the start of the region, the ring of samples follows. Readers
+// are built from this header, so bump the version on any change.
+struct TelemetryFeedHeader {
+    uint32_t magic;
+    uint32_t version;
+    // schema, fixed for the life of the feed
+    uint32_t num_signals;
+    uint32_t capacity; // samples in the ring, a power of two
+    char signal_names[kMaxTelemetryFeedSignals][kTelemetryFeedNameSize];
+    std::atomic<uint32_t> closed; // set when the writer goes away
+
+    // samples started and finished, neither ever decreases
+    alignas(64) std::atomic<uint64_t> begin_count;
+    alignas(64) std::atomic<uint64_t> end_count;
+};
+
+static_assert(sizeof(TelemetryFeedHeader) % sizeof(double) == 0,
+              "the ring follows the header");
+
+struct TelemetryFeedWriter {
+    TelemetryFeedHeader* header = nullptr; // in memory
+    double* ring = nullptr;
+    SharedMemory memory;
+};
+
+struct TelemetryFeedReader {
+    const TelemetryFeedHeader* header = nullptr; // in memory
+    const double* ring = nullptr;
+    SharedMemory memory;
+
+    uint64_t next = 0; // index of the next sample to read
+    uint64_t num_dropped = 0; // overwritten before they were read
+};
+
+// Creates the named feed, replacing any stale one, with room for capacity
+// samples, rounded up to a power of two. Names longer than the schema
+// allows are truncated. Returns false with the reason in error.
+bool create_telemetry_feed(const std::string& name,
+                           const std::vector<std::string>& signal_names,
+                           const int capacity, TelemetryFeedWriter* writer,
+                           std::string* error);
+
+// The writer also marks the feed closed and removes the name, mapped
+// readers keep their view.
+void close_telemetry_feed(TelemetryFeedWriter* writer);
+
+inline bool is_telemetry_feed_open(const TelemetryFeedWriter& writer) {
+    return writer.header != nullptr;
+}
+
+// appends one sample of num_signals values
+inline void publish_telemetry_sample(const Scalar* values,
+                                     TelemetryFeedWriter* writer) {
+    TelemetryFeedHeader& header = *writer->header;
+    const uint64_t index = header.end_count.load(std::memory_order_relaxed);
+    header.begin_count.store(index + 1, std::memory_order_relaxed);
+    // orders the count before the slot writes, for readers checking it
+    std::atomic_thread_fence(std::memory_order_release);
+    double* slot =
+        writer->ring + (index & (header.capacity - 1)) * header.num_signals;
+    for (uint32_t i = 0; i < header.num_signals; ++i) {
+        slot[i] = values[i];
+    }
+    header.end_count.store(index + 1, std::memory_order_release);
+}
+
+// Maps the named feed read only and starts at its newest sample.
+bool open_telemetry_feed(const std::string& name, TelemetryFeedReader* reader,
+                         std::string* error);
+
+void close_telemetry_feed(TelemetryFeedReader* reader);
+
+// index of the signal with this name, or -1
+int find_telemetry_feed_signal(const TelemetryFeedReader& reader,
+                               const std::string& name);
+
+// Zero copy reads. Returns the sample at reader->next in the ring and
+// advances, or nullptr when caught up. Samples overwritten before they
+// were reached are skipped and counted in num_dropped. The values may be
+// overwritten while in use, confirm with is_telemetry_sample_intact after
+// reading them.
+inline const double* peek_telemetry_sample(TelemetryFeedReader* reader,
+                                           uint64_t* index) {
+    const TelemetryFeedHeader& header = *reader->header;
+    const uint64_t end = header.end_count.load(std::memory_order_acquire);
+    if (reader->next >= end) {
+        return nullptr;
+    }
+    if (end - reader->next > header.capacity) {
+        reader->num_dropped += end - header.capacity - reader->next;
+        reader->next = end - header.capacity;
+    }
+    *index = reader->next++;
+    return reader->ring +
+           (*index & (header.capacity - 1)) * header.num_signals;
+}
+
+// whether sample index was left alone while it was read
+inline bool is_telemetry_sample_intact(const TelemetryFeedReader& reader,
+                                       const uint64_t index) {
+    // orders the reads of the slot before the count
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t begin =
+        reader.header->begin_count.load(std::memory_order_relaxed);
+    return begin <= index + reader.header->capacity;
+}
+
+// Copies out the samples not yet read, up to max_samples, appending
+// num_signals values per sample. Returns the number copied.
+int read_telemetry_feed(const int max_samples, TelemetryFeedReader* reader,
+                        std::vector<double>* values);
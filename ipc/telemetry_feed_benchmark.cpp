@@ -0,0 +1,25 @@
+#include "ipc/telemetry_feed.h"
+#include <benchmark/benchmark.h>
+#include <string>
+#include <unistd.h>
+
+// the cost the simulator pays per step, with the width of its telemetry
+static void BM_PublishTelemetrySample(benchmark::State& state) {
+    const std::string name = "/biro_feed_benchmark_" + std::to_string(getpid());
+    const int num_signals = state.range(0);
+    TelemetryFeedWriter writer;
+    std::string error;
+    if (!create_telemetry_feed(name,
+                               std::vector<std::string>(num_signals, "x"),
+                               1 << 16, &writer, &error)) {
+        state.SkipWithError(error.c_str());
+        return;
+    }
+    std::vector<Scalar> values(num_signals, 1.0);
+    for (auto _ : state) {
+        publish_telemetry_sample(values.data(), &writer);
+        benchmark::ClobberMemory();
+    }
+    close_telemetry_feed(&writer);
+}
+BENCHMARK(BM_PublishTelemetrySample)->Arg(8)->Arg(30)->Arg(64);
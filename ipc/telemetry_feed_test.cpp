@@ -0,0 +1,121 @@
+#include "ipc/telemetry_feed.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+std::string get_feed_name(const char* test) {
+    return "/biro_feed_test_" + std::string(test) + "_" +
+           std::to_string(getpid());
+}
+
+void publish_counting(const int count, const int num_signals,
+                      TelemetryFeedWriter* writer) {
+    std::vector<Scalar> values(num_signals);
+    for (int i = 0; i < count; ++i) {
+        const uint64_t index = writer->header->end_count.load();
+        std::fill(values.begin(), values.end(), Scalar(index));
+        publish_telemetry_sample(values.data(), writer);
+    }
+}
+
+} // namespace
+
+TEST(telemetry_feed, reader_sees_schema) {
+    const std::string name = get_feed_name("schema");
+    TelemetryFeedWriter writer;
+    std::string error;
+    ASSERT_TRUE(create_telemetry_feed(name, {"time", "torque"}, 100, &writer,
+                                      &error))
+        << error;
+    EXPECT_EQ(writer.header->capacity, 128u);
+
+    TelemetryFeedReader reader;
+    ASSERT_TRUE(open_telemetry_feed(name, &reader, &error)) << error;
+    EXPECT_EQ(reader.header->num_signals, 2u);
+    EXPECT_EQ(find_telemetry_feed_signal(reader, "torque"), 1);
+    EXPECT_EQ(find_telemetry_feed_signal(reader, "speed"), -1);
+
+    EXPECT_FALSE(reader.header->closed.load());
+    close_telemetry_feed(&writer);
+    // mapped readers keep their view
+    EXPECT_TRUE(reader.header->closed.load());
+    EXPECT_EQ(find_telemetry_feed_signal(reader, "time"), 0);
+    close_telemetry_feed(&reader);
+    EXPECT_FALSE(open_telemetry_feed(name, &reader, &error));
+}
+
+TEST(telemetry_feed, tails_in_order) {
+    const std::string name = get_feed_name("order");
+    TelemetryFeedWriter writer;
+    std::string error;
+    ASSERT_TRUE(create_telemetry_feed(name, {"a", "b", "c"}, 16, &writer,
+                                      &error));
+    TelemetryFeedReader reader;
+    ASSERT_TRUE(open_telemetry_feed(name, &reader, &error));
+
+    publish_counting(10, 3, &writer);
+    std::vector<double> values;
+    EXPECT_EQ(read_telemetry_feed(4, &reader, &values), 4);
+    EXPECT_EQ(read_telemetry_feed(100, &reader, &values), 6);
+    ASSERT_EQ(values.size(), 30u);
+    for (int i = 0; i < 30; ++i) {
+        EXPECT_EQ(values[i], i / 3);
+    }
+    EXPECT_EQ(reader.num_dropped, 0u);
+
+    close_telemetry_feed(&reader);
+    close_telemetry_feed(&writer);
+}
+
+TEST(telemetry_feed, slow_reader_drops_oldest) {
+    const std::string name = get_feed_name("drop");
+    TelemetryFeedWriter writer;
+    std::string error;
+    ASSERT_TRUE(create_telemetry_feed(name, {"a"}, 8, &writer, &error));
+    TelemetryFeedReader reader;
+    ASSERT_TRUE(open_telemetry_feed(name, &reader, &error));
+
+    publish_counting(20, 1, &writer);
+    std::vector<double> values;
+    EXPECT_EQ(read_telemetry_feed(100, &reader, &values), 8);
+    EXPECT_EQ(reader.num_dropped, 12u);
+    EXPECT_EQ(values.front(), 12);
+    EXPECT_EQ(values.back(), 19);
+
+    close_telemetry_feed(&reader);
+    close_telemetry_feed(&writer);
+}
+
+TEST(telemetry_feed, concurrent_reads_are_never_torn) {
+    const std::string name = get_feed_name("torn");
+    constexpr int kNumSignals = 30;
+    TelemetryFeedWriter writer;
+    std::string error;
+    ASSERT_TRUE(create_telemetry_feed(
+        name, std::vector<std::string>(kNumSignals, "x"), 4, &writer,
+        &error));
+    TelemetryFeedReader reader;
+    ASSERT_TRUE(open_telemetry_feed(name, &reader, &error));
+
+    // a tiny ring, so the writer laps the reader constantly
+    std::thread writer_thread(publish_counting, 200000, kNumSignals, &writer);
+    int64_t num_read = 0;
+    std::vector<double> values;
+    while (reader.next < 200000) {
+        values.clear();
+        num_read += read_telemetry_feed(64, &reader, &values);
+        for (int i = 0; i < int(values.size()); i += kNumSignals) {
+            for (int j = 1; j < kNumSignals; ++j) {
+                ASSERT_EQ(values[i + j], values[i]);
+            }
+        }
+    }
+    writer_thread.join();
+    EXPECT_EQ(num_read + reader.num_dropped, 200000);
+
+    close_telemetry_feed(&reader);
+    close_telemetry_feed(&writer);
+}
@@ -0,0 +1,623 @@
+#include "telemetry_stream.h"
+#include <algorithm>
+#include <bitset>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#ifdef __linux__
+
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint32_t kMaxBackpressureDecimation = 1 << 12;
+constexpr uint32_t kDefaultBatchSize = 64;
+constexpr uint32_t kMaxBatchSize = 4096;
+
+std::string get_errno_message(const char* action, const std::string& path) {
+    return std::string(action) + " " + path + ": " + std::strerror(errno);
+}
+
+bool get_socket_address(const std::string& path, sockaddr_un* address,
+                        std::string* error) {
+    *address = {};
+    address->sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address->sun_path)) {
+        *error = "socket path must be 1 to " +
+                 std::to_string(sizeof(address->sun_path) - 1) + " bytes";
+        return false;
+    }
+    std::memcpy(address->sun_path, path.c_str(), path.size());
+    return true;
+}
+
+// A socket file is stale when nothing listens on it any more, connecting
+// is then refused. Returns false with the reason in error when a server
+// answers, or the probe itself fails.
+bool is_stale_socket(const std::string& path, const sockaddr_un& address,
+                     std::string* error) {
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                          0);
+    if (fd < 0) {
+        *error = get_errno_message("socket", path);
+        return false;
+    }
+    const bool connected =
+        connect(fd, reinterpret_cast<const sockaddr*>(&address),
+                sizeof(address)) == 0;
+    const int connect_errno = errno;
+    close(fd);
+    // a full backlog also means a live server
+    if (connected || connect_errno == EAGAIN) {
+        *error = path + " is in use by a running server";
+        return false;
+    }
+    if (connect_errno != ECONNREFUSED) {
+        errno = connect_errno;
+        *error = get_errno_message("connect", path);
+        return false;
+    }
+    return true;
+}
+
+int count_signals(const uint64_t mask) { return std::bitset<64>(mask).count(); }
+
+// appends the header, returns where the payload goes
+char* append_frame(const uint32_t type, const size_t payload_size,
+                   std::vector<char>* out) {
+    TelemetryFrameHeader header = {};
+    header.magic = kTelemetryStreamMagic;
+    header.type = type;
+    header.payload_size = payload_size;
+    const size_t offset = out->size();
+    out->resize(offset + sizeof(header) + payload_size);
+    std::memcpy(out->data() + offset, &header, sizeof(header));
+    return out->data() + offset + sizeof(header);
+}
+
+// Takes the first whole frame off the inbox. Returns false if there is
+// none yet, or with malformed set if the stream is corrupt. Frames larger
+// than max_payload_size count as corrupt, before their payload arrives.
+bool pop_frame(const size_t max_payload_size, std::vector<char>* inbox,
+               TelemetryFrameHeader* header, std::vector<char>* payload,
+               bool* malformed) {
+    *malformed = false;
+    if (inbox->size() < sizeof(TelemetryFrameHeader)) {
+        return false;
+    }
+    std::memcpy(header, inbox->data(), sizeof(*header));
+    if (header->magic != kTelemetryStreamMagic ||
+        header->payload_size > max_payload_size) {
+        *malformed = true;
+        return false;
+    }
+    const size_t frame_size = sizeof(*header) + header->payload_size;
+    if (inbox->size() < frame_size) {
+        return false;
+    }
+    payload->assign(inbox->begin() + sizeof(*header),
+                    inbox->begin() + frame_size);
+    inbox->erase(inbox->begin(), inbox->begin() + frame_size);
+    return true;
+}
+
+// sends what the socket takes, returns false if the client is gone
+bool flush_outbox(TelemetrySubscriber* subscriber) {
+    bool is_connected = true;
+    while (subscriber->outbox_sent < subscriber->outbox.size()) {
+        const ssize_t num_sent = send(
+            subscriber->fd, subscriber->outbox.data() + subscriber->outbox_sent,
+            get_subscriber_queued_bytes(*subscriber),
+            MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (num_sent < 0) {
+            is_connected =
+                errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+            break;
+        }
+        subscriber->outbox_sent += num_sent;
+    }
+    // a client that never catches up never empties the outbox, so the sent
+    // bytes are dropped once they are half of it. the outbox then holds at
+    // most twice the queued bytes, and moves no more bytes than were sent
+    std::vector<char>& outbox = subscriber->outbox;
+    if (subscriber->outbox_sent * 2 >= outbox.size()) {
+        outbox.erase(outbox.begin(), outbox.begin() + subscriber->outbox_sent);
+        subscriber->outbox_sent = 0;
+    }
+    return is_connected;
+}
+
+// frames the batch, or drops it if the client is too far behind
+void finish_batch(const size_t max_queued_bytes,
+                  TelemetrySubscriber* subscriber) {
+    if (subscriber->batch_count == 0) {
+        return;
+    }
+    const size_t payload_size = sizeof(TelemetrySamplesPayload) +
+                                sizeof(double) * subscriber->batch.size();
+    if (get_subscriber_queued_bytes(*subscriber) + payload_size >
+        max_queued_bytes) {
+        subscriber->num_dropped += subscriber->batch_count;
+        subscriber->decimation =
+            std::min(subscriber->decimation * 2, kMaxBackpressureDecimation);
+    } else {
+        TelemetrySamplesPayload info = {};
+        info.first_index = subscriber->batch_first_index;
+        info.signal_mask = subscriber->subscription.signal_mask;
+        info.num_samples = subscriber->batch_count;
+        info.decimation = subscriber->decimation;
+        info.num_dropped = subscriber->num_dropped;
+        char* payload = append_frame(kTelemetryFrameSamples, payload_size,
+                                     &subscriber->outbox);
+        std::memcpy(payload, &info, sizeof(info));
+        std::memcpy(payload + sizeof(info), subscriber->batch.data(),
+                    sizeof(double) * subscriber->batch.size());
+    }
+    subscriber->batch.clear();
+    subscriber->batch_count = 0;
+}
+
+void apply_subscription(const TelemetrySubscribePayload& subscription,
+                        const size_t max_queued_bytes,
+                        TelemetrySubscriber* subscriber) {
+    // the pending samples belong to the old subscription
+    finish_batch(max_queued_bytes, subscriber);
+    subscriber->subscription = subscription;
+    subscriber->subscription.decimation =
+        std::max<uint32_t>(subscription.decimation, 1);
+    subscriber->subscription.batch_size =
+        subscription.batch_size == 0
+            ? kDefaultBatchSize
+            : std::min(subscription.batch_size, kMaxBatchSize);
+    subscriber->decimation = subscriber->subscription.decimation;
+}
+
+// Applies the whole frames in the client's inbox. Clients only send
+// subscriptions, anything else is malformed. Returns false if it is.
+bool apply_subscriber_frames(const int num_signals,
+                             const size_t max_queued_bytes,
+                             TelemetrySubscriber* subscriber) {
+    TelemetryFrameHeader header;
+    std::vector<char> payload;
+    bool malformed;
+    while (pop_frame(sizeof(TelemetrySubscribePayload), &subscriber->inbox,
+                     &header, &payload, &malformed)) {
+        if (header.type != kTelemetryFrameSubscribe ||
+            payload.size() != sizeof(TelemetrySubscribePayload)) {
+            return false;
+        }
+        TelemetrySubscribePayload subscription;
+        std::memcpy(&subscription, payload.data(), sizeof(subscription));
+        // signals past the schema do not exist
+        if (num_signals < kMaxTelemetryStreamSignals) {
+            subscription.signal_mask &= (uint64_t(1) << num_signals) - 1;
+        }
+        apply_subscription(subscription, max_queued_bytes, subscriber);
+    }
+    return !malformed;
+}
+
+// Reads the client's frames, returns false if the client is gone or sent
+// a malformed frame. Frames are applied as each read arrives, so the inbox
+// never holds more than a read and a partial frame.
+bool read_subscriber(const int num_signals, const size_t max_queued_bytes,
+                     TelemetrySubscriber* subscriber) {
+    char buffer[4096];
+    while (true) {
+        const ssize_t num_read =
+            recv(subscriber->fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (num_read == 0) {
+            return false;
+        }
+        if (num_read < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+        subscriber->inbox.insert(subscriber->inbox.end(), buffer,
+                                 buffer + num_read);
+        if (!apply_subscriber_frames(num_signals, max_queued_bytes,
+                                     subscriber)) {
+            return false;
+        }
+    }
+}
+
+void queue_schema(const std::vector<std::string>& signal_names,
+                  TelemetrySubscriber* subscriber) {
+    TelemetrySchemaPayload schema = {};
+    schema.num_signals = signal_names.size();
+    char* payload = append_frame(
+        kTelemetryFrameSchema,
+        sizeof(schema) + kTelemetryStreamNameSize * signal_names.size(),
+        &subscriber->outbox);
+    std::memcpy(payload, &schema, sizeof(schema));
+    char* names = payload + sizeof(schema);
+    for (const std::string& name : signal_names) {
+        std::strncpy(names, name.c_str(), kTelemetryStreamNameSize - 1);
+        names += kTelemetryStreamNameSize;
+    }
+}
+
+} // namespace
+
+bool start_telemetry_server(const std::string& path,
+                            const std::vector<std::string>& signal_names,
+                            TelemetryServer* server, std::string* error) {
+    *server = {};
+    if (signal_names.empty() ||
+        signal_names.size() > kMaxTelemetryStreamSignals) {
+        *error = "a stream has 1 to " +
+                 std::to_string(kMaxTelemetryStreamSignals) + " signals";
+        return false;
+    }
+    sockaddr_un address;
+    if (!get_socket_address(path, &address, error)) {
+        return false;
+    }
+
+    // a stale socket is replaced, anything else at the path is left alone
+    struct stat existing;
+    if (lstat(path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            *error = path + " exists and is not a socket";
+            return false;
+        }
+        if (!is_stale_socket(path, address, error)) {
+            return false;
+        }
+        unlink(path.c_str());
+    }
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                          0);
+    if (fd < 0) {
+        *error = get_errno_message("socket", path);
+        return false;
+    }
+    if (bind(fd, reinterpret_cast<const sockaddr*>(&address),
+             sizeof(address)) != 0) {
+        *error = get_errno_message("bind", path);
+        close(fd);
+        return false;
+    }
+    if (listen(fd, /*backlog=*/8) != 0) {
+        *error = get_errno_message("listen", path);
+        close(fd);
+        unlink(path.c_str());
+        return false;
+    }
+
+    server->listen_fd = fd;
+    server->path = path;
+    server->signal_names = signal_names;
+    return true;
+}
+
+void stop_telemetry_server(TelemetryServer* server) {
+    if (server->listen_fd < 0) {
+        return;
+    }
+    for (TelemetrySubscriber& subscriber : server->subscribers) {
+        close(subscriber.fd);
+    }
+    close(server->listen_fd);
+    unlink(server->path.c_str());
+    *server = {};
+}
+
+void publish_telemetry_stream_sample(const Scalar* values,
+                                     TelemetryServer* server) {
+    const uint64_t index = server->sample_index++;
+    for (TelemetrySubscriber& subscriber : server->subscribers) {
+        const uint64_t mask = subscriber.subscription.signal_mask;
+        if (mask == 0 || index % subscriber.decimation != 0) {
+            continue;
+        }
+        if (subscriber.batch_count == 0) {
+            subscriber.batch_first_index = index;
+        }
+        for (int i = 0; i < kMaxTelemetryStreamSignals; ++i) {
+            if ((mask >> i) & 1) {
+                subscriber.batch.push_back(values[i]);
+            }
+        }
+        if (++subscriber.batch_count >=
+            subscriber.subscription.batch_size) {
+            finish_batch(server->max_queued_bytes, &subscriber);
+        }
+    }
+}
+
+void poll_telemetry_server(TelemetryServer* server) {
+    if (server->listen_fd < 0) {
+        return;
+    }
+    while (true) {
+        const int fd =
+            accept4(server->listen_fd, nullptr, nullptr,
+                    SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            break;
+        }
+        TelemetrySubscriber subscriber;
+        subscriber.fd = fd;
+        queue_schema(server->signal_names, &subscriber);
+        server->subscribers.push_back(std::move(subscriber));
+    }
+
+    std::vector<TelemetrySubscriber>& subscribers = server->subscribers;
+    for (int i = 0; i < int(subscribers.size());) {
+        TelemetrySubscriber& subscriber = subscribers[i];
+        bool alive = read_subscriber(server->signal_names.size(),
+                                     server->max_queued_bytes, &subscriber);
+        alive = alive && flush_outbox(&subscriber);
+        // caught up, ease the decimation back a step
+        if (alive && subscriber.outbox.empty() &&
+            subscriber.decimation > subscriber.subscription.decimation) {
+            finish_batch(server->max_queued_bytes, &subscriber);
+            subscriber.decimation =
+                std::max(subscriber.decimation / 2,
+                         subscriber.subscription.decimation);
+        }
+        if (!alive) {
+            close(subscriber.fd);
+            subscribers.erase(subscribers.begin() + i);
+            continue;
+        }
+        ++i;
+    }
+}
+
+namespace {
+
+// Waits for the next whole frame from the server. Returns false on
+// timeout, with error empty, or on disconnect.
+bool read_frame(const double timeout_sec, TelemetryStreamClient* client,
+                TelemetryFrameHeader* header, std::vector<char>* payload,
+                std::string* error) {
+    error->clear();
+    const Clock::time_point deadline =
+        Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                           std::chrono::duration<double>(timeout_sec));
+    while (true) {
+        bool malformed;
+        // the server is trusted, its frames only need to fit in memory
+        if (pop_frame(SIZE_MAX, &client->inbox, header, payload,
+                      &malformed)) {
+            return true;
+        }
+        if (malformed) {
+            *error = "malformed frame from the server";
+            return false;
+        }
+
+        const double remaining_ms =
+            std::chrono::duration<double, std::milli>(deadline - Clock::now())
+                .count();
+        pollfd request = {client->fd, POLLIN, 0};
+        if (remaining_ms <= 0 ||
+            poll(&request, 1, int(std::ceil(remaining_ms))) == 0) {
+            return false;
+        }
+        char buffer[1 << 16];
+        const ssize_t num_read = recv(client->fd, buffer, sizeof(buffer), 0);
+        if (num_read <= 0) {
+            *error = "server closed the stream";
+            return false;
+        }
+        client->inbox.insert(client->inbox.end(), buffer, buffer + num_read);
+    }
+}
+
+void read_schema(const std::vector<char>& payload,
+                 TelemetryStreamClient* client) {
+    TelemetrySchemaPayload schema;
+    if (payload.size() < sizeof(schema)) {
+        return;
+    }
+    std::memcpy(&schema, payload.data(), sizeof(schema));
+    const size_t num_signals =
+        std::min<size_t>(schema.num_signals,
+                         (payload.size() - sizeof(schema)) /
+                             kTelemetryStreamNameSize);
+    client->signal_names.clear();
+    for (size_t i = 0; i < num_signals; ++i) {
+        const char* name =
+            payload.data() + sizeof(schema) + i * kTelemetryStreamNameSize;
+        client->signal_names.emplace_back(
+            name, strnlen(name, kTelemetryStreamNameSize));
+    }
+}
+
+} // namespace
+
+bool connect_telemetry_stream(const std::string& path,
+                              TelemetryStreamClient* client,
+                              std::string* error) {
+    *client = {};
+    sockaddr_un address;
+    if (!get_socket_address(path, &address, error)) {
+        return false;
+    }
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        *error = get_errno_message("socket", path);
+        return false;
+    }
+    if (connect(fd, reinterpret_cast<const sockaddr*>(&address),
+                sizeof(address)) != 0) {
+        *error = get_errno_message("connect", path);
+        close(fd);
+        return false;
+    }
+    client->fd = fd;
+    return true;
+}
+
+void disconnect_telemetry_stream(TelemetryStreamClient* client) {
+    if (client->fd >= 0) {
+        close(client->fd);
+    }
+    *client = {};
+}
+
+bool wait_for_telemetry_schema(const double timeout_sec,
+                               TelemetryStreamClient* client,
+                               std::string* error) {
+    TelemetryFrameHeader header;
+    std::vector<char> payload;
+    while (client->signal_names.empty()) {
+        if (!read_frame(timeout_sec, client, &header, &payload, error)) {
+            if (error->empty()) {
+                *error = "no schema from the server";
+            }
+            return false;
+        }
+        if (header.type == kTelemetryFrameSchema) {
+            read_schema(payload, client);
+        }
+    }
+    return true;
+}
+
+bool get_telemetry_signal_mask(const std::vector<std::string>& names,
+                               const TelemetryStreamClient& client,
+                               uint64_t* mask, std::string* error) {
+    *mask = 0;
+    for (const std::string& name : names) {
+        const auto found = std::find(client.signal_names.begin(),
+                                     client.signal_names.end(), name);
+        if (found == client.signal_names.end()) {
+            *error = "no signal " + name;
+            return false;
+        }
+        *mask |= uint64_t(1) << (found - client.signal_names.begin());
+    }
+    return true;
+}
+
+bool subscribe_telemetry_stream(const TelemetrySubscribePayload& subscription,
+                                TelemetryStreamClient* client,
+                                std::string* error) {
+    std::vector<char> frame;
+    std::memcpy(append_frame(kTelemetryFrameSubscribe, sizeof(subscription),
+                             &frame),
+                &subscription, sizeof(subscription));
+    size_t num_sent = 0;
+    while (num_sent < frame.size()) {
+        const ssize_t result = send(client->fd, frame.data() + num_sent,
+                                    frame.size() - num_sent, MSG_NOSIGNAL);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            *error = std::string("send: ") + std::strerror(errno);
+            return false;
+        }
+        num_sent += result;
+    }
+    return true;
+}
+
+bool receive_telemetry_batch(const double timeout_sec,
+                             TelemetryStreamClient* client,
+                             TelemetryBatch* batch, std::string* error) {
+    TelemetryFrameHeader header;
+    std::vector<char> payload;
+    while (read_frame(timeout_sec, client, &header, &payload, error)) {
+        if (header.type == kTelemetryFrameSchema) {
+            read_schema(payload, client);
+            continue;
+        }
+        if (header.type != kTelemetryFrameSamples ||
+            payload.size() < sizeof(TelemetrySamplesPayload)) {
+            continue;
+        }
+        std::memcpy(&batch->info, payload.data(), sizeof(batch->info));
+        batch->num_columns = count_signals(batch->info.signal_mask);
+        const size_t num_values =
+            size_t(batch->info.num_samples) * batch->num_columns;
+        if (payload.size() !=
+            sizeof(batch->info) + sizeof(double) * num_values) {
+            *error = "malformed samples frame";
+            return false;
+        }
+        batch->values.resize(num_values);
+        std::memcpy(batch->values.data(),
+                    payload.data() + sizeof(batch->info),
+                    sizeof(double) * num_values);
+        return true;
+    }
+    return false;
+}
+
+#else
+
+namespace {
+const char* kUnsupported = "telemetry streaming needs linux";
+} // namespace
+
+bool start_telemetry_server(const std::string& path,
+                            const std::vector<std::string>& signal_names,
+                            TelemetryServer* server, std::string* error) {
+    *server = {};
+    *error = kUnsupported;
+    return false;
+}
+
+void stop_telemetry_server(TelemetryServer* server) { *server = {}; }
+
+void publish_telemetry_stream_sample(const Scalar* values,
+                                     TelemetryServer* server) {}
+
+void poll_telemetry_server(TelemetryServer* server) {}
+
+bool connect_telemetry_stream(const std::string& path,
+                              TelemetryStreamClient* client,
+                              std::string* error) {
+    *client = {};
+    *error = kUnsupported;
+    return false;
+}
+
+void disconnect_telemetry_stream(TelemetryStreamClient* client) {
+    *client = {};
+}
+
+bool wait_for_telemetry_schema(const double timeout_sec,
+                               TelemetryStreamClient* client,
+                               std::string* error) {
+    *error = kUnsupported;
+    return false;
+}
+
+bool get_telemetry_signal_mask(const std::vector<std::string>& names,
+                               const TelemetryStreamClient& client,
+                               uint64_t* mask, std::string* error) {
+    *mask = 0;
+    *error = kUnsupported;
+    return false;
+}
+
+bool subscribe_telemetry_stream(const TelemetrySubscribePayload& subscription,
+                                TelemetryStreamClient* client,
+                                std::string* error) {
+    *error = kUnsupported;
+    return false;
+}
+
+bool receive_telemetry_batch(const double timeout_sec,
+                             TelemetryStreamClient* client,
+                             TelemetryBatch* batch, std::string* error) {
+    *error = kUnsupported;
+    return false;
+}
+
+#endif
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "config/scalar.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Streams telemetry to other processes over a Unix domain socket. The
+// simulator runs the server without ever blocking on it, each client
+// picks the signals and decimation it wants and receives batches of
+// samples in framed binary messages.
+//
+// Frames are a TelemetryFrameHeader and its payload, in native byte order
+// since both ends share the host. On connecting, a client receives the
+// schema and nothing else until it subscribes. When a client reads too
+// slowly for its queue, the server drops whole batches and doubles the
+// client's decimation, and eases back once the queue has drained. Each
+// batch carries the client's count of dropped samples.
+
+constexpr uint32_t kTelemetryStreamMagic = 0x7374726d; // "strm"
+constexpr int kMaxTelemetryStreamSignals = 64; // bits of a signal mask
+constexpr int kTelemetryStreamNameSize = 32;   // with the terminator
+
+constexpr uint32_t kTelemetryFrameSchema = 0;    // server to client
+constexpr uint32_t kTelemetryFrameSamples = 1;   // server to client
+constexpr uint32_t kTelemetryFrameSubscribe = 2; // client to server
+
+struct TelemetryFrameHeader {
+    uint32_t magic;
+    uint32_t type;
+    uint32_t payload_size; // bytes following the header
+    uint32_t reserved;
+};
+
+// followed by num_signals names of kTelemetryStreamNameSize
+struct TelemetrySchemaPayload {
+    uint32_t num_signals;
+    uint32_t reserved;
+};
+
+struct TelemetrySubscribePayload {
+    uint64_t signal_mask; // bit i selects signal i, 0 stops the stream
+    uint32_t decimation;  // keeps samples whose index is a multiple
+    uint32_t batch_size;  // samples per frame
+};
+
+// followed by num_samples rows of the selected signals as doubles, in
+// signal order. sample k was step first_index + k * decimation
+struct TelemetrySamplesPayload {
+    uint64_t first_index;
+    uint64_t signal_mask;
+    uint32_t num_samples;
+    uint32_t decimation; // in effect, may exceed the requested one
+    uint64_t num_dropped; // samples dropped for this client so far
+};
+
+// Server side view of a client.
+struct TelemetrySubscriber {
+    int fd = -1;
+    TelemetrySubscribePayload subscription = {};
+    uint32_t decimation = 1; // raised under backpressure
+
+    // batch being filled
+    std::vector<double> batch;
+    uint32_t batch_count = 0;
+    uint64_t batch_first_index = 0;
+
+    // framed bytes, of which the socket has taken the first outbox_sent
+    std::vector<char> outbox;
+    size_t outbox_sent = 0;
+    std::vector<char> inbox; // partial frames from the client
+
+    uint64_t num_dropped = 0;
+};
+
+struct TelemetryServer {
+    int listen_fd = -1;
+    std::string path;
+    std::vector<std::string> signal_names;
+
+    uint64_t sample_index = 0; // of the next sample published
+    // per client, past this batches are dropped
+    size_t max_queued_bytes = 1 << 20;
+    std::vector<TelemetrySubscriber> subscribers;
+};
+
+// Listens on the socket path, replacing a socket file nothing listens on.
+// Returns false with the reason in error, also when the path exists and is
+// not a socket, or another server is listening on it.
+bool start_telemetry_server(const std::string& path,
+                            const std::vector<std::string>& signal_names,
+                            TelemetryServer* server, std::string* error);
+
+// disconnects all clients and removes the socket file
+void stop_telemetry_server(TelemetryServer* server);
+
+inline bool is_telemetry_server_running(const TelemetryServer& server) {
+    return server.listen_fd >= 0;
+}
+
+// framed bytes the socket has not taken yet, what max_queued_bytes bounds
+inline size_t get_subscriber_queued_bytes(
+    const TelemetrySubscriber& subscriber) {
+    return subscriber.outbox.size() - subscriber.outbox_sent;
+}
+
+// Adds one sample of all the signals to each subscriber's batch, sending
+// the batches that fill up. Never blocks.
+void publish_telemetry_stream_sample(const Scalar* values,
+                                     TelemetryServer* server);
+
+// Accepts new clients, reads subscriptions, sends queued frames and drops
+// clients that hung up. Never blocks, call regularly.
+void poll_telemetry_server(TelemetryServer* server);
+
+struct TelemetryStreamClient {
+    int fd = -1;
+    std::vector<std::string> signal_names; // empty until the schema arrives
+    std::vector<char> inbox;
+};
+
+struct TelemetryBatch {
+    TelemetrySamplesPayload info = {};
+    int num_columns = 0; // signals in the mask
+    std::vector<double> values; // num_samples rows of num_columns
+};
+
+bool connect_telemetry_stream(const std::string& path,
+                              TelemetryStreamClient* client,
+                              std::string* error);
+
+void disconnect_telemetry_stream(TelemetryStreamClient* client);
+
+// Waits for the schema the server sends first. Returns false on timeout
+// or disconnect.
+bool wait_for_telemetry_schema(const double timeout_sec,
+                               TelemetryStreamClient* client,
+                               std::string* error);
+
+// Mask of the named signals of the schema. Returns false, naming the
+// signal in error, if one is missing.
+bool get_telemetry_signal_mask(const std::vector<std::string>& names,
+                               const TelemetryStreamClient& client,
+                               uint64_t* mask, std::string* error);
+
+bool subscribe_telemetry_stream(const TelemetrySubscribePayload& subscription,
+                                TelemetryStreamClient* client,
+                                std::string* error);
+
+// Waits for the next batch. Returns false on timeout, with error empty,
+// or on disconnect.
+bool receive_telemetry_batch(const double timeout_sec,
+                             TelemetryStreamClient* client,
+                             TelemetryBatch* batch, std::string* error);
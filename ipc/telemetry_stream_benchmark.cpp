@@ -0,0 +1,73 @@
+#include "ipc/telemetry_stream.h"
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+// the per step cost to the simulator, with clients draining the stream
+// of all 30 signals in other threads. the server is polled once per 100
+// samples, as the gui polls once per frame
+static void BM_PublishTelemetryStreamSample(benchmark::State& state) {
+    const std::string path =
+        "/tmp/biro_stream_benchmark_" + std::to_string(getpid());
+    constexpr int kNumSignals = 30;
+    TelemetryServer server;
+    std::string error;
+    if (!start_telemetry_server(path,
+                                std::vector<std::string>(kNumSignals, "x"),
+                                &server, &error)) {
+        state.SkipWithError(error.c_str());
+        return;
+    }
+
+    std::atomic<bool> done(false);
+    std::vector<std::thread> clients;
+    for (int i = 0; i < state.range(0); ++i) {
+        clients.emplace_back([&]() {
+            TelemetryStreamClient client;
+            std::string error;
+            if (!connect_telemetry_stream(path, &client, &error) ||
+                !wait_for_telemetry_schema(10, &client, &error)) {
+                return;
+            }
+            TelemetrySubscribePayload subscription = {};
+            subscription.signal_mask = (uint64_t(1) << kNumSignals) - 1;
+            subscription.decimation = 1;
+            subscribe_telemetry_stream(subscription, &client, &error);
+            TelemetryBatch batch;
+            while (!done) {
+                receive_telemetry_batch(0.01, &client, &batch, &error);
+            }
+            disconnect_telemetry_stream(&client);
+        });
+    }
+    while (int(server.subscribers.size()) < state.range(0)) {
+        poll_telemetry_server(&server);
+    }
+
+    std::vector<Scalar> values(kNumSignals, 1.0);
+    int num_published = 0;
+    for (auto _ : state) {
+        publish_telemetry_stream_sample(values.data(), &server);
+        if (++num_published % 100 == 0) {
+            poll_telemetry_server(&server);
+        }
+    }
+    uint64_t num_dropped = 0;
+    for (const TelemetrySubscriber& subscriber : server.subscribers) {
+        num_dropped += subscriber.num_dropped;
+    }
+    state.counters["dropped"] = num_dropped;
+
+    done = true;
+    for (std::thread& client : clients) {
+        client.join();
+    }
+    stop_telemetry_server(&server);
+}
+BENCHMARK(BM_PublishTelemetryStreamSample)
+    ->ArgName("clients")
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(4);
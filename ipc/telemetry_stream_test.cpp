@@ -0,0 +1,239 @@
+#include "ipc/telemetry_stream.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+std::string get_socket_path(const char* test) {
+    return "/tmp/biro_stream_test_" + std::string(test) + "_" +
+           std::to_string(getpid());
+}
+
+// server and client share the thread, the server is polled by hand
+struct StreamFixture {
+    TelemetryServer server;
+    TelemetryStreamClient client;
+    std::string error;
+
+    bool connect(const std::string& path, const int num_signals) {
+        std::vector<std::string> names;
+        for (int i = 0; i < num_signals; ++i) {
+            names.push_back("signal" + std::to_string(i));
+        }
+        if (!start_telemetry_server(path, names, &server, &error) ||
+            !connect_telemetry_stream(path, &client, &error)) {
+            return false;
+        }
+        poll_telemetry_server(&server);
+        return wait_for_telemetry_schema(/*timeout_sec=*/1, &client, &error);
+    }
+
+    bool subscribe(const uint64_t mask, const uint32_t decimation,
+                   const uint32_t batch_size) {
+        TelemetrySubscribePayload subscription = {};
+        subscription.signal_mask = mask;
+        subscription.decimation = decimation;
+        subscription.batch_size = batch_size;
+        if (!subscribe_telemetry_stream(subscription, &client, &error)) {
+            return false;
+        }
+        poll_telemetry_server(&server);
+        return true;
+    }
+
+    // sample i holds i * 10 + signal
+    void publish(const int count) {
+        std::vector<Scalar> values(server.signal_names.size());
+        for (int i = 0; i < count; ++i) {
+            const uint64_t index = server.sample_index;
+            for (int j = 0; j < int(values.size()); ++j) {
+                values[j] = index * 10 + j;
+            }
+            publish_telemetry_stream_sample(values.data(), &server);
+        }
+        poll_telemetry_server(&server);
+    }
+
+    ~StreamFixture() {
+        disconnect_telemetry_stream(&client);
+        stop_telemetry_server(&server);
+    }
+};
+
+} // namespace
+
+TEST(telemetry_stream, client_gets_schema) {
+    StreamFixture fixture;
+    ASSERT_TRUE(fixture.connect(get_socket_path("schema"), 3))
+        << fixture.error;
+    ASSERT_EQ(fixture.client.signal_names.size(), 3u);
+    EXPECT_EQ(fixture.client.signal_names[2], "signal2");
+
+    uint64_t mask;
+    ASSERT_TRUE(get_telemetry_signal_mask({"signal0", "signal2"},
+                                          fixture.client, &mask,
+                                          &fixture.error));
+    EXPECT_EQ(mask, 0b101u);
+    EXPECT_FALSE(get_telemetry_signal_mask({"torque"}, fixture.client, &mask,
+                                           &fixture.error));
+
+    // nothing is sent before subscribing
+    fixture.publish(100);
+    TelemetryBatch batch;
+    EXPECT_FALSE(receive_telemetry_batch(/*timeout_sec=*/0.01,
+                                         &fixture.client, &batch,
+                                         &fixture.error));
+    EXPECT_TRUE(fixture.error.empty());
+}
+
+TEST(telemetry_stream, never_replaces_other_files) {
+    const std::string path = get_socket_path("file");
+    {
+        std::ofstream file(path);
+    }
+    TelemetryServer server;
+    std::string error;
+    EXPECT_FALSE(start_telemetry_server(path, {"signal0"}, &server, &error));
+    EXPECT_NE(error.find("not a socket"), std::string::npos);
+    EXPECT_EQ(access(path.c_str(), F_OK), 0);
+    std::remove(path.c_str());
+
+    // a running server keeps its path
+    ASSERT_TRUE(start_telemetry_server(path, {"signal0"}, &server, &error));
+    TelemetryServer second;
+    EXPECT_FALSE(start_telemetry_server(path, {"signal0"}, &second, &error));
+    EXPECT_NE(error.find("in use"), std::string::npos);
+    TelemetryStreamClient client;
+    EXPECT_TRUE(connect_telemetry_stream(path, &client, &error)) << error;
+    disconnect_telemetry_stream(&client);
+
+    // a stale socket from an earlier run is replaced
+    const int stale_fd = server.listen_fd;
+    server.listen_fd = -1; // as if the earlier run crashed
+    close(stale_fd);
+    EXPECT_TRUE(start_telemetry_server(path, {"signal0"}, &server, &error))
+        << error;
+    stop_telemetry_server(&server);
+}
+
+TEST(telemetry_stream, filters_and_decimates) {
+    StreamFixture fixture;
+    ASSERT_TRUE(fixture.connect(get_socket_path("filter"), 4));
+    ASSERT_TRUE(fixture.subscribe(/*mask=*/0b1010, /*decimation=*/3,
+                                  /*batch_size=*/5));
+    const uint64_t start = fixture.server.sample_index;
+    fixture.publish(30);
+
+    TelemetryBatch batch;
+    ASSERT_TRUE(receive_telemetry_batch(1, &fixture.client, &batch,
+                                        &fixture.error))
+        << fixture.error;
+    EXPECT_EQ(batch.info.num_samples, 5u);
+    EXPECT_EQ(batch.info.decimation, 3u);
+    EXPECT_EQ(batch.num_columns, 2);
+    EXPECT_EQ(batch.info.first_index % 3, 0u);
+    EXPECT_GE(batch.info.first_index, start);
+    for (uint32_t k = 0; k < batch.info.num_samples; ++k) {
+        const uint64_t index = batch.info.first_index + k * 3;
+        EXPECT_EQ(batch.values[k * 2], index * 10 + 1);
+        EXPECT_EQ(batch.values[k * 2 + 1], index * 10 + 3);
+    }
+    EXPECT_EQ(batch.info.num_dropped, 0u);
+}
+
+TEST(telemetry_stream, slow_client_never_stalls_server) {
+    StreamFixture fixture;
+    ASSERT_TRUE(fixture.connect(get_socket_path("slow"), 8));
+    fixture.server.max_queued_bytes = 1 << 14;
+    ASSERT_TRUE(fixture.subscribe(/*mask=*/0xff, /*decimation=*/1,
+                                  /*batch_size=*/64));
+
+    // far more than the socket and the queue hold, with nobody reading
+    fixture.publish(1000000);
+    const TelemetrySubscriber& subscriber = fixture.server.subscribers[0];
+    EXPECT_GT(subscriber.num_dropped, 0u);
+    EXPECT_GT(subscriber.decimation, 1u);
+    EXPECT_LE(get_subscriber_queued_bytes(subscriber),
+              fixture.server.max_queued_bytes);
+
+    // everything queued still arrives intact, and the drops are reported
+    TelemetryBatch batch;
+    uint64_t num_dropped = 0;
+    while (receive_telemetry_batch(0.05, &fixture.client, &batch,
+                                   &fixture.error)) {
+        const uint32_t decimation = batch.info.decimation;
+        for (uint32_t k = 0; k < batch.info.num_samples; ++k) {
+            const uint64_t index = batch.info.first_index + k * decimation;
+            ASSERT_EQ(batch.values[k * 8 + 7], index * 10 + 7);
+        }
+        num_dropped = batch.info.num_dropped;
+        fixture.publish(0);
+    }
+    EXPECT_GT(num_dropped, 0u);
+
+    // caught up, the decimation eases back
+    for (int i = 0; i < 20; ++i) {
+        fixture.publish(0);
+    }
+    EXPECT_EQ(fixture.server.subscribers[0].decimation, 1u);
+}
+
+TEST(telemetry_stream, outbox_stays_bounded_for_slow_reader) {
+    StreamFixture fixture;
+    ASSERT_TRUE(fixture.connect(get_socket_path("bounded"), 8));
+    fixture.server.max_queued_bytes = 1 << 14;
+    ASSERT_TRUE(fixture.subscribe(/*mask=*/0xff, /*decimation=*/1,
+                                  /*batch_size=*/64));
+
+    // a socket buffer smaller than the queue, and a client that reads a
+    // little now and then, so the server only ever sends part of its outbox
+    const int send_buffer_size = 4096;
+    setsockopt(fixture.server.subscribers[0].fd, SOL_SOCKET, SO_SNDBUF,
+               &send_buffer_size, sizeof(send_buffer_size));
+    size_t max_outbox_size = 0;
+    for (int i = 0; i < 2000; ++i) {
+        fixture.publish(1000);
+        char buffer[512];
+        recv(fixture.client.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        const TelemetrySubscriber& subscriber = fixture.server.subscribers[0];
+        EXPECT_LE(get_subscriber_queued_bytes(subscriber),
+                  fixture.server.max_queued_bytes);
+        max_outbox_size = std::max(max_outbox_size, subscriber.outbox.size());
+    }
+    EXPECT_LE(max_outbox_size, 2 * fixture.server.max_queued_bytes);
+}
+
+TEST(telemetry_stream, drops_clients_that_hang_up) {
+    StreamFixture fixture;
+    ASSERT_TRUE(fixture.connect(get_socket_path("hangup"), 2));
+    ASSERT_TRUE(fixture.subscribe(0b11, 1, 1));
+    EXPECT_EQ(fixture.server.subscribers.size(), 1u);
+
+    disconnect_telemetry_stream(&fixture.client);
+    fixture.publish(10);
+    fixture.publish(10);
+    EXPECT_TRUE(fixture.server.subscribers.empty());
+}
+
+TEST(telemetry_stream, drops_clients_that_send_oversized_frames) {
+    StreamFixture fixture;
+    ASSERT_TRUE(fixture.connect(get_socket_path("oversized"), 2));
+    ASSERT_TRUE(fixture.subscribe(0b11, 1, 1));
+
+    // announces a frame the server would otherwise buffer up to 4 GiB of
+    TelemetryFrameHeader header = {};
+    header.magic = kTelemetryStreamMagic;
+    header.type = kTelemetryFrameSubscribe;
+    header.payload_size = UINT32_MAX;
+    ASSERT_EQ(send(fixture.client.fd, &header, sizeof(header), 0),
+              ssize_t(sizeof(header)));
+    std::vector<char> filler(1 << 16);
+    send(fixture.client.fd, filler.data(), filler.size(), MSG_DONTWAIT);
+    fixture.publish(10);
+    EXPECT_TRUE(fixture.server.subscribers.empty());
+}
@@ -0,0 +1,130 @@
+#include "back_emf_fit.h"
+#include "util/numeric_csv.h"
+#include "util/sine_series.h"
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// rows of sin(h_k * angle) over the harmonics of the series
+using DesignMatrix = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic,
+                                   Eigen::RowMajor>;
+
+void fill_design_row(const Scalar angle, const int series,
+                     const int num_coeffs, Scalar* row) {
+    if (series == kSineSeriesOdd) {
+        generate_odd_sine_series(num_coeffs, angle, row);
+        return;
+    }
+    // sin((k + 1) x) = 2 cos(x) sin(k x) - sin((k - 1) x)
+    Scalar sin_angle, cos_angle;
+    fast_sincos(angle, &sin_angle, &cos_angle);
+    Scalar prev = 0;
+    Scalar curr = sin_angle;
+    for (int i = 0; i < num_coeffs; ++i) {
+        row[i] = curr;
+        const Scalar next = 2 * cos_angle * curr - prev;
+        prev = curr;
+        curr = next;
+    }
+}
+
+} // namespace
+
+bool fit_normed_bEmf(const Scalar* electrical_angles,
+                     const Scalar* normed_bEmfs, const int count,
+                     const int series, const int num_coeffs,
+                     BEmfCoeffs* coeffs, Scalar* rms_residual) {
+    if (num_coeffs < 1 || num_coeffs > kMaxBEmfCoeffs || count < num_coeffs) {
+        return false;
+    }
+
+    constexpr int kBatchSize = 256;
+    Eigen::MatrixXd normal_matrix =
+        Eigen::MatrixXd::Zero(num_coeffs, num_coeffs);
+    Eigen::VectorXd normal_rhs = Eigen::VectorXd::Zero(num_coeffs);
+    DesignMatrix design(kBatchSize, num_coeffs);
+
+    for (int begin = 0; begin < count; begin += kBatchSize) {
+        const int batch_size = std::min(kBatchSize, count - begin);
+        for (int i = 0; i < batch_size; ++i) {
+            fill_design_row(electrical_angles[begin + i], series, num_coeffs,
+                            design.row(i).data());
+        }
+        const auto batch = design.topRows(batch_size);
+        normal_matrix.selfadjointView<Eigen::Lower>().rankUpdate(
+            batch.transpose());
+        normal_rhs += batch.transpose() *
+                      Eigen::Map<const Eigen::VectorXd>(normed_bEmfs + begin,
+                                                        batch_size);
+    }
+
+    const Eigen::LDLT<Eigen::MatrixXd> ldlt =
+        normal_matrix.selfadjointView<Eigen::Lower>().ldlt();
+    // angles that all alias onto the same few points leave it singular
+    if (ldlt.info() != Eigen::Success || !ldlt.isPositive() ||
+        ldlt.vectorD().minCoeff() <= 1e-12 * ldlt.vectorD().maxCoeff()) {
+        return false;
+    }
+    *coeffs = ldlt.solve(normal_rhs);
+
+    if (rms_residual != nullptr) {
+        Scalar sum_sq = 0;
+        for (int i = 0; i < count; ++i) {
+            Scalar sin_angle, cos_angle;
+            fast_sincos(electrical_angles[i], &sin_angle, &cos_angle);
+            const Scalar fitted =
+                series == kSineSeriesOdd
+                    ? evaluate_sine_series<kSineSeriesOdd, -1>(
+                          coeffs->data(), num_coeffs, sin_angle, cos_angle)
+                    : evaluate_sine_series<kSineSeriesAll, -1>(
+                          coeffs->data(), num_coeffs, sin_angle, cos_angle);
+            sum_sq += (fitted - normed_bEmfs[i]) * (fitted - normed_bEmfs[i]);
+        }
+        *rms_residual = std::sqrt(sum_sq / count);
+    }
+    return true;
+}
+
+bool load_bEmf_csv(const std::string& path,
+                   const Scalar electrical_angular_vel,
+                   std::vector<Scalar>* electrical_angles,
+                   std::vector<Scalar>* normed_bEmfs) {
+    if (electrical_angular_vel == 0 || !std::isfinite(electrical_angular_vel)) {
+        return false;
+    }
+
+    electrical_angles->clear();
+    normed_bEmfs->clear();
+    return read_numeric_csv(
+        path, 2, [&](const Scalar* values, const int num_values) {
+            if (num_values == 2) {
+                electrical_angles->push_back(values[0]);
+                normed_bEmfs->push_back(values[1] / electrical_angular_vel);
+            }
+        });
+}
+
+bool import_bEmf_csv(const std::string& path,
+                     const Scalar electrical_angular_vel, const int series,
+                     const int num_coeffs, MotorParams* params,
+                     Scalar* rms_residual) {
+    std::vector<Scalar> electrical_angles;
+    std::vector<Scalar> normed_bEmfs;
+    if (!load_bEmf_csv(path, electrical_angular_vel, &electrical_angles,
+                       &normed_bEmfs)) {
+        return false;
+    }
+
+    BEmfCoeffs coeffs;
+    if (!fit_normed_bEmf(electrical_angles.data(), normed_bEmfs.data(),
+                         electrical_angles.size(), series, num_coeffs,
+                         &coeffs, rms_residual) ||
+        !coeffs.allFinite() || coeffs(0) <= 0) {
+        return false;
+    }
+    params->normed_bEmf_coeffs = coeffs;
+    params->normed_bEmf_series = series;
+    return true;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "config/scalar.h"
+#include "motor_state.h"
+#include <string>
+#include <vector>
+
+// Least squares fit of the normed bEmf series (see get_normed_bEmfs) to
+// measured samples, taken at electrical angles in radians. The normal
+// equations are accumulated in batches, so any number of samples fits in
+// constant memory. Returns false if the samples can not determine
+// num_coeffs terms of the series.
+bool fit_normed_bEmf(const Scalar* electrical_angles,
+                     const Scalar* normed_bEmfs, const int count,
+                     const int series, const int num_coeffs,
+                     BEmfCoeffs* coeffs, Scalar* rms_residual = nullptr);
+
+// Reads "electrical angle, back emf" rows of a single phase, see
+// read_numeric_csv. The back emf is divided by the
+// electrical angular velocity it was measured at (rad/s), pass 1 if the
+// samples are already normed. Returns false if the file can not be read, or
+// the velocity is zero or not finite.
+bool load_bEmf_csv(const std::string& path,
+                   const Scalar electrical_angular_vel,
+                   std::vector<Scalar>* electrical_angles,
+                   std::vector<Scalar>* normed_bEmfs);
+
+// Loads and fits a measured back emf into the motor params, keeping them
+// unchanged on failure. Fits that are not finite, eg. from nan samples, are
+// rejected. So are fits with a fundamental that is not positive, they mean
+// the angles or the velocity have the wrong sign, and the harmonics are
+// scaled by the fundamental elsewhere.
+bool import_bEmf_csv(const std::string& path,
+                     const Scalar electrical_angular_vel, const int series,
+                     const int num_coeffs, MotorParams* params,
+                     Scalar* rms_residual = nullptr);
@@ -0,0 +1,153 @@
+#include "back_emf_fit.h"
+#include "util/math_constants.h"
+#include "util/random.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <gtest/gtest.h>
+
+namespace {
+
+// noisy samples of a known series at random angles
+void get_samples(const BEmfCoeffs& coeffs, const int series,
+                 const Scalar noise, const int count,
+                 std::vector<Scalar>* angles, std::vector<Scalar>* bEmfs) {
+    RandomStream rng;
+    init_random_stream(/*seed=*/3, /*stream=*/0, /*instance=*/0, &rng);
+    angles->resize(count);
+    bEmfs->resize(count);
+    for (int i = 0; i < count; ++i) {
+        (*angles)[i] = 2 * kPI * random_uniform(&rng);
+        (*bEmfs)[i] = get_normed_bEmf(coeffs, series, (*angles)[i]) +
+                      noise * random_normal(&rng);
+    }
+}
+
+} // namespace
+
+TEST(fit_normed_bEmf, recovers_coeffs) {
+    for (int series : {kSineSeriesOdd, kSineSeriesAll}) {
+        BEmfCoeffs expected(5);
+        expected << 0.01, -0.002, 0.001, 0.0005, -0.0002;
+        std::vector<Scalar> angles;
+        std::vector<Scalar> bEmfs;
+        get_samples(expected, series, /*noise=*/0, /*count=*/1000, &angles,
+                    &bEmfs);
+
+        BEmfCoeffs coeffs;
+        Scalar rms_residual;
+        ASSERT_TRUE(fit_normed_bEmf(angles.data(), bEmfs.data(),
+                                    angles.size(), series, 5, &coeffs,
+                                    &rms_residual));
+        ASSERT_EQ(coeffs.size(), 5);
+        for (int i = 0; i < 5; ++i) {
+            EXPECT_NEAR(coeffs(i), expected(i), 1e-12);
+        }
+        EXPECT_LT(rms_residual, 1e-12);
+    }
+}
+
+TEST(fit_normed_bEmf, averages_noise) {
+    BEmfCoeffs expected(3);
+    expected << 0.02, 0.001, -0.0005;
+    std::vector<Scalar> angles;
+    std::vector<Scalar> bEmfs;
+    get_samples(expected, kSineSeriesOdd, /*noise=*/1e-3, /*count=*/20000,
+                &angles, &bEmfs);
+
+    // extra terms should come out near zero
+    BEmfCoeffs coeffs;
+    Scalar rms_residual;
+    ASSERT_TRUE(fit_normed_bEmf(angles.data(), bEmfs.data(), angles.size(),
+                                kSineSeriesOdd, 6, &coeffs, &rms_residual));
+    for (int i = 0; i < 6; ++i) {
+        EXPECT_NEAR(coeffs(i), i < 3 ? expected(i) : 0, 1e-4);
+    }
+    EXPECT_NEAR(rms_residual, 1e-3, 1e-4);
+}
+
+TEST(fit_normed_bEmf, rejects_underdetermined) {
+    const std::vector<Scalar> angles = {0.1, 0.2};
+    const std::vector<Scalar> bEmfs = {0.01, 0.02};
+    BEmfCoeffs coeffs;
+    EXPECT_FALSE(fit_normed_bEmf(angles.data(), bEmfs.data(), angles.size(),
+                                 kSineSeriesOdd, 3, &coeffs));
+
+    // enough samples, but all at the same angle
+    const std::vector<Scalar> same_angles(10, 0.5);
+    const std::vector<Scalar> same_bEmfs(10, 0.01);
+    EXPECT_FALSE(fit_normed_bEmf(same_angles.data(), same_bEmfs.data(),
+                                 same_angles.size(), kSineSeriesOdd, 3,
+                                 &coeffs));
+}
+
+TEST(import_bEmf_csv, fits_motor_params) {
+    BEmfCoeffs expected(2);
+    expected << 0.01, 0.002;
+    const Scalar electrical_angular_vel = 500;
+
+    const std::string csv_path = testing::TempDir() + "bemf.csv";
+    {
+        std::ofstream csv(csv_path);
+        csv.precision(17);
+        csv << "angle, bemf\n";
+        for (int i = 0; i < 360; ++i) {
+            const Scalar angle = 2 * kPI * i / 360;
+            csv << angle << ", "
+                << electrical_angular_vel *
+                       get_normed_bEmf(expected, kSineSeriesAll, angle)
+                << "\n";
+        }
+    }
+
+    MotorParams params;
+    params.normed_bEmf_coeffs.setZero(5);
+    ASSERT_TRUE(import_bEmf_csv(csv_path, electrical_angular_vel,
+                                kSineSeriesAll, 4, &params));
+    EXPECT_EQ(params.normed_bEmf_series, kSineSeriesAll);
+    ASSERT_EQ(params.normed_bEmf_coeffs.size(), 4);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_NEAR(params.normed_bEmf_coeffs(i), i < 2 ? expected(i) : 0,
+                    1e-12);
+    }
+
+    EXPECT_FALSE(import_bEmf_csv(testing::TempDir() + "missing.csv",
+                                 electrical_angular_vel, kSineSeriesAll, 4,
+                                 &params));
+    EXPECT_EQ(params.normed_bEmf_coeffs.size(), 4);
+
+    // measured spinning backwards, the fundamental comes out negative
+    EXPECT_FALSE(import_bEmf_csv(csv_path, -electrical_angular_vel,
+                                 kSineSeriesAll, 2, &params));
+    EXPECT_EQ(params.normed_bEmf_coeffs.size(), 4);
+    EXPECT_NEAR(params.normed_bEmf_coeffs(0), expected(0), 1e-12);
+    std::remove(csv_path.c_str());
+}
+
+TEST(import_bEmf_csv, rejects_non_finite_fits) {
+    const std::string csv_path = testing::TempDir() + "bemf_nan.csv";
+    {
+        std::ofstream csv(csv_path);
+        for (int i = 0; i < 360; ++i) {
+            const Scalar angle = 2 * kPI * i / 360;
+            csv << angle << ", " << std::sin(angle) << "\n";
+        }
+        csv << "1.0, nan\n";
+    }
+
+    MotorParams params;
+    params.normed_bEmf_coeffs.setZero(2);
+    params.normed_bEmf_coeffs(0) = 0.01;
+    for (const Scalar vel :
+         {Scalar(0), std::numeric_limits<Scalar>::quiet_NaN(),
+          std::numeric_limits<Scalar>::infinity()}) {
+        EXPECT_FALSE(
+            import_bEmf_csv(csv_path, vel, kSineSeriesAll, 2, &params));
+    }
+
+    // a nan sample poisons the fit
+    EXPECT_FALSE(import_bEmf_csv(csv_path, 1, kSineSeriesAll, 2, &params));
+    EXPECT_EQ(params.normed_bEmf_coeffs(0), 0.01);
+    std::remove(csv_path.c_str());
+}
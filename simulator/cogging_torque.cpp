@@ -0,0 +1,191 @@
+#include "cogging_torque.h"
+#include "util/math_constants.h"
+#include "util/numeric_csv.h"
+#include <algorithm>
+#include <array>
+#include <complex>
+#include <fstream>
+#include <unsupported/Eigen/FFT>
+
+void synthesize_cogging_torque_map(
+    const std::vector<CoggingHarmonic>& harmonics, const int resolution,
+    std::vector<Scalar>* cogging_torque_map) {
+    // half spectrum of the real map. a cos + b sin at harmonic h is
+    // (a - ib) * n/2 in bin h, given the 1/n scaling of the inverse
+    std::vector<std::complex<Scalar>> spectrum(resolution / 2 + 1);
+    for (const CoggingHarmonic& term : harmonics) {
+        // the nyquist bin would lose the sin term
+        if (term.harmonic <= 0 || 2 * term.harmonic >= resolution) {
+            continue;
+        }
+        spectrum[term.harmonic] += std::complex<Scalar>(term.cos_coeff,
+                                                        -term.sin_coeff) *
+                                   Scalar(resolution / 2.0);
+    }
+
+    cogging_torque_map->resize(resolution);
+    // plans are cached per size, so repeated synthesis skips the twiddles
+    static thread_local Eigen::FFT<Scalar> fft;
+    fft.inv(cogging_torque_map->data(), spectrum.data(), resolution);
+}
+
+std::vector<CoggingHarmonic>
+get_random_cogging_harmonics(const int num_pole_pairs, RandomStream* rng) {
+    const int p = num_pole_pairs;
+    const std::array<int, 6> frequencies = {1,         p,         p * 2 + 1,
+                                            p * 3 + 2, p * 7 + 3, p * 10 + 4};
+    const std::array<Scalar, 6> scales = {0.5, 1.5, 1.0, 1.5, 0.5, 0.25};
+
+    std::vector<CoggingHarmonic> harmonics(frequencies.size());
+    for (int i = 0; i < int(frequencies.size()); ++i) {
+        harmonics[i].harmonic = frequencies[i];
+        harmonics[i].cos_coeff = random_normal(rng) * scales[i];
+        harmonics[i].sin_coeff = random_normal(rng) * scales[i];
+    }
+    return harmonics;
+}
+
+void remove_cogging_torque_mean(std::vector<Scalar>* cogging_torque_map) {
+    if (cogging_torque_map->empty()) {
+        return;
+    }
+    Scalar mean = 0;
+    for (const Scalar torque : *cogging_torque_map) {
+        mean += torque;
+    }
+    mean /= cogging_torque_map->size();
+    for (Scalar& torque : *cogging_torque_map) {
+        torque -= mean;
+    }
+}
+
+void scale_cogging_torque_map(const Scalar max_torque,
+                              std::vector<Scalar>* cogging_torque_map) {
+    Scalar max_abs = 0;
+    for (const Scalar torque : *cogging_torque_map) {
+        max_abs = std::max(max_abs, std::abs(torque));
+    }
+    if (max_abs == 0) {
+        return;
+    }
+    for (Scalar& torque : *cogging_torque_map) {
+        torque *= max_torque / max_abs;
+    }
+}
+
+bool resample_cogging_torque_map(const std::vector<Scalar>& angles,
+                                 const std::vector<Scalar>& torques,
+                                 const int resolution,
+                                 std::vector<Scalar>* cogging_torque_map) {
+    const int count = std::min(angles.size(), torques.size());
+    if (count == 0) {
+        return false;
+    }
+
+    cogging_torque_map->resize(resolution);
+
+    // walk the samples alongside the map, wrapping around the revolution
+    // at both ends
+    int next = 0; // first sample at or after the current angle
+    for (int i = 0; i < resolution; ++i) {
+        const Scalar angle = 2 * kPI * i / resolution;
+        while (next < count && angles[next] < angle) {
+            ++next;
+        }
+        const int prev = next - 1;
+        const Scalar prev_angle =
+            prev >= 0 ? angles[prev] : angles[count - 1] - 2 * kPI;
+        const Scalar prev_torque =
+            prev >= 0 ? torques[prev] : torques[count - 1];
+        const Scalar next_angle =
+            next < count ? angles[next] : angles[0] + 2 * kPI;
+        const Scalar next_torque = next < count ? torques[next] : torques[0];
+
+        const Scalar span = next_angle - prev_angle;
+        const Scalar t = span > 0 ? (angle - prev_angle) / span : 0;
+        (*cogging_torque_map)[i] =
+            prev_torque + t * (next_torque - prev_torque);
+    }
+
+    remove_cogging_torque_mean(cogging_torque_map);
+    return true;
+}
+
+namespace {
+
+std::vector<Scalar> get_even_angles(const int count) {
+    std::vector<Scalar> angles(count);
+    for (int i = 0; i < count; ++i) {
+        angles[i] = 2 * kPI * i / count;
+    }
+    return angles;
+}
+
+} // namespace
+
+bool load_cogging_torque_csv(const std::string& path, const int resolution,
+                             std::vector<Scalar>* cogging_torque_map) {
+    std::vector<Scalar> angles;
+    std::vector<Scalar> torques;
+    int num_columns = 0; // decided by the first row that parses
+    const bool read = read_numeric_csv(
+        path, 2, [&](const Scalar* values, const int num_values) {
+            if (num_columns == 0) {
+                num_columns = num_values;
+            }
+            if (num_columns == 2 && num_values == 2) {
+                angles.push_back(values[0]);
+                torques.push_back(values[1]);
+            } else if (num_columns == 1) {
+                torques.push_back(values[0]);
+            }
+        });
+    if (!read) {
+        return false;
+    }
+
+    if (num_columns == 1) {
+        angles = get_even_angles(torques.size());
+    } else {
+        // measurements need not be in order
+        std::vector<int> order(angles.size());
+        for (int i = 0; i < int(order.size()); ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(),
+                  [&](int a, int b) { return angles[a] < angles[b]; });
+        std::vector<Scalar> sorted_angles(order.size());
+        std::vector<Scalar> sorted_torques(order.size());
+        for (int i = 0; i < int(order.size()); ++i) {
+            sorted_angles[i] = angles[order[i]];
+            sorted_torques[i] = torques[order[i]];
+        }
+        angles = std::move(sorted_angles);
+        torques = std::move(sorted_torques);
+    }
+
+    return resample_cogging_torque_map(angles, torques, resolution,
+                                       cogging_torque_map);
+}
+
+bool load_cogging_torque_binary(const std::string& path, const int resolution,
+                                std::vector<Scalar>* cogging_torque_map) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+    const std::streamsize size = file.tellg();
+    file.seekg(0);
+
+    std::vector<double> samples(size / sizeof(double));
+    file.read(reinterpret_cast<char*>(samples.data()),
+              samples.size() * sizeof(double));
+    if (!file) {
+        return false;
+    }
+
+    const std::vector<Scalar> torques(samples.begin(), samples.end());
+    return resample_cogging_torque_map(get_even_angles(torques.size()),
+                                       torques, resolution,
+                                       cogging_torque_map);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "config/scalar.h"
+#include "util/random.h"
+#include <string>
+#include <vector>
+
+// Cogging torque maps hold the cogging torque over one mechanical
+// revolution, sampled at evenly spaced rotor angles starting from 0.
+// Any resolution works, see interp_cogging_torque.
+
+// one term of the fourier series of a map,
+// cos_coeff * cos(harmonic * angle) + sin_coeff * sin(harmonic * angle)
+struct CoggingHarmonic {
+    int harmonic = 1; // per mechanical revolution
+    Scalar cos_coeff = 0;
+    Scalar sin_coeff = 0;
+};
+
+// Sums the harmonics with an inverse fft. Harmonic 0 is dropped, since the
+// torque must average to zero over a revolution to conserve energy, and so
+// are harmonics the resolution can not represent.
+void synthesize_cogging_torque_map(
+    const std::vector<CoggingHarmonic>& harmonics, const int resolution,
+    std::vector<Scalar>* cogging_torque_map);
+
+// Random coefficients at some frequencies that might be dominant in a
+// motor with this many pole pairs, with some fudging to look interesting.
+std::vector<CoggingHarmonic>
+get_random_cogging_harmonics(const int num_pole_pairs, RandomStream* rng);
+
+void remove_cogging_torque_mean(std::vector<Scalar>* cogging_torque_map);
+
+// scales the map so that its largest magnitude is max_torque
+void scale_cogging_torque_map(const Scalar max_torque,
+                              std::vector<Scalar>* cogging_torque_map);
+
+// Resamples torques measured at increasing angles within [0, 2pi) onto an
+// evenly spaced map, interpolating linearly around the revolution, and
+// removes the mean. Returns false if there are no samples.
+bool resample_cogging_torque_map(const std::vector<Scalar>& angles,
+                                 const std::vector<Scalar>& torques,
+                                 const int resolution,
+                                 std::vector<Scalar>* cogging_torque_map);
+
+// Loads measured cogging torque, resampled to the resolution. CSV rows are
+// either "angle, torque" with the rotor angle in radians, or "torque" for
+// samples evenly spaced over a revolution, see read_numeric_csv. Binary
+// files hold native doubles, evenly spaced
+// over a revolution. Return false if the file has no samples.
+bool load_cogging_torque_csv(const std::string& path, const int resolution,
+                             std::vector<Scalar>* cogging_torque_map);
+bool load_cogging_torque_binary(const std::string& path, const int resolution,
+                                std::vector<Scalar>* cogging_torque_map);
@@ -0,0 +1,40 @@
+#include "cogging_torque.h"
+#include "util/math_constants.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+
+static std::vector<CoggingHarmonic> get_harmonics() {
+    RandomStream rng;
+    init_random_stream(/*seed=*/0, kRandomStreamCogging, /*instance=*/0,
+                       &rng);
+    return get_random_cogging_harmonics(/*num_pole_pairs=*/4, &rng);
+}
+
+// evaluating every harmonic at every entry, as the gui used to
+static void BM_Cogging_Map_Direct(benchmark::State& state) {
+    const std::vector<CoggingHarmonic> harmonics = get_harmonics();
+    std::vector<Scalar> map(state.range(0));
+    for (auto _ : state) {
+        for (int i = 0; i < int(map.size()); ++i) {
+            const Scalar angle = 2 * kPI * i / map.size();
+            Scalar torque = 0;
+            for (const CoggingHarmonic& term : harmonics) {
+                torque += term.cos_coeff * std::cos(term.harmonic * angle) +
+                          term.sin_coeff * std::sin(term.harmonic * angle);
+            }
+            map[i] = torque;
+        }
+        benchmark::DoNotOptimize(map.data());
+    }
+}
+BENCHMARK(BM_Cogging_Map_Direct)->Arg(3600)->Arg(36000);
+
+static void BM_Cogging_Map_Fft(benchmark::State& state) {
+    const std::vector<CoggingHarmonic> harmonics = get_harmonics();
+    std::vector<Scalar> map;
+    for (auto _ : state) {
+        synthesize_cogging_torque_map(harmonics, state.range(0), &map);
+        benchmark::DoNotOptimize(map.data());
+    }
+}
+BENCHMARK(BM_Cogging_Map_Fft)->Arg(3600)->Arg(36000);
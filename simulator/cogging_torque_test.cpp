@@ -0,0 +1,108 @@
+#include "cogging_torque.h"
+#include "util/math_constants.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+
+TEST(synthesize_cogging_torque_map, matches_series) {
+    const std::vector<CoggingHarmonic> harmonics = {
+        {/*harmonic=*/1, /*cos_coeff=*/0.5, /*sin_coeff=*/-0.25},
+        {/*harmonic=*/9, /*cos_coeff=*/0.1, /*sin_coeff=*/0.3},
+        {/*harmonic=*/9, /*cos_coeff=*/0.1, /*sin_coeff=*/0},
+    };
+    for (int resolution : {100, 360, 1001}) {
+        std::vector<Scalar> map;
+        synthesize_cogging_torque_map(harmonics, resolution, &map);
+        ASSERT_EQ(map.size(), resolution);
+
+        for (int i = 0; i < resolution; ++i) {
+            const Scalar angle = 2 * kPI * i / resolution;
+            Scalar expected = 0;
+            for (const CoggingHarmonic& term : harmonics) {
+                expected += term.cos_coeff * std::cos(term.harmonic * angle) +
+                            term.sin_coeff * std::sin(term.harmonic * angle);
+            }
+            EXPECT_NEAR(map[i], expected, 1e-12);
+        }
+    }
+}
+
+TEST(synthesize_cogging_torque_map, zero_mean) {
+    RandomStream rng;
+    init_random_stream(/*seed=*/7, kRandomStreamCogging, /*instance=*/0,
+                       &rng);
+    std::vector<CoggingHarmonic> harmonics =
+        get_random_cogging_harmonics(/*num_pole_pairs=*/4, &rng);
+    // a constant offset would add energy every revolution
+    harmonics.push_back({/*harmonic=*/0, /*cos_coeff=*/1, /*sin_coeff=*/0});
+
+    std::vector<Scalar> map;
+    synthesize_cogging_torque_map(harmonics, 3600, &map);
+    scale_cogging_torque_map(/*max_torque=*/0.01, &map);
+
+    Scalar sum = 0;
+    Scalar max_abs = 0;
+    for (const Scalar torque : map) {
+        sum += torque;
+        max_abs = std::max(max_abs, std::abs(torque));
+    }
+    EXPECT_NEAR(sum, 0, 1e-12);
+    EXPECT_NEAR(max_abs, 0.01, 1e-15);
+}
+
+TEST(resample_cogging_torque_map, wraps_around) {
+    // uneven samples of a triangle wave, none at angle 0
+    const std::vector<Scalar> angles = {kPI / 2, kPI, 3 * kPI / 2};
+    const std::vector<Scalar> torques = {1, 0, -1};
+    std::vector<Scalar> map;
+    ASSERT_TRUE(resample_cogging_torque_map(angles, torques, 8, &map));
+
+    // angle 0 interpolates between the last and first samples
+    const std::vector<Scalar> expected = {0, 0.5, 1, 0.5, 0, -0.5, -1, -0.5};
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_NEAR(map[i], expected[i], 1e-12);
+    }
+
+    EXPECT_FALSE(resample_cogging_torque_map({}, {}, 8, &map));
+}
+
+TEST(load_cogging_torque, csv_and_binary) {
+    const std::string csv_path = testing::TempDir() + "cogging.csv";
+    {
+        std::ofstream csv(csv_path);
+        csv.precision(17);
+        csv << "angle, torque\n";
+        // out of order, and offset by a mean to remove
+        csv << 3 * kPI / 2 << ", " << 0 << "\n";
+        csv << 0 << ", " << 2 << "\n";
+        csv << kPI / 2 << ", " << 1 << "\n";
+        csv << kPI << ", " << 1 << "\n";
+    }
+    std::vector<Scalar> map;
+    ASSERT_TRUE(load_cogging_torque_csv(csv_path, 4, &map));
+    const std::vector<Scalar> expected = {1, 0, 0, -1};
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_NEAR(map[i], expected[i], 1e-12);
+    }
+
+    const std::string binary_path = testing::TempDir() + "cogging.bin";
+    {
+        const std::vector<double> samples = {2, 1, 1, 0};
+        std::ofstream binary(binary_path, std::ios::binary);
+        binary.write(reinterpret_cast<const char*>(samples.data()),
+                     samples.size() * sizeof(double));
+    }
+    // upsampled by 2
+    ASSERT_TRUE(load_cogging_torque_binary(binary_path, 8, &map));
+    const std::vector<Scalar> expected_upsampled = {1,   0.5, 0,  0,
+                                                    0, -0.5, -1, 0};
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_NEAR(map[i], expected_upsampled[i], 1e-12);
+    }
+
+    EXPECT_FALSE(load_cogging_torque_csv(testing::TempDir() + "missing.csv",
+                                         4, &map));
+    std::remove(csv_path.c_str());
+    std::remove(binary_path.c_str());
+}
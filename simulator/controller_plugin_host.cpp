@@ -0,0 +1,141 @@
+#include "controller_plugin_host.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+namespace {
+
+void* open_library(const std::string& path, std::string* error) {
+#ifdef _WIN32
+    void* library = LoadLibraryA(path.c_str());
+    if (library == nullptr) {
+        *error = "could not load " + path;
+    }
+#else
+    // local, so plugins built from the same sources do not collide
+    void* library = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (library == nullptr) {
+        *error = dlerror();
+    }
+#endif
+    return library;
+}
+
+void* find_symbol(void* library, const char* name) {
+#ifdef _WIN32
+    return reinterpret_cast<void*>(
+        GetProcAddress(static_cast<HMODULE>(library), name));
+#else
+    return dlsym(library, name);
+#endif
+}
+
+void close_library(void* library) {
+#ifdef _WIN32
+    FreeLibrary(static_cast<HMODULE>(library));
+#else
+    dlclose(library);
+#endif
+}
+
+} // namespace
+
+BiroControllerConfig get_controller_plugin_config(const Scalar period,
+                                                  const MotorParams& params) {
+    BiroControllerConfig config = {};
+    config.period = period;
+    config.num_pole_pairs = params.num_pole_pairs;
+    config.phase_resistance = params.phase_resistance;
+    config.phase_inductance = params.phase_inductance;
+    config.normed_bEmf0 = params.normed_bEmf_coeffs.size() > 0
+                              ? params.normed_bEmf_coeffs(0)
+                              : 0;
+    config.rotor_inertia = params.rotor_inertia;
+    return config;
+}
+
+bool load_controller_plugin(const std::string& path,
+                            const BiroControllerConfig& config,
+                            ControllerPlugin* plugin, std::string* error) {
+    *plugin = {};
+    void* library = open_library(path, error);
+    if (library == nullptr) {
+        return false;
+    }
+
+    const auto get_api = reinterpret_cast<BiroGetControllerApiFn>(
+        find_symbol(library, BIRO_CONTROLLER_API_SYMBOL));
+    if (get_api == nullptr) {
+        *error = path + " does not export " BIRO_CONTROLLER_API_SYMBOL;
+        close_library(library);
+        return false;
+    }
+
+    if (!attach_controller_plugin(get_api(), config, plugin, error)) {
+        close_library(library);
+        return false;
+    }
+    plugin->library = library;
+    return true;
+}
+
+bool attach_controller_plugin(const BiroControllerApi* api,
+                              const BiroControllerConfig& config,
+                              ControllerPlugin* plugin, std::string* error) {
+    *plugin = {};
+    if (api == nullptr || api->abi_version != BIRO_CONTROLLER_ABI_VERSION) {
+        *error = "controller abi version " +
+                 std::to_string(api == nullptr ? 0 : api->abi_version) +
+                 ", expected " + std::to_string(BIRO_CONTROLLER_ABI_VERSION);
+        return false;
+    }
+    if (api->struct_size != sizeof(BiroControllerApi)) {
+        *error = "controller api is " + std::to_string(api->struct_size) +
+                 " bytes, expected " +
+                 std::to_string(sizeof(BiroControllerApi));
+        return false;
+    }
+    if (api->create == nullptr || api->destroy == nullptr ||
+        api->step == nullptr) {
+        *error = "controller api is missing create, destroy or step";
+        return false;
+    }
+
+    void* controller = api->create(&config);
+    if (controller == nullptr) {
+        *error = std::string("could not create controller ") +
+                 get_controller_plugin_name(*api);
+        return false;
+    }
+    plugin->api = api;
+    plugin->controller = controller;
+    plugin->period = config.period;
+    return true;
+}
+
+void unload_controller_plugin(ControllerPlugin* plugin) {
+    if (plugin->controller != nullptr) {
+        plugin->api->destroy(plugin->controller);
+    }
+    if (plugin->library != nullptr) {
+        close_library(plugin->library);
+    }
+    *plugin = {};
+}
+
+void step_controller_plugin_batch(const BiroControllerApi& api,
+                                  void* const* controllers,
+                                  const BiroControllerInputs* inputs,
+                                  BiroControllerOutputs* outputs,
+                                  const int count) {
+    if (api.step_batch != nullptr) {
+        api.step_batch(controllers, inputs, outputs, count);
+        return;
+    }
+    for (int i = 0; i < count; ++i) {
+        api.step(controllers[i], &inputs[i], &outputs[i]);
+    }
+}
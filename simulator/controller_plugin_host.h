@@ -0,0 +1,53 @@
+#pragma once
+
+#include "config/scalar.h"
+#include "controls/controller_plugin.h"
+#include "motor_state.h"
+#include <string>
+
+// A controller loaded from a shared object implementing
+// controls/controller_plugin.h. Copies share the library and the
+// controller, so exactly one of them should be unloaded.
+struct ControllerPlugin {
+    void* library = nullptr; // null when the api is linked into the host
+    const BiroControllerApi* api = nullptr;
+    void* controller = nullptr;
+
+    Scalar period = 1.0 / 10000; // sec
+    Scalar timer = 0;
+    BiroControllerOutputs outputs = {};
+};
+
+BiroControllerConfig get_controller_plugin_config(const Scalar period,
+                                                  const MotorParams& params);
+
+// Opens the shared object and creates a controller with it. On failure
+// returns false with the reason in error, and leaves plugin empty.
+bool load_controller_plugin(const std::string& path,
+                            const BiroControllerConfig& config,
+                            ControllerPlugin* plugin, std::string* error);
+
+// as above, for an api linked into the host
+bool attach_controller_plugin(const BiroControllerApi* api,
+                              const BiroControllerConfig& config,
+                              ControllerPlugin* plugin, std::string* error);
+
+// destroys the controller and closes the library
+void unload_controller_plugin(ControllerPlugin* plugin);
+
+inline bool is_controller_plugin_loaded(const ControllerPlugin& plugin) {
+    return plugin.controller != nullptr;
+}
+
+// plugins need not name themselves
+inline const char* get_controller_plugin_name(const BiroControllerApi& api) {
+    return api.name != nullptr ? api.name : "unnamed controller";
+}
+
+// Steps one controller per lane through the plugin's batched entry point,
+// or its step function when it has none.
+void step_controller_plugin_batch(const BiroControllerApi& api,
+                                  void* const* controllers,
+                                  const BiroControllerInputs* inputs,
+                                  BiroControllerOutputs* outputs,
+                                  const int count);
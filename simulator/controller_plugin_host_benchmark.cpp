@@ -0,0 +1,59 @@
+#include "controller_plugin_host.h"
+#include <benchmark/benchmark.h>
+#include <vector>
+
+// the call overhead of the plugin boundary, with a trivial controller
+
+namespace {
+
+void* create(const BiroControllerConfig*) { return new double(0); }
+
+void destroy(void* controller) { delete static_cast<double*>(controller); }
+
+void step(void* controller, const BiroControllerInputs* inputs,
+          BiroControllerOutputs* outputs) {
+    double& integral = *static_cast<double*>(controller);
+    integral += inputs->desired_torque - inputs->phase_currents[0];
+    outputs->mode = BIRO_CONTROLLER_OUTPUT_DUTIES;
+    outputs->duties[0] = integral;
+}
+
+void step_batch(void* const* controllers, const BiroControllerInputs* inputs,
+                BiroControllerOutputs* outputs, int32_t count) {
+    for (int i = 0; i < count; ++i) {
+        step(controllers[i], &inputs[i], &outputs[i]);
+    }
+}
+
+} // namespace
+
+// items are lane steps
+static void BM_StepControllerPluginBatch(benchmark::State& state) {
+    const bool batched = state.range(0);
+    const int num_lanes = state.range(1);
+    const BiroControllerApi api = {
+        BIRO_CONTROLLER_ABI_VERSION, sizeof(BiroControllerApi), "bench",
+        create, destroy, step, batched ? step_batch : nullptr};
+
+    std::vector<void*> controllers(num_lanes);
+    for (void*& controller : controllers) {
+        controller = api.create(nullptr);
+    }
+    std::vector<BiroControllerInputs> inputs(num_lanes);
+    std::vector<BiroControllerOutputs> outputs(num_lanes);
+    for (auto _ : state) {
+        step_controller_plugin_batch(api, controllers.data(), inputs.data(),
+                                     outputs.data(), num_lanes);
+        benchmark::DoNotOptimize(outputs.data());
+    }
+    state.SetItemsProcessed(state.iterations() * num_lanes);
+    for (void* controller : controllers) {
+        api.destroy(controller);
+    }
+}
+BENCHMARK(BM_StepControllerPluginBatch)
+    ->ArgNames({"batched", "lanes"})
+    ->Args({0, 1})
+    ->Args({1, 1})
+    ->Args({0, 64})
+    ->Args({1, 64});
@@ -0,0 +1,184 @@
+#include "controller_plugin_host.h"
+#include "simulation.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+// counts its steps and drives the gates from the torque command
+struct TestController {
+    int num_steps = 0;
+};
+
+int num_destroyed = 0;
+int num_batch_calls = 0;
+
+void* create(const BiroControllerConfig* config) {
+    return config->period > 0 ? new TestController : nullptr;
+}
+
+void destroy(void* controller) {
+    delete static_cast<TestController*>(controller);
+    ++num_destroyed;
+}
+
+void step(void* controller, const BiroControllerInputs* inputs,
+          BiroControllerOutputs* outputs) {
+    ++static_cast<TestController*>(controller)->num_steps;
+    outputs->mode = inputs->desired_torque < 0 ? BIRO_CONTROLLER_OUTPUT_DUTIES
+                                               : BIRO_CONTROLLER_OUTPUT_GATES;
+    outputs->gates = uint32_t(inputs->desired_torque);
+    for (int i = 0; i < 3; ++i) {
+        outputs->duties[i] = 0.25 * (i + 1);
+    }
+}
+
+void step_batch(void* const* controllers, const BiroControllerInputs* inputs,
+                BiroControllerOutputs* outputs, int32_t count) {
+    ++num_batch_calls;
+    for (int i = 0; i < count; ++i) {
+        step(controllers[i], &inputs[i], &outputs[i]);
+    }
+}
+
+BiroControllerApi get_api(const bool batched) {
+    return {BIRO_CONTROLLER_ABI_VERSION, sizeof(BiroControllerApi), "test",
+            create, destroy, step, batched ? step_batch : nullptr};
+}
+
+BiroControllerConfig get_config() {
+    BiroControllerConfig config = {};
+    config.period = 1e-4;
+    return config;
+}
+
+} // namespace
+
+TEST(load_controller_plugin, reports_missing_library) {
+    ControllerPlugin plugin;
+    std::string error;
+    EXPECT_FALSE(load_controller_plugin("/nonexistent/plugin.so", get_config(),
+                                        &plugin, &error));
+    EXPECT_FALSE(error.empty());
+    EXPECT_FALSE(is_controller_plugin_loaded(plugin));
+}
+
+TEST(load_controller_plugin, loads_example_plugin) {
+    // built alongside, see examples/BUILD
+    ControllerPlugin plugin;
+    std::string error;
+    MotorState motor;
+    init_motor_state(&motor);
+    ASSERT_TRUE(load_controller_plugin(
+        "examples/libfoc_controller_plugin.so",
+        get_controller_plugin_config(1e-4, motor.params), &plugin, &error))
+        << error;
+    EXPECT_STREQ(get_controller_plugin_name(*plugin.api), "foc");
+
+    BiroControllerInputs inputs = {};
+    inputs.bus_voltage = 24;
+    inputs.desired_torque = 0.1;
+    BiroControllerOutputs outputs = {};
+    plugin.api->step(plugin.controller, &inputs, &outputs);
+    EXPECT_EQ(outputs.mode, BIRO_CONTROLLER_OUTPUT_DUTIES);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_GE(outputs.duties[i], 0);
+        EXPECT_LE(outputs.duties[i], 1);
+    }
+    unload_controller_plugin(&plugin);
+    EXPECT_FALSE(is_controller_plugin_loaded(plugin));
+}
+
+TEST(attach_controller_plugin, checks_api) {
+    ControllerPlugin plugin;
+    std::string error;
+
+    BiroControllerApi api = get_api(false);
+    api.abi_version = BIRO_CONTROLLER_ABI_VERSION + 1;
+    EXPECT_FALSE(attach_controller_plugin(&api, get_config(), &plugin, &error));
+    EXPECT_NE(error.find("version"), std::string::npos);
+
+    // built against a header whose layout changed without a version bump
+    api = get_api(false);
+    api.struct_size = sizeof(BiroControllerApi) - sizeof(void*);
+    EXPECT_FALSE(attach_controller_plugin(&api, get_config(), &plugin, &error));
+    EXPECT_NE(error.find("bytes"), std::string::npos);
+
+    api = get_api(false);
+    api.step = nullptr;
+    EXPECT_FALSE(attach_controller_plugin(&api, get_config(), &plugin, &error));
+
+    api = get_api(false);
+    api.name = nullptr;
+    EXPECT_STREQ(get_controller_plugin_name(api), "unnamed controller");
+
+    // create refuses a zero period
+    api = get_api(false);
+    BiroControllerConfig config = get_config();
+    config.period = 0;
+    EXPECT_FALSE(attach_controller_plugin(&api, config, &plugin, &error));
+    EXPECT_FALSE(is_controller_plugin_loaded(plugin));
+
+    ASSERT_TRUE(attach_controller_plugin(&api, get_config(), &plugin, &error));
+    EXPECT_TRUE(is_controller_plugin_loaded(plugin));
+    const int destroyed_before = num_destroyed;
+    unload_controller_plugin(&plugin);
+    EXPECT_EQ(num_destroyed, destroyed_before + 1);
+    EXPECT_FALSE(is_controller_plugin_loaded(plugin));
+}
+
+TEST(step_controller_plugin_batch, steps_every_lane) {
+    for (bool batched : {false, true}) {
+        const BiroControllerApi api = get_api(batched);
+        constexpr int kNumLanes = 8;
+        TestController controllers[kNumLanes];
+        void* contexts[kNumLanes];
+        BiroControllerInputs inputs[kNumLanes] = {};
+        BiroControllerOutputs outputs[kNumLanes] = {};
+        for (int i = 0; i < kNumLanes; ++i) {
+            contexts[i] = &controllers[i];
+            inputs[i].desired_torque = i;
+        }
+
+        const int batch_calls_before = num_batch_calls;
+        step_controller_plugin_batch(api, contexts, inputs, outputs,
+                                     kNumLanes);
+        EXPECT_EQ(num_batch_calls, batch_calls_before + batched);
+        for (int i = 0; i < kNumLanes; ++i) {
+            EXPECT_EQ(controllers[i].num_steps, 1);
+            EXPECT_EQ(outputs[i].gates, uint32_t(i));
+        }
+    }
+}
+
+TEST(step_simulation, runs_plugin_at_its_rate) {
+    SimState state;
+    init_sim_state(&state);
+    state.commutation_mode = kCommutationModePlugin;
+    state.foc_desired_torque = 0b101; // gates, see step above
+
+    const BiroControllerApi api = get_api(false);
+    std::string error;
+    ASSERT_TRUE(attach_controller_plugin(
+        &api, get_controller_plugin_config(1e-4, state.motor.params),
+        &state.controller_plugin, &error));
+
+    TelemetrySample sample;
+    for (int i = 0; i < 1000; ++i) { // 1ms at 1MHz
+        step_simulation(&state, &sample);
+    }
+    const TestController& controller =
+        *static_cast<TestController*>(state.controller_plugin.controller);
+    EXPECT_NEAR(controller.num_steps, 10, 1);
+    EXPECT_EQ(state.board.gate.commanded, 0b101u);
+    EXPECT_EQ(state.board.gate.high, 0b101u);
+
+    // duties go through the pwm
+    state.foc_desired_torque = -1;
+    for (int i = 0; i < 1000; ++i) {
+        step_simulation(&state, &sample);
+    }
+    EXPECT_EQ(state.board.pwm.duties[0], 0.25);
+    EXPECT_EQ(state.board.pwm.duties[2], 0.75);
+
+    unload_controller_plugin(&state.controller_plugin);
+}
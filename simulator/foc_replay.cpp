@@ -0,0 +1,94 @@
+#include "foc_replay.h"
+#include "controls/foc.h"
+#include "motor_state.h"
+#include "util/clarke_transform.h"
+#include "util/numeric_csv.h"
+#include "util/rotation.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+bool load_replay_trace_csv(const std::string& path,
+                           const Scalar default_torque,
+                           std::vector<ReplaySample>* trace) {
+    trace->clear();
+    return read_numeric_csv(
+        path, 5, [&](const Scalar* values, const int num_values) {
+            if (num_values < 4) {
+                return;
+            }
+            ReplaySample sample;
+            sample.electrical_angle = values[0];
+            sample.phase_currents << values[1], values[2], values[3];
+            sample.desired_torque =
+                num_values > 4 ? values[4] : default_torque;
+            trace->push_back(sample);
+        });
+}
+
+void replay_foc(const ReplayParams& params,
+                const std::vector<ReplaySample>& trace,
+                std::vector<ReplayDuties>* duties) {
+    FocState foc = params.foc;
+    duties->resize(trace.size());
+    for (int i = 0; i < int(trace.size()); ++i) {
+        const ReplaySample& sample = trace[i];
+        const std::complex<Scalar> park_transform =
+            get_rotation(-(sample.electrical_angle + kQAxisOffset));
+        const std::complex<Scalar> current_qd =
+            abc_to_qd(sample.phase_currents, park_transform);
+
+        step_foc_current_controller(
+            get_desired_current_qd(sample.desired_torque, params.normed_bEmf0),
+            current_qd, &foc);
+        if (params.anti_windup) {
+            unwind_foc_current_controller(params.bus_voltage, &foc);
+        }
+
+        const std::complex<Scalar> voltage_ab =
+            std::conj(park_transform) * foc.voltage_qd;
+        (*duties)[i] =
+            get_pwm_duties(params.bus_voltage, voltage_ab, params.pwm_strategy,
+                           params.overmodulation_mode);
+    }
+}
+
+bool save_replay_duties(const std::string& path,
+                        const std::vector<ReplayDuties>& duties) {
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(duties.data()),
+               duties.size() * sizeof(ReplayDuties));
+    return bool(file);
+}
+
+bool load_replay_duties(const std::string& path,
+                        std::vector<ReplayDuties>* duties) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+    const std::streamsize size = file.tellg();
+    if (size < 0 || size % sizeof(ReplayDuties) != 0) {
+        return false;
+    }
+    file.seekg(0);
+
+    duties->resize(size / sizeof(ReplayDuties));
+    file.read(reinterpret_cast<char*>(duties->data()),
+              duties->size() * sizeof(ReplayDuties));
+    return bool(file);
+}
+
+int find_first_duty_mismatch(const std::vector<ReplayDuties>& duties,
+                             const std::vector<ReplayDuties>& reference) {
+    const int count = std::min(duties.size(), reference.size());
+    for (int i = 0; i < count; ++i) {
+        // bitwise, so that -0 against 0 or a changed nan counts
+        const int diff =
+            std::memcmp(&duties[i], &reference[i], sizeof(ReplayDuties));
+        if (diff != 0) {
+            return i;
+        }
+    }
+    return duties.size() == reference.size() ? -1 : count;
+}
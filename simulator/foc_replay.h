@@ -0,0 +1,62 @@
+#pragma once
+
+#include "config/scalar.h"
+#include "controls/foc_state.h"
+#include "controls/space_vector_modulation.h"
+#include <Eigen/Dense>
+#include <array>
+#include <string>
+#include <vector>
+
+// Open loop replay of the FOC current controller and the modulator. The
+// recorded currents and angles stand in for the motor, so the controller
+// can be benchmarked alone, and the duties it commands can be compared bit
+// for bit against an earlier build.
+
+// what the controller reads each cycle
+struct ReplaySample {
+    Eigen::Matrix<Scalar, 3, 1> phase_currents =
+        Eigen::Matrix<Scalar, 3, 1>::Zero();
+    Scalar electrical_angle = 0;
+    Scalar desired_torque = 0;
+};
+
+struct ReplayParams {
+    // controller gains and period, and the state it starts from
+    FocState foc;
+    Scalar normed_bEmf0 = 0.01; // see get_desired_current_qd
+    Scalar bus_voltage = 24;
+    bool anti_windup = true;
+    int pwm_strategy = kPwmCentered;
+    int overmodulation_mode = kOvermodulationClip;
+};
+
+using ReplayDuties = std::array<Scalar, 3>;
+
+// Reads "electrical_angle, ia, ib, ic[, desired_torque]" rows, one per
+// controller cycle, see read_numeric_csv. The desired torque is
+// default_torque where the column is missing. Returns false if the file can
+// not be read.
+bool load_replay_trace_csv(const std::string& path,
+                           const Scalar default_torque,
+                           std::vector<ReplaySample>* trace);
+
+// Runs a controller cycle and a pwm update per sample, filling duties with
+// one row per sample. This is step_foc with its default settings: the
+// sinusoidal drive, no qd decoupling and no cogging compensation. The
+// trace holds no rotor speed or back emf shape, which those need.
+void replay_foc(const ReplayParams& params,
+                const std::vector<ReplaySample>& trace,
+                std::vector<ReplayDuties>* duties);
+
+// native doubles, three per sample. Loading fails if the file does not
+// hold a whole number of samples.
+bool save_replay_duties(const std::string& path,
+                        const std::vector<ReplayDuties>& duties);
+bool load_replay_duties(const std::string& path,
+                        std::vector<ReplayDuties>* duties);
+
+// index of the first sample whose duties differ in any bit, the length of
+// the shorter run if one is a prefix of the other, or -1 if identical
+int find_first_duty_mismatch(const std::vector<ReplayDuties>& duties,
+                             const std::vector<ReplayDuties>& reference);
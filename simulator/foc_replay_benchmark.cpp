@@ -0,0 +1,35 @@
+#include "foc_replay.h"
+#include "motor.h"
+#include "util/math_constants.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+
+// throughput of the control stack alone, one item per controller cycle
+static void BM_ReplayFoc(benchmark::State& state) {
+    std::vector<ReplaySample> trace(10000);
+    for (int i = 0; i < int(trace.size()); ++i) {
+        const Scalar angle = std::fmod(0.05 * i, 2 * kPI);
+        trace[i].electrical_angle = angle;
+        for (int k = 0; k < 3; ++k) {
+            trace[i].phase_currents(k) = 2 * std::sin(angle - 2 * kPI * k / 3);
+        }
+        trace[i].desired_torque = 0.1;
+    }
+
+    ReplayParams params;
+    params.foc.i_controller_params =
+        make_motor_pi_params(/*bandwidth=*/10000, /*resistance=*/1,
+                             /*inductance=*/1e-3);
+    params.pwm_strategy = state.range(0);
+
+    std::vector<ReplayDuties> duties;
+    for (auto _ : state) {
+        replay_foc(params, trace, &duties);
+        benchmark::DoNotOptimize(duties.data());
+    }
+    state.SetItemsProcessed(state.iterations() * trace.size());
+}
+BENCHMARK(BM_ReplayFoc)
+    ->ArgName("pwm_strategy")
+    ->Arg(kPwmCentered)
+    ->Arg(kPwmDpwm1);
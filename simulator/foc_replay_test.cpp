@@ -0,0 +1,117 @@
+#include "foc_replay.h"
+#include "motor.h"
+#include "util/math_constants.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+
+namespace {
+
+// currents lagging a rotating rotor, enough to saturate the controller
+std::vector<ReplaySample> get_trace() {
+    std::vector<ReplaySample> trace(1000);
+    for (int i = 0; i < int(trace.size()); ++i) {
+        const Scalar angle = std::fmod(0.05 * i, 2 * kPI);
+        trace[i].electrical_angle = angle;
+        for (int k = 0; k < 3; ++k) {
+            trace[i].phase_currents(k) = 2 * std::sin(angle - 2 * kPI * k / 3);
+        }
+        trace[i].desired_torque = i < 500 ? 0.1 : 1.0;
+    }
+    return trace;
+}
+
+ReplayParams get_params() {
+    ReplayParams params;
+    params.foc.i_controller_params =
+        make_motor_pi_params(/*bandwidth=*/10000, /*resistance=*/1,
+                             /*inductance=*/1e-3);
+    return params;
+}
+
+} // namespace
+
+TEST(replay_foc, commands_valid_duties) {
+    std::vector<ReplayDuties> duties;
+    replay_foc(get_params(), get_trace(), &duties);
+    ASSERT_EQ(duties.size(), 1000);
+    for (const ReplayDuties& row : duties) {
+        for (Scalar duty : row) {
+            // clipped to the rails up to rounding
+            EXPECT_GE(duty, -1e-12);
+            EXPECT_LE(duty, 1 + 1e-12);
+        }
+    }
+}
+
+TEST(replay_foc, bit_exact_between_runs) {
+    const std::vector<ReplaySample> trace = get_trace();
+    std::vector<ReplayDuties> duties;
+    replay_foc(get_params(), trace, &duties);
+    std::vector<ReplayDuties> again;
+    replay_foc(get_params(), trace, &again);
+    EXPECT_EQ(find_first_duty_mismatch(again, duties), -1);
+
+    // a change to the controller shows up
+    ReplayParams params = get_params();
+    params.anti_windup = false;
+    replay_foc(params, trace, &again);
+    EXPECT_GE(find_first_duty_mismatch(again, duties), 0);
+}
+
+TEST(find_first_duty_mismatch, bitwise) {
+    const std::vector<ReplayDuties> reference = {{0.5, 0.25, 0.0},
+                                                 {0.1, 0.2, 0.3}};
+    std::vector<ReplayDuties> duties = reference;
+    duties[1][2] = std::nextafter(duties[1][2], 1.0);
+    EXPECT_EQ(find_first_duty_mismatch(duties, reference), 1);
+
+    duties = reference;
+    duties[0][2] = -0.0;
+    EXPECT_EQ(find_first_duty_mismatch(duties, reference), 0);
+
+    duties = reference;
+    duties.pop_back();
+    EXPECT_EQ(find_first_duty_mismatch(duties, reference), 1);
+}
+
+TEST(replay_duties, save_and_load) {
+    std::vector<ReplayDuties> duties;
+    replay_foc(get_params(), get_trace(), &duties);
+
+    const std::string path = testing::TempDir() + "duties.bin";
+    ASSERT_TRUE(save_replay_duties(path, duties));
+    std::vector<ReplayDuties> loaded;
+    ASSERT_TRUE(load_replay_duties(path, &loaded));
+    EXPECT_EQ(find_first_duty_mismatch(loaded, duties), -1);
+
+    // a partial sample at the end
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::app);
+        file.write("\0", 1);
+    }
+    EXPECT_FALSE(load_replay_duties(path, &loaded));
+    std::remove(path.c_str());
+
+    EXPECT_FALSE(
+        load_replay_duties(testing::TempDir() + "missing.bin", &loaded));
+}
+
+TEST(load_replay_trace_csv, reads_rows) {
+    const std::string path = testing::TempDir() + "replay.csv";
+    {
+        std::ofstream csv(path);
+        csv << "angle, ia, ib, ic, torque\n";
+        csv << "0.5, 1, -0.5, -0.5\n";
+        csv << "0.6, 2, -1, -1, 0.3\n";
+    }
+    std::vector<ReplaySample> trace;
+    ASSERT_TRUE(load_replay_trace_csv(path, /*default_torque=*/0.2, &trace));
+    ASSERT_EQ(trace.size(), 2);
+    EXPECT_EQ(trace[0].electrical_angle, 0.5);
+    EXPECT_EQ(trace[0].phase_currents(1), -0.5);
+    EXPECT_EQ(trace[0].desired_torque, 0.2);
+    EXPECT_EQ(trace[1].desired_torque, 0.3);
+    std::remove(path.c_str());
+}
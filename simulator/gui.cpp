@@ -1,5 +1,7 @@
 #include "gui.h"
+#include "back_emf_fit.h"
 #include "config/scalar.h"
+#include "cogging_torque.h"
 #include "motor.h"
 #include "util/clarke_transform.h"
 #include "util/conversions.h"
@@ -9,7 +11,6 @@
 #include <absl/strings/str_format.h>
 #include <imgui.h>
 #include <implot.h>
-#include <random>
 
 constexpr int kPlotHeight = 250; // sec
 constexpr int kPlotWidth = -1;   // sec
@@ -20,6 +21,11 @@ struct RollingPlotParams {
     int begin;
     Scalar begin_time;
     Scalar end_time;
+    int decimation_mode;
+
+    // while paused, where the history slider has put the sim
+    bool show_scrub_time;
+    Scalar scrub_time;
 };
 
 // This auto scroll implementation is janky
@@ -65,22 +71,34 @@ void implot_update_autoscroll(AutoScroller* ctx) {
 }
 
 RollingPlotParams get_rolling_plot_params(const RollingBuffers& buffers,
-                                          const Scalar rolling_history) {
+                                          const Scalar rolling_history,
+                                          const int decimation_mode,
+                                          const SimState& sim_state) {
 
     RollingPlotParams params;
+    params.decimation_mode = decimation_mode;
+    params.show_scrub_time = sim_state.paused;
+    params.scrub_time = sim_state.time;
 
-    params.count = get_rolling_buffer_count(buffers.ctx);
-    params.begin = get_rolling_buffer_begin(buffers.ctx);
+    params.count = get_rolling_buffer_count(buffers.samples.ctx);
+    params.begin = get_rolling_buffer_begin(buffers.samples.ctx);
     if (params.count != 0) {
-        params.begin_time = buffers.timestamps[params.begin];
+        params.begin_time =
+            get_rolling_buffer_row(buffers.samples, 0)[kTelemetryTime];
         params.end_time =
-            buffers.timestamps[get_rolling_buffer_back(buffers.ctx)];
+            get_rolling_buffer_back_row(buffers.samples)[kTelemetryTime];
     } else {
         // no data to display
         params.begin_time = 0;
         params.end_time = 0;
     }
 
+    // scrubbing further back than the window moves the window along
+    if (params.show_scrub_time &&
+        params.scrub_time < params.end_time - rolling_history) {
+        params.end_time = std::max(params.begin_time + rolling_history,
+                                   params.scrub_time + rolling_history / 2);
+    }
     params.begin_time =
         std::max(params.begin_time, params.end_time - rolling_history);
 
@@ -93,6 +111,106 @@ void init_viz_data(VizData* viz_data) {
         viz_data->circle_xs[i] = std::cos(Scalar(i) / (num_pts - 1) * 2 * kPI);
         viz_data->circle_ys[i] = std::sin(Scalar(i) / (num_pts - 1) * 2 * kPI);
     }
+
+    init_rolling_buffer(kNumRollingPts, &viz_data->rolling_buffers.samples);
+    init_decimation_pyramid(kNumRollingPts, &viz_data->rolling_buffers.pyramid);
+    init_harmonic_analyzer(&viz_data->harmonic_analyzer);
+}
+
+void resize_rolling_buffers(const int num_rolling_pts,
+                            RollingBuffers* buffers) {
+    if (size_t(num_rolling_pts) != buffers->samples.ctx.capacity) {
+        init_rolling_buffer(num_rolling_pts, &buffers->samples);
+        init_decimation_pyramid(num_rolling_pts, &buffers->pyramid);
+    }
+}
+
+void rewind_rolling_buffers(const Scalar time, RollingBuffers* buffers) {
+    const RollingBuffer<TelemetrySample>& samples = buffers->samples;
+    const int count = get_rolling_buffer_count(samples.ctx);
+    if (count == 0 || get_rolling_buffer_back_row(samples)[kTelemetryTime] <
+                          time) {
+        return;
+    }
+
+    // the first sample at or after the time
+    int lo = 0;
+    int hi = count - 1;
+    while (lo < hi) {
+        const int mid = (lo + hi) / 2;
+        if (get_rolling_buffer_row(samples, mid)[kTelemetryTime] < time) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    truncate_rolling_buffer(lo, &buffers->samples);
+    rebuild_decimation_pyramid(buffers->samples, &buffers->pyramid);
+}
+
+// a vertical line across the plot, drawn rather than plotted so it never
+// takes part in fitting the axes
+void draw_scrub_marker(const RollingPlotParams& params) {
+    if (!params.show_scrub_time) {
+        return;
+    }
+    const float x = ImPlot::PlotToPixels(ImPlotPoint(params.scrub_time, 0)).x;
+    const ImVec2 plot_pos = ImPlot::GetPlotPos();
+    ImPlot::PushPlotClipRect();
+    ImGui::GetWindowDrawList()->AddLine(
+        ImVec2(x, plot_pos.y),
+        ImVec2(x, plot_pos.y + ImPlot::GetPlotSize().y),
+        IM_COL32(255, 255, 255, 255));
+    ImPlot::PopPlotClipRect();
+}
+
+// Plots a column of the rolling buffers, call between BeginPlot and EndPlot.
+// Short histories are plotted in place, long histories are decimated to about
+// one point per horizontal pixel. Marks the scrub time while paused.
+void plot_rolling_signal(const char* label, const RollingPlotParams& params,
+                         const RollingBuffers& buffers, const int signal) {
+    draw_scrub_marker(params);
+    const int plot_width = std::max(int(ImPlot::GetPlotSize().x), 1);
+    if (params.count <= 2 * plot_width) {
+        const TelemetrySample* rows = buffers.samples.data.get();
+        ImPlot::PlotLine(label, &rows[0][kTelemetryTime], &rows[0][signal],
+                         params.count, params.begin, sizeof(TelemetrySample));
+        return;
+    }
+
+    static std::vector<Scalar> xs;
+    static std::vector<Scalar> ys;
+    const ImPlotLimits limits = ImPlot::GetPlotLimits();
+    decimate_for_plot(buffers.samples, buffers.pyramid, kTelemetryTime, signal,
+                      limits.X.Min, limits.X.Max, plot_width,
+                      params.decimation_mode, &xs, &ys);
+    ImPlot::PlotLine(label, xs.data(), ys.data(), xs.size());
+}
+
+void update_harmonic_spectra(const MotorState& motor, VizData* viz_data) {
+    const RollingBuffer<TelemetrySample>& buffer =
+        viz_data->rolling_buffers.samples;
+    const int count = get_rolling_buffer_count(buffer.ctx);
+    const int begin = get_rolling_buffer_begin(buffer.ctx);
+    const TelemetrySample* rows = buffer.data.get();
+    const Scalar electrical_freq = motor.kinematic.rotor_angular_vel *
+                                   motor.params.num_pole_pairs / (2 * kPI);
+
+    for (int i = 0; i < 3; ++i) {
+        analyze_harmonics(&viz_data->harmonic_analyzer, electrical_freq,
+                          &rows[0][kTelemetryTime],
+                          &rows[0][kTelemetryPhaseCurrentA + i], count, begin,
+                          sizeof(TelemetrySample),
+                          &viz_data->phase_current_spectra[i]);
+        analyze_harmonics(&viz_data->harmonic_analyzer, electrical_freq,
+                          &rows[0][kTelemetryTime],
+                          &rows[0][kTelemetryBEmfA + i], count, begin,
+                          sizeof(TelemetrySample), &viz_data->bEmf_spectra[i]);
+    }
+    analyze_harmonics(&viz_data->harmonic_analyzer, electrical_freq,
+                      &rows[0][kTelemetryTime], &rows[0][kTelemetryTorque],
+                      count, begin, sizeof(TelemetrySample),
+                      &viz_data->torque_spectrum);
 }
 
 uint32_t get_coil_color(int coil, float alpha) {
@@ -131,10 +249,8 @@ void draw_electrical_plot(const RollingPlotParams& params,
             }
             ImPlot::PushStyleColor(ImPlotCol_Line, get_coil_color(i, 1.0f));
             ImPlot::PushStyleVar(ImPlotStyleVar_LineWeight, 1.0f);
-            ImPlot::PlotLine(absl::StrFormat("Coil %d", i).c_str(),
-                             buffers.timestamps.data(),
-                             buffers.phase_currents[i].data(), params.count,
-                             params.begin, sizeof(Scalar));
+            plot_rolling_signal(absl::StrFormat("Coil %d", i).c_str(), params,
+                                buffers, kTelemetryPhaseCurrentA + i);
             ImPlot::PopStyleVar();
             ImPlot::PopStyleColor();
         }
@@ -150,16 +266,15 @@ void draw_torque_plot(const RollingPlotParams& params,
     ImPlot::SetNextPlotLimitsY(-2, 2, ImGuiCond_Once);
 
     static AutoScroller as;
-    if (get_rolling_buffer_count(buffers.ctx) > 0) {
-        const int last_idx = get_rolling_buffer_back(buffers.ctx);
-        const Scalar last_torque = buffers.torque[last_idx];
+    if (get_rolling_buffer_count(buffers.samples.ctx) > 0) {
+        const Scalar last_torque =
+            get_rolling_buffer_back_row(buffers.samples)[kTelemetryTorque];
         implot_autoscroll_next_plot(last_torque, &as);
     }
 
     if (ImPlot::BeginPlot("Torque", "Seconds", "N . m",
                           ImVec2(kPlotWidth, kPlotHeight))) {
-        ImPlot::PlotLine("", buffers.timestamps.data(), buffers.torque.data(),
-                         params.count, params.begin, sizeof(Scalar));
+        plot_rolling_signal("", params, buffers, kTelemetryTorque);
 
         implot_update_autoscroll(&as);
         ImPlot::EndPlot();
@@ -173,17 +288,15 @@ void draw_power_plot(const RollingPlotParams& params,
     ImPlot::SetNextPlotLimitsY(-2, 2, ImGuiCond_Once);
 
     static AutoScroller as;
-    if (get_rolling_buffer_count(buffers.ctx) > 0) {
-        const int last_idx = get_rolling_buffer_back(buffers.ctx);
-        const Scalar last_torque = buffers.power_draw[last_idx];
-        implot_autoscroll_next_plot(last_torque, &as);
+    if (get_rolling_buffer_count(buffers.samples.ctx) > 0) {
+        const Scalar last_power =
+            get_rolling_buffer_back_row(buffers.samples)[kTelemetryPowerDraw];
+        implot_autoscroll_next_plot(last_power, &as);
     }
 
     if (ImPlot::BeginPlot("Power Draw", "Seconds", "Watts",
                           ImVec2(kPlotWidth, kPlotHeight))) {
-        ImPlot::PlotLine("", buffers.timestamps.data(),
-                         buffers.power_draw.data(), params.count, params.begin,
-                         sizeof(Scalar));
+        plot_rolling_signal("", params, buffers, kTelemetryPowerDraw);
 
         implot_update_autoscroll(&as);
         ImPlot::EndPlot();
@@ -198,18 +311,16 @@ void draw_rotor_angular_vel_plot(const RollingPlotParams& params,
     ImPlot::SetNextPlotLimitsY(-10, 10, ImGuiCond_Once);
 
     static AutoScroller as;
-    if (get_rolling_buffer_count(buffers.ctx) > 0) {
-        const int last_idx = get_rolling_buffer_back(buffers.ctx);
-        const Scalar last_angular_vel = buffers.rotor_angular_vel[last_idx];
+    if (get_rolling_buffer_count(buffers.samples.ctx) > 0) {
+        const Scalar last_angular_vel = get_rolling_buffer_back_row(
+            buffers.samples)[kTelemetryRotorAngularVel];
         implot_autoscroll_next_plot(last_angular_vel, &as);
     }
 
     if (ImPlot::BeginPlot("Rotor Angular Vel", "Seconds", "Radians / Sec",
                           ImVec2(kPlotWidth, kPlotHeight))) {
 
-        ImPlot::PlotLine("", buffers.timestamps.data(),
-                         buffers.rotor_angular_vel.data(), params.count,
-                         params.begin, sizeof(Scalar));
+        plot_rolling_signal("", params, buffers, kTelemetryRotorAngularVel);
 
         implot_update_autoscroll(&as);
 
@@ -217,81 +328,17 @@ void draw_rotor_angular_vel_plot(const RollingPlotParams& params,
     }
 }
 
-void update_rolling_buffers(const Scalar time, const BoardState& board,
-                            const MotorState& motor, const FocState& foc,
-                            RollingBuffers* buffers) {
-    const int next_idx = buffers->ctx.next_idx;
-
-    buffers->timestamps[next_idx] = time;
-
-    const Eigen::Matrix<Scalar, 3, 1> pole_voltages = get_pole_voltages(
-        board.bus_voltage, motor.electrical.phase_currents, board.gate);
-
-    const Eigen::Matrix<Scalar, 3, 1> phase_voltages =
-        get_phase_voltages(pole_voltages, motor.electrical.bEmfs);
-
-    for (int i = 0; i < 3; ++i) {
-        buffers->phase_vs[i][next_idx] = phase_voltages(i);
-
-        buffers->phase_currents[i][next_idx] =
-            motor.electrical.phase_currents(i);
-
-        buffers->bEmfs[i][next_idx] = motor.electrical.bEmfs(i);
-
-        buffers->normed_bEmfs[i][next_idx] = motor.electrical.normed_bEmfs(i);
-
-        buffers->pwm_duties[i][next_idx] = board.pwm.duties[i];
-
-        buffers->pwm_level[next_idx] = board.pwm.level;
-
-        Scalar gate_state = board.gate.actual[i];
-        if (gate_state == OFF) {
-            // map the indeterminate state to -0.5
-            gate_state = -0.5;
-        }
-        buffers->gate_states[i][next_idx] = gate_state;
-
-        // Project current onto qd axes
-        {
-            const Scalar q_axis_electrical_angle = get_q_axis_electrical_angle(
-                motor.params.num_pole_pairs, motor.kinematic.rotor_angle);
-            const std::complex<Scalar> park_transform =
-                get_rotation(-q_axis_electrical_angle);
-            const std::complex<Scalar> current_qd =
-                park_transform *
-                clarke_transform(motor.electrical.phase_currents);
-            buffers->current_q[next_idx] = current_qd.real();
-            buffers->current_d[next_idx] = current_qd.imag();
-        }
-
-        buffers->current_q_err[next_idx] = foc.iq_controller.err;
-
-        buffers->current_q_integral[next_idx] = foc.iq_controller.integral;
-
-        buffers->current_d_err[next_idx] = foc.id_controller.err;
-
-        buffers->current_d_integral[next_idx] = foc.id_controller.integral;
-    }
-
-    // power calculation
-    {
-        // power is v*i for all i's that are flowing into the gates
-        Scalar power_draw = 0;
-        for (int i = 0; i < 3; ++i) {
-            if (board.gate.actual[i] == HIGH) {
-                power_draw +=
-                    board.bus_voltage * motor.electrical.phase_currents(i);
-            }
-        }
-        buffers->power_draw[next_idx] = power_draw;
-    }
-
-    buffers->current_d_integral[next_idx] = foc.id_controller.integral;
-
-    buffers->rotor_angular_vel[next_idx] = motor.kinematic.rotor_angular_vel;
-    buffers->torque[next_idx] = motor.kinematic.torque;
+void update_rolling_buffers(const SimState& state, RollingBuffers* buffers) {
+    TelemetrySample sample;
+    get_telemetry_sample(state.time, state.board, state.motor, state.foc,
+                         state.outputs, &sample);
+    push_rolling_buffers(sample, buffers);
+}
 
-    rolling_buffer_advance_idx(&buffers->ctx);
+void push_rolling_buffers(const TelemetrySample& sample,
+                          RollingBuffers* buffers) {
+    rolling_buffer_push(sample, &buffers->samples);
+    decimation_pyramid_push(sample, &buffers->pyramid);
 }
 
 void draw_pwm_plot(const RollingPlotParams& params,
@@ -302,16 +349,12 @@ void draw_pwm_plot(const RollingPlotParams& params,
     if (ImPlot::BeginPlot("PWM", "Seconds", "",
                           ImVec2(kPlotWidth, kPlotHeight))) {
         for (int i = 0; i < 3; ++i) {
-            ImPlot::PlotLine(absl::StrFormat("Gate %d", i).c_str(),
-                             buffers.timestamps.data(),
-                             buffers.pwm_duties[i].data(), params.count,
-                             params.begin, sizeof(Scalar));
+            plot_rolling_signal(absl::StrFormat("Gate %d", i).c_str(), params,
+                                buffers, kTelemetryPwmDutyA + i);
         }
         ImPlot::PushStyleColor(ImPlotCol_Line,
                                (uint32_t)ImColor(1.0f, 1.0f, 1.0f, 0.2));
-        ImPlot::PlotLine("Level", buffers.timestamps.data(),
-                         buffers.pwm_level.data(), params.count, params.begin,
-                         sizeof(Scalar));
+        plot_rolling_signal("Level", params, buffers, kTelemetryPwmLevel);
         ImPlot::PopStyleColor();
 
         ImPlot::EndPlot();
@@ -325,7 +368,7 @@ void draw_gate_plot(const RollingPlotParams& params,
                                ImGuiCond_Always);
     ImPlot::SetNextPlotLimitsY(-0.6, 1.1, ImGuiCond_Always);
 
-    // this mapping is established in update_rolling_buffers
+    // this mapping is established in get_telemetry_sample
     static double yticks[] = {-0.5, 0, 1};
     static const char* ylabels[] = {"OFF", "LOW", "HIGH"};
     ImPlot::SetNextPlotTicksY(yticks, 3, ylabels);
@@ -333,10 +376,8 @@ void draw_gate_plot(const RollingPlotParams& params,
     if (ImPlot::BeginPlot("Gate States", "Seconds", "",
                           ImVec2(kPlotWidth, kPlotHeight))) {
         for (int i = 0; i < 3; ++i) {
-            ImPlot::PlotLine(absl::StrFormat("Gate %d", i).c_str(),
-                             buffers.timestamps.data(),
-                             buffers.gate_states[i].data(), params.count,
-                             params.begin, sizeof(Scalar));
+            plot_rolling_signal(absl::StrFormat("Gate %d", i).c_str(), params,
+                                buffers, kTelemetryGateStateA + i);
         }
         ImPlot::EndPlot();
     }
@@ -349,13 +390,8 @@ void draw_current_qd_plot(const RollingPlotParams& params,
 
     if (ImPlot::BeginPlot("Current qd", "Seconds", nullptr,
                           ImVec2(kPlotWidth, kPlotHeight))) {
-        ImPlot::PlotLine("iq", buffers.timestamps.data(),
-                         buffers.current_q.data(), params.count, params.begin,
-                         sizeof(Scalar));
-
-        ImPlot::PlotLine("id", buffers.timestamps.data(),
-                         buffers.current_d.data(), params.count, params.begin,
-                         sizeof(Scalar));
+        plot_rolling_signal("iq", params, buffers, kTelemetryCurrentQ);
+        plot_rolling_signal("id", params, buffers, kTelemetryCurrentD);
         ImPlot::EndPlot();
     }
 }
@@ -367,13 +403,10 @@ void draw_current_qd_err_plot(const RollingPlotParams& params,
     ImPlot::SetNextPlotLimitsY(-1, 1, ImGuiCond_Once);
     if (ImPlot::BeginPlot("Current Controller Errors", "Seconds", nullptr,
                           ImVec2(kPlotWidth, kPlotHeight))) {
-        ImPlot::PlotLine("iq error", buffers.timestamps.data(),
-                         buffers.current_q_err.data(), params.count,
-                         params.begin, sizeof(Scalar));
-
-        ImPlot::PlotLine("id error", buffers.timestamps.data(),
-                         buffers.current_d_err.data(), params.count,
-                         params.begin, sizeof(Scalar));
+        plot_rolling_signal("iq error", params, buffers,
+                            kTelemetryCurrentQErr);
+        plot_rolling_signal("id error", params, buffers,
+                            kTelemetryCurrentDErr);
         ImPlot::EndPlot();
     }
 }
@@ -386,13 +419,10 @@ void draw_current_qd_integral_plot(const RollingPlotParams& params,
 
     if (ImPlot::BeginPlot("Current Controller Integrals", "Seconds", nullptr,
                           ImVec2(kPlotWidth, kPlotHeight))) {
-        ImPlot::PlotLine("iq int", buffers.timestamps.data(),
-                         buffers.current_q_integral.data(), params.count,
-                         params.begin, sizeof(Scalar));
-
-        ImPlot::PlotLine("id int", buffers.timestamps.data(),
-                         buffers.current_d_integral.data(), params.count,
-                         params.begin, sizeof(Scalar));
+        plot_rolling_signal("iq int", params, buffers,
+                            kTelemetryCurrentQIntegral);
+        plot_rolling_signal("id int", params, buffers,
+                            kTelemetryCurrentDIntegral);
         ImPlot::EndPlot();
     }
 }
@@ -459,9 +489,7 @@ void draw_space_vector_plot(const SimState& state, VizOptions* options) {
                           ImPlotAxisFlags_Default &
                               ~ImPlotAxisFlags_TickLabels)) {
 
-        const Scalar electrical_angle =
-            get_electrical_angle(state.motor.params.num_pole_pairs,
-                                 state.motor.kinematic.rotor_angle);
+        const Scalar electrical_angle = state.outputs.electrical_angle;
         ImPlot::PushStyleColor(ImPlotCol_Line,
                                (uint32_t)ImColor(1.0f, 1.0f, 1.0f, 1.0));
         implot_radial_line("Rotor Angle", 0.0f, 1.0f,
@@ -471,11 +499,8 @@ void draw_space_vector_plot(const SimState& state, VizOptions* options) {
         const std::complex<Scalar> park_transform =
             get_rotation(-electrical_angle);
 
-        const Eigen::Matrix<Scalar, 3, 1> pole_voltages = get_pole_voltages(
-            state.board.bus_voltage, state.motor.electrical.phase_currents,
-            state.board.gate);
-
-        std::complex<Scalar> pole_voltage_sv = clarke_transform(pole_voltages);
+        std::complex<Scalar> pole_voltage_sv =
+            clarke_transform(state.outputs.pole_voltages);
 
         if (options->use_rotor_frame) {
             pole_voltage_sv *= park_transform;
@@ -531,6 +556,258 @@ void draw_space_vector_plot(const SimState& state, VizOptions* options) {
     }
 }
 
+void draw_missing_spectrum(const HarmonicSpectrum& spectrum) {
+    if (spectrum.undersampled) {
+        ImGui::Text("History too sparse for the harmonics, "
+                    "try recording every step");
+    } else {
+        ImGui::Text("Not enough history for an electrical period");
+    }
+}
+
+void draw_harmonic_analysis(const VizData& viz_data, VizOptions* options) {
+    ImGui::RadioButton("Phase Currents", &options->harmonic_signal, 0);
+    ImGui::SameLine();
+    ImGui::RadioButton("Torque", &options->harmonic_signal, 1);
+    ImGui::SameLine();
+    ImGui::RadioButton("bEmfs", &options->harmonic_signal, 2);
+
+    if (options->harmonic_signal == 1) {
+        const HarmonicSpectrum& spectrum = viz_data.torque_spectrum;
+        if (spectrum.num_periods == 0) {
+            draw_missing_spectrum(spectrum);
+            return;
+        }
+        ImGui::Text("Torque Ripple %f (%d periods)", spectrum.ripple,
+                    spectrum.num_periods);
+        if (ImPlot::BeginPlot("Torque Harmonics", "Harmonic", "N . m",
+                              ImVec2(kPlotWidth, kPlotHeight))) {
+            // skip the dc component, which dwarfs the ripple
+            ImPlot::PlotBars("", spectrum.magnitudes.data() + 1,
+                             spectrum.magnitudes.size() - 1, 0.67, 1);
+            ImPlot::EndPlot();
+        }
+        return;
+    }
+
+    const std::array<HarmonicSpectrum, 3>& spectra =
+        options->harmonic_signal == 0 ? viz_data.phase_current_spectra
+                                      : viz_data.bEmf_spectra;
+    if (spectra[0].num_periods == 0) {
+        draw_missing_spectrum(spectra[0]);
+        return;
+    }
+    for (int i = 0; i < 3; ++i) {
+        ImGui::Text("Coil %d THD %f", i, spectra[i].thd);
+    }
+    if (ImPlot::BeginPlot("Harmonics", "Harmonic",
+                          options->harmonic_signal == 0 ? "Amperes" : "Volts",
+                          ImVec2(kPlotWidth, kPlotHeight))) {
+        for (int i = 0; i < 3; ++i) {
+            ImPlot::PushStyleColor(ImPlotCol_Fill, get_coil_color(i, 0.5f));
+            ImPlot::PlotBars(absl::StrFormat("Coil %d", i).c_str(),
+                             spectra[i].magnitudes.data(),
+                             spectra[i].magnitudes.size(), 0.25,
+                             (i - 1) * 0.25);
+            ImPlot::PopStyleColor();
+        }
+        ImPlot::EndPlot();
+    }
+}
+
+void draw_telemetry_stats(TelemetryStats* stats) {
+    static bool show_last_cycle = false;
+    if (ImGui::Button("Reset")) {
+        reset_telemetry_stats(stats);
+    }
+    ImGui::SameLine();
+    ImGui::Checkbox("Last Electrical Cycle Only", &show_last_cycle);
+
+    ImGui::Columns(7);
+    for (const char* header :
+         {"Signal", "Mean", "Std Dev", "RMS", "Min", "Max", "Peak-Peak"}) {
+        ImGui::Text(header);
+        ImGui::NextColumn();
+    }
+    ImGui::Separator();
+
+    for (int i = 0; i < kNumTelemetrySignals; ++i) {
+        const OnlineStats& signal_stats = show_last_cycle
+                                              ? stats->signals[i].last_cycle
+                                              : stats->signals[i].total;
+        ImGui::Text(kTelemetrySignalNames[i]);
+        ImGui::NextColumn();
+        if (signal_stats.count == 0) {
+            for (int col = 1; col < 7; ++col) {
+                ImGui::Text("-");
+                ImGui::NextColumn();
+            }
+            continue;
+        }
+        for (const Scalar value :
+             {signal_stats.mean, get_std_dev(signal_stats),
+              get_rms(signal_stats), signal_stats.min, signal_stats.max,
+              get_peak_to_peak(signal_stats)}) {
+            ImGui::Text("%g", value);
+            ImGui::NextColumn();
+        }
+    }
+    ImGui::Columns(1);
+}
+
+// publishes every step to shared memory, for ipc/tail_telemetry and
+// other local tools
+void draw_telemetry_feed(TelemetryFeedWriter* feed) {
+    static char name[64] = "/biro_telemetry";
+    static int capacity = 1 << 16;
+    static std::string error;
+    ImGui::InputText("Feed Name", name, sizeof(name));
+    ImGui::InputInt("Ring Samples", &capacity);
+    if (ImGui::Button("Publish")) {
+        close_telemetry_feed(feed);
+        error.clear();
+        create_telemetry_feed(name,
+                              std::vector<std::string>(
+                                  kTelemetrySignalNames.begin(),
+                                  kTelemetrySignalNames.end()),
+                              capacity, feed, &error);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Stop")) {
+        close_telemetry_feed(feed);
+    }
+    if (is_telemetry_feed_open(*feed)) {
+        ImGui::Text("Publishing %s, %lu samples", feed->memory.name.c_str(),
+                    (unsigned long)feed->header->end_count.load());
+    } else if (!error.empty()) {
+        ImGui::Text("%s", error.c_str());
+    }
+}
+
+// streams to clients such as ipc/telemetry_client
+void draw_telemetry_server(TelemetryServer* server) {
+    static char path[108] = "/tmp/biro_telemetry.sock";
+    static std::string error;
+    ImGui::InputText("Socket Path", path, sizeof(path));
+    if (ImGui::Button("Listen")) {
+        stop_telemetry_server(server);
+        error.clear();
+        start_telemetry_server(path,
+                               std::vector<std::string>(
+                                   kTelemetrySignalNames.begin(),
+                                   kTelemetrySignalNames.end()),
+                               server, &error);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Stop##server")) {
+        stop_telemetry_server(server);
+    }
+    if (is_telemetry_server_running(*server)) {
+        ImGui::Text("Listening on %s", server->path.c_str());
+        for (const TelemetrySubscriber& subscriber : server->subscribers) {
+            ImGui::Text("Client %d: decimation %u, %lu dropped",
+                        subscriber.fd, subscriber.decimation,
+                        (unsigned long)subscriber.num_dropped);
+        }
+    } else if (!error.empty()) {
+        ImGui::Text("%s", error.c_str());
+    }
+}
+
+struct ScopeTrace {
+    const TelemetrySample* samples;
+    int signal;
+    Scalar trigger_time;
+};
+
+ImPlotPoint get_scope_trace_point(void* data, int idx) {
+    const ScopeTrace& trace = *static_cast<const ScopeTrace*>(data);
+    const TelemetrySample& sample = trace.samples[idx];
+    // usec relative to the trigger
+    return ImPlotPoint((sample[kTelemetryTime] - trace.trigger_time) * 1e6,
+                       sample[trace.signal]);
+}
+
+void draw_scope(TriggerCapture<TelemetrySample>* scope) {
+    TriggerParams& params = scope->params; // convenience ref
+
+    ImGui::Combo("Trigger Signal", &params.signal,
+                 kTelemetrySignalNames.data(), kNumTelemetrySignals);
+
+    ImGui::RadioButton("Rising", &params.condition, kTriggerRisingEdge);
+    ImGui::SameLine();
+    ImGui::RadioButton("Falling", &params.condition, kTriggerFallingEdge);
+    ImGui::SameLine();
+    ImGui::RadioButton("Either", &params.condition, kTriggerEitherEdge);
+    ImGui::SameLine();
+    ImGui::RadioButton("Above", &params.condition, kTriggerAboveLevel);
+    ImGui::SameLine();
+    ImGui::RadioButton("Below", &params.condition, kTriggerBelowLevel);
+    ImGui::SameLine();
+    ImGui::RadioButton("Enter Window", &params.condition,
+                       kTriggerEnterWindow);
+    ImGui::SameLine();
+    ImGui::RadioButton("Exit Window", &params.condition, kTriggerExitWindow);
+
+    ImGui::InputDouble("Level", &params.level);
+    if (params.condition == kTriggerEnterWindow ||
+        params.condition == kTriggerExitWindow) {
+        ImGui::InputDouble("Level High", &params.level_high);
+    }
+
+    ImGui::SliderInt("Pre-trigger Steps", &params.pre_trigger_samples, 0,
+                     100000);
+    ImGui::SliderInt("Post-trigger Steps", &params.post_trigger_samples, 1,
+                     100000);
+    ImGui::Checkbox("Auto Re-arm", &params.auto_rearm);
+    if (scope->status != kTriggerIdle) {
+        ImGui::Text("Trigger changes apply from the next arm");
+    }
+
+    if (scope->status == kTriggerIdle) {
+        if (ImGui::Button("Arm")) {
+            arm_trigger_capture(scope);
+        }
+    } else {
+        if (ImGui::Button("Stop")) {
+            disarm_trigger_capture(scope);
+        }
+    }
+    ImGui::SameLine();
+    const char* status_names[] = {"Idle", "Armed", "Capturing"};
+    ImGui::Text("%s, %d captures", status_names[scope->status],
+                scope->num_captures);
+
+    static std::array<int, 3> trace_signals = {kTelemetryPhaseCurrentA,
+                                               kTelemetryPhaseCurrentB,
+                                               kTelemetryPhaseCurrentC};
+    for (int i = 0; i < int(trace_signals.size()); ++i) {
+        ImGui::Combo(absl::StrFormat("Trace %d", i).c_str(), &trace_signals[i],
+                     kTelemetrySignalNames.data(), kNumTelemetrySignals);
+    }
+
+    if (scope->snapshot.empty()) {
+        return;
+    }
+
+    const Scalar trigger_time =
+        scope->snapshot[scope->snapshot_trigger_idx][kTelemetryTime];
+    ImPlot::SetNextPlotLimitsX(
+        (scope->snapshot.front()[kTelemetryTime] - trigger_time) * 1e6,
+        (scope->snapshot.back()[kTelemetryTime] - trigger_time) * 1e6,
+        ImGuiCond_Always);
+    if (ImPlot::BeginPlot("Triggered Capture", "usec from trigger", nullptr,
+                          ImVec2(kPlotWidth, kPlotHeight))) {
+        for (const int signal : trace_signals) {
+            ScopeTrace trace{scope->snapshot.data(), signal, trigger_time};
+            ImPlot::PlotLine(kTelemetrySignalNames[signal],
+                             get_scope_trace_point, &trace,
+                             scope->snapshot.size());
+        }
+        ImPlot::EndPlot();
+    }
+}
+
 bool order_of_magnitude_control(const char* label, Scalar* controllee,
                                 const int exp_min = -4, const int exp_max = 4) {
     bool interacted = false;
@@ -581,69 +858,129 @@ bool ScaledSlider(const Scalar scale, const char* label, Scalar* scalar,
     return interacted;
 }
 
-void run_advanced_motor_config(MotorState* motor_ptr) {
+void run_advanced_motor_config(const uint64_t seed, MotorState* motor_ptr,
+                               RandomStream* cogging_rng) {
     MotorState& motor = *motor_ptr; // convenience ref
 
     if (ImGui::BeginTabBar("##Advanced Motor Control Options")) {
         if (ImGui::BeginTabItem("Back EMF Curve")) {
-            ImGui::Text(
-                "normed_bEmf(e) =  overal_scale * (a1 sin(e) + a3 sin(3e) "
-                "+ a5 sin(5e) + a7 "
-                "sin(7e) + a9 sin(9e))");
-
-            const auto to_gui_scale =
-                [](const Eigen::Matrix<Scalar, 5, 1>& in) {
-                    Eigen::Matrix<Scalar, 5, 1> out = in;
-                    for (int i = 1; i < out.size(); ++i) {
-                        out(i) /= in(0);
+            BEmfCoeffs& coeffs = motor.params.normed_bEmf_coeffs;
+            int& series = motor.params.normed_bEmf_series;
+
+            ImGui::Text("normed_bEmf(e) =  overal_scale * (a1 sin(e) + "
+                        "sum_h ah sin(h e))");
+
+            bool even_harmonics = series == kSineSeriesAll;
+            if (ImGui::Checkbox("Even Harmonics", &even_harmonics)) {
+                // keep each coefficient on its harmonic
+                const BEmfCoeffs old_coeffs = coeffs;
+                const int old_series = series;
+                series = even_harmonics ? kSineSeriesAll : kSineSeriesOdd;
+                coeffs.setZero(
+                    even_harmonics
+                        ? std::min<int>(2 * old_coeffs.size() - 1,
+                                        kMaxBEmfCoeffs)
+                        : (old_coeffs.size() + 1) / 2);
+                for (int i = 0; i < old_coeffs.size(); ++i) {
+                    const int h = get_sine_series_harmonic(old_series, i);
+                    const int j = series == kSineSeriesAll ? h - 1 : h / 2;
+                    if (j < coeffs.size() &&
+                        get_sine_series_harmonic(series, j) == h) {
+                        coeffs(j) = old_coeffs(i);
                     }
-                    return out;
-                };
-
-            const auto from_gui_scale =
-                [](const Eigen::Matrix<Scalar, 5, 1>& in) {
-                    Eigen::Matrix<Scalar, 5, 1> out = in;
-                    for (int i = 1; i < out.size(); ++i) {
-                        out(i) *= in(0);
-                    }
-                    return out;
-                };
+                }
+            }
+
+            int num_coeffs = coeffs.size();
+            if (ImGui::SliderInt("Num Coefficients", &num_coeffs, 1,
+                                 kMaxBEmfCoeffs)) {
+                const int old_size = coeffs.size();
+                coeffs.conservativeResize(num_coeffs);
+                for (int i = old_size; i < num_coeffs; ++i) {
+                    coeffs(i) = 0;
+                }
+            }
 
-            Eigen::Matrix<Scalar, 5, 1> gui_scale =
-                to_gui_scale(motor.params.normed_bEmf_coeffs);
+            const auto to_gui_scale = [](const BEmfCoeffs& in) {
+                BEmfCoeffs out = in;
+                for (int i = 1; i < out.size(); ++i) {
+                    out(i) /= in(0);
+                }
+                return out;
+            };
+
+            const auto from_gui_scale = [](const BEmfCoeffs& in) {
+                BEmfCoeffs out = in;
+                for (int i = 1; i < out.size(); ++i) {
+                    out(i) *= in(0);
+                }
+                return out;
+            };
+
+            BEmfCoeffs gui_scale = to_gui_scale(coeffs);
 
             ImGui::Text("Presets");
             ImGui::SameLine();
             if (ImGui::Button("Sine Wave")) {
-                gui_scale.tail<4>().setZero();
+                gui_scale.tail(gui_scale.size() - 1).setZero();
             }
             ImGui::SameLine();
             if (ImGui::Button("Trapezoid")) {
-                gui_scale(1) = 0.278;
-                gui_scale(2) = 0.119;
-                gui_scale(3) = 0.053;
-                gui_scale(4) = 0.029;
+                for (int i = 1; i < gui_scale.size(); ++i) {
+                    switch (get_sine_series_harmonic(series, i)) {
+                    case 3:
+                        gui_scale(i) = 0.278;
+                        break;
+                    case 5:
+                        gui_scale(i) = 0.119;
+                        break;
+                    case 7:
+                        gui_scale(i) = 0.053;
+                        break;
+                    case 9:
+                        gui_scale(i) = 0.029;
+                        break;
+                    default:
+                        gui_scale(i) = 0;
+                    }
+                }
             }
 
             ScaledSlider(1000, "overall_scale * 1000", &gui_scale(0), 1, 500);
 
             // additional harmonics
-            for (int i = 1; i < 5; ++i) {
-                Slider(absl::StrFormat("a%d", 2 * i + 1).c_str(), &gui_scale(i),
-                       0, 1);
+            for (int i = 1; i < gui_scale.size(); ++i) {
+                const int h = get_sine_series_harmonic(series, i);
+                Slider(absl::StrFormat("a%d", h).c_str(), &gui_scale(i), 0, 1);
             }
 
-            motor.params.normed_bEmf_coeffs = from_gui_scale(gui_scale);
+            coeffs = from_gui_scale(gui_scale);
+
+            // fits the current series and number of coefficients
+            static char path[256] = "";
+            ImGui::InputText("Measured Back Emf", path, sizeof(path));
+            static double measured_vel = 1;
+            ImGui::InputDouble("Measured At (elec rad/s)", &measured_vel);
+            static bool fit_failed = false;
+            static double rms_residual = 0;
+            if (ImGui::Button("Fit From CSV")) {
+                fit_failed =
+                    !import_bEmf_csv(path, measured_vel, series, coeffs.size(),
+                                     &motor.params, &rms_residual);
+            }
+            ImGui::SameLine();
+            if (fit_failed) {
+                ImGui::Text("Could not fit %s", path);
+            } else {
+                ImGui::Text("rms residual %g", rms_residual);
+            }
 
             constexpr int kNumSamples = 1000;
             static std::array<Scalar, kNumSamples> angles;
             static std::array<Scalar, kNumSamples> samples;
             for (int i = 0; i < kNumSamples; ++i) {
                 const Scalar angle = 2 * kPI * Scalar(i) / kNumSamples;
-                Eigen::Matrix<Scalar, 5, 1> odd_sine_series;
-                generate_odd_sine_series(5, angle, odd_sine_series.data());
-                samples[i] =
-                    odd_sine_series.dot(motor.params.normed_bEmf_coeffs);
+                samples[i] = get_normed_bEmf(coeffs, series, angle);
                 angles[i] = angle;
             }
 
@@ -665,97 +1002,57 @@ void run_advanced_motor_config(MotorState* motor_ptr) {
 
         if (ImGui::BeginTabItem("Cogging Torque")) {
 
-            // convenience reference
-            auto& cogging_torque_map = motor.params.cogging_torque_map;
+            // edits build a new map, which replaces the shared one
+            std::vector<Scalar> new_map;
+            bool map_changed = false;
 
             if (ImGui::Button("Set Cogging Torque to Zero")) {
-                cogging_torque_map = {};
+                new_map.assign(motor.params.cogging_torque_map->size(), 0);
+                map_changed = true;
             }
 
-            if (ImGui::Button("Generate Random Cogging Torque Map")) {
-                std::random_device rd{};
-                std::mt19937 gen{rd()};
-                std::normal_distribution<> d{0, 1};
-
-                // cos terms are even idx
-                // sin terms are odd idx
-                std::array<Scalar, 12> fourier_coeffs;
-                // arbitrarily choose some frequencies that might be dominant in
-                // the cogging map, plus some fuding to make it look interesting
-                const int p = motor.params.num_pole_pairs;
-                std::array<int, 6> fourier_frequencies{
-                    1, p, p * 2 + 1, p * 3 + 2, p * 7 + 3, p * 10 + 4};
-
-                std::array<Scalar, 6> fourier_frequencies_scale{0.5, 1.5, 1.0,
-                                                                1.5, 0.5, 0.25};
-
-                for (int i = 0; i < 12; ++i) {
-                    fourier_coeffs[i] =
-                        d(gen) * fourier_frequencies_scale[i / 2];
-                }
-
-                for (int i = 0; i < cogging_torque_map.size(); ++i) {
-                    const Scalar progress =
-                        Scalar(i) / cogging_torque_map.size();
-                    Scalar val = 0;
-                    for (int n = 0; n < 6; ++n) {
-                        const Scalar k1 = fourier_coeffs[2 * n];
-                        const Scalar k2 = fourier_coeffs[2 * n + 1];
-                        const Scalar c = std::cos(progress * 2 * kPI *
-                                                  fourier_frequencies[n]);
-                        const Scalar s = std::sin(progress * 2 * kPI *
-                                                  fourier_frequencies[n]);
-                        val += k1 * c + k2 * s;
-                    }
-                    cogging_torque_map[i] = val;
-                }
+            static int resolution = kDefaultCoggingMapResolution;
+            ImGui::SliderInt("Map Resolution", &resolution, 36, 36000);
 
-                // // the first entry must equal the last entry
-                // // so de-slope everything
-                // const Scalar slope =
-                //     (cogging_torque_map.back() - cogging_torque_map[0]) /
-                //     cogging_torque_map.size();
-                // for (int i = 0; i < cogging_torque_map.size(); ++i) {
-                //     cogging_torque_map[i] -= slope * i;
-                // }
-
-                // // the integral of all cogging torque needs to be zero for
-                // energy
-                // // conservation, and then scaled to a realistic max torque
-                // value Scalar avg = 0; for (int i = 0; i <
-                // cogging_torque_map.size(); ++i) {
-                //     avg += cogging_torque_map[i];
-                // }
-                // avg /= cogging_torque_map.size();
-
-                // // recenter
-                // for (int i = 0; i < cogging_torque_map.size(); ++i) {
-                //     cogging_torque_map[i] -= avg;
-                // }
-
-                // rescale
-                Scalar max_abs = 0;
-                for (const Scalar torque : cogging_torque_map) {
-                    max_abs = std::max(max_abs, std::abs(torque));
-                }
+            ImGui::Text("Random Seed %lu", (unsigned long)seed);
+            if (ImGui::Button("Generate Random Cogging Torque Map")) {
+                synthesize_cogging_torque_map(
+                    get_random_cogging_harmonics(motor.params.num_pole_pairs,
+                                                 cogging_rng),
+                    resolution, &new_map);
+                scale_cogging_torque_map(/*max_torque=*/0.01, &new_map);
+                map_changed = true;
+            }
 
-                for (Scalar& torque : cogging_torque_map) {
-                    torque *= 0.01 / max_abs;
-                }
+            static char path[256] = "";
+            ImGui::InputText("Measured Map", path, sizeof(path));
+            static bool load_failed = false;
+            if (ImGui::Button("Load CSV")) {
+                load_failed =
+                    !load_cogging_torque_csv(path, resolution, &new_map);
+                map_changed = !load_failed;
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Load Binary")) {
+                load_failed =
+                    !load_cogging_torque_binary(path, resolution, &new_map);
+                map_changed = !load_failed;
+            }
+            if (load_failed) {
+                ImGui::SameLine();
+                ImGui::Text("Could not load %s", path);
+            }
 
-                // sanity check energy conservation
-                Scalar energy = 0;
-                for (const Scalar torque : cogging_torque_map) {
-                    energy += torque;
-                }
-                energy *= 2 * kPI / cogging_torque_map.size();
-                if (std::abs(energy) > 1e-8) {
-                    printf("Energy conservation violated by cogging map\n");
-                }
+            if (map_changed) {
+                motor.params.cogging_torque_map =
+                    std::make_shared<const std::vector<Scalar>>(
+                        std::move(new_map));
             }
+            const std::vector<Scalar>& cogging_torque_map =
+                *motor.params.cogging_torque_map;
 
             ImPlot::SetNextPlotLimitsX(0, cogging_torque_map.size(),
-                                       ImGuiCond_Once);
+                                       ImGuiCond_Always);
 
             ImPlot::SetNextPlotLimitsY(-0.01, 0.01, ImGuiCond_Once);
 
@@ -774,7 +1071,7 @@ void run_advanced_motor_config(MotorState* motor_ptr) {
 }
 
 void run_gui(const VizData& viz_data, VizOptions* options,
-             SimState* sim_state) {
+             SimHistory* history, SimState* sim_state) {
 
     ImGui::Begin("Simulation Control");
     ImGui::Columns(2);
@@ -790,9 +1087,28 @@ void run_gui(const VizData& viz_data, VizOptions* options,
     } else {
         sim_state->paused = ImGui::Button("Pause");
     }
+    if (sim_state->paused && !history->snapshots.empty()) {
+        // replays from the nearest snapshot, resuming from an earlier
+        // time discards what followed
+        double scrub_time = sim_state->time;
+        const double begin_time = get_sim_history_begin_time(*history);
+        const double end_time = history->end_time;
+        if (ImGui::SliderScalar("History (sec)", ImGuiDataType_Double,
+                                &scrub_time, &begin_time, &end_time,
+                                "%.6f")) {
+            seek_sim_history(*history, scrub_time, sim_state);
+        }
+    }
     ImGui::SliderInt("Step Multiplier", &sim_state->step_multiplier, 1, 5000);
     ImGui::SliderFloat("Rolling History (sec)", &options->rolling_history,
                        0.001f, 1.0f);
+    ImGui::SliderInt("Rolling History Points", &options->num_rolling_pts, 10,
+                     1000000);
+    ImGui::Checkbox("Record Every Step", &options->record_every_step);
+    ImGui::SameLine();
+    ImGui::RadioButton("Min/Max", &options->decimation_mode, kDecimateMinMax);
+    ImGui::SameLine();
+    ImGui::RadioButton("LTTB", &options->decimation_mode, kDecimateLttb);
 
     ImGui::Columns(1);
 
@@ -812,6 +1128,12 @@ void run_gui(const VizData& viz_data, VizOptions* options,
             ImGui::SameLine();
             ImGui::RadioButton("FOC", &sim_state->commutation_mode,
                                kCommutationModeFOC);
+            ImGui::SameLine();
+            ImGui::RadioButton("Plugin", &sim_state->commutation_mode,
+                               kCommutationModePlugin);
+            ImGui::SameLine();
+            ImGui::RadioButton("Co-Sim", &sim_state->commutation_mode,
+                               kCommutationModeCoSim);
 
             ImGui::NewLine();
             if (sim_state->commutation_mode == kCommutationModeManual) {
@@ -822,15 +1144,16 @@ void run_gui(const VizData& viz_data, VizOptions* options,
                     ImGui::SameLine();
                     ImGui::PushID(i);
 
-                    int current_command =
-                        (int)sim_state->board.gate.commanded[i];
+                    GateMask& commanded = sim_state->board.gate.commanded;
+                    int current_command = (commanded >> i) & 1;
                     ImGui::RadioButton(absl::StrFormat("HIGH", i).c_str(),
                                        &current_command, 1);
                     ImGui::SameLine();
                     ImGui::RadioButton(absl::StrFormat("LOW", i).c_str(),
                                        &current_command, 0);
 
-                    sim_state->board.gate.commanded[i] = (bool)current_command;
+                    commanded = (commanded & ~(GateMask(1) << i)) |
+                                (GateMask(current_command) << i);
                     ImGui::PopID();
                 }
             }
@@ -840,9 +1163,82 @@ void run_gui(const VizData& viz_data, VizOptions* options,
                        -0.5, 0.5);
             }
 
+            if (sim_state->commutation_mode == kCommutationModePlugin) {
+                ControllerPlugin& plugin = sim_state->controller_plugin;
+                static char path[256] = "";
+                ImGui::InputText("Shared Object", path, sizeof(path));
+                static double period = 1.0 / 10000;
+                ImGui::InputDouble("Update Period (sec)", &period, 0, 0,
+                                   "%g");
+                static std::string error;
+                if (ImGui::Button("Load")) {
+                    unload_controller_plugin(&plugin);
+                    error.clear();
+                    load_controller_plugin(
+                        path,
+                        get_controller_plugin_config(period,
+                                                     sim_state->motor.params),
+                        &plugin, &error);
+                }
+                ImGui::SameLine();
+                if (ImGui::Button("Unload")) {
+                    unload_controller_plugin(&plugin);
+                }
+                if (is_controller_plugin_loaded(plugin)) {
+                    ImGui::Text("Running %s",
+                                get_controller_plugin_name(*plugin.api));
+                } else if (!error.empty()) {
+                    ImGui::Text("%s", error.c_str());
+                }
+                Slider("Desired Torque", &sim_state->foc_desired_torque, -1.0,
+                       1.0);
+            }
+
+            if (sim_state->commutation_mode == kCommutationModeCoSim) {
+                LockstepEndpoint& cosim = sim_state->cosim;
+                static char channel[64] = "/biro";
+                ImGui::InputText("Channel", channel, sizeof(channel));
+                ImGui::InputDouble("Update Period (sec)",
+                                   &sim_state->cosim_period, 0, 0, "%g");
+                ImGui::InputDouble("Timeout (sec)", &sim_state->cosim_timeout,
+                                   0, 0, "%g");
+                static std::string error;
+                if (ImGui::Button("Create")) {
+                    close_lockstep_channel(&cosim);
+                    error.clear();
+                    sim_state->cosim_timed_out = false;
+                    sim_state->cosim_outputs = {};
+                    create_lockstep_channel(
+                        channel,
+                        get_controller_plugin_config(sim_state->cosim_period,
+                                                     sim_state->motor.params),
+                        &cosim, &error);
+                }
+                ImGui::SameLine();
+                if (ImGui::Button("Close")) {
+                    close_lockstep_channel(&cosim);
+                }
+                if (is_lockstep_channel_open(cosim)) {
+                    ImGui::Text("Serving %s", cosim.memory.name.c_str());
+                    if (sim_state->cosim_timed_out) {
+                        ImGui::Text("Paused, the controller did not answer");
+                    }
+                    ImGui::Text("Round Trip %.1f us mean, %.1f us max",
+                                cosim.round_trip_us.mean,
+                                cosim.round_trip_us.max);
+                } else if (!error.empty()) {
+                    ImGui::Text("%s", error.c_str());
+                }
+                Slider("Desired Torque", &sim_state->foc_desired_torque, -1.0,
+                       1.0);
+            }
+
             if (sim_state->commutation_mode == kCommutationModeFOC) {
-                order_of_magnitude_control("Update Period (sec)",
-                                           &sim_state->foc.period, -5, -2);
+                if (order_of_magnitude_control("Update Period (sec)",
+                                               &sim_state->foc.period, -5,
+                                               -2)) {
+                    retune_rotor_estimator(sim_state);
+                }
 
                 const Scalar update_freq = 1.0 / sim_state->foc.period;
                 if (update_freq < 1000) {
@@ -880,6 +1276,36 @@ void run_gui(const VizData& viz_data, VizOptions* options,
 
                 ImGui::NewLine();
 
+                ImGui::Combo("PWM Strategy", &sim_state->foc_pwm_strategy,
+                             kPwmStrategyNames.data(), kNumPwmStrategies);
+                ImGui::Combo("Overmodulation",
+                             &sim_state->foc_overmodulation_mode,
+                             kOvermodulationModeNames.data(),
+                             kNumOvermodulationModes);
+                ImGui::Text("Modulation Index %f",
+                            sim_state->foc.modulation_index);
+                ImGui::Text("Switching Events %ld",
+                            (long)sim_state->board.gate.num_switching_events);
+
+                ImGui::NewLine();
+
+                ImGui::Checkbox("Read Rotor From Encoder",
+                                &sim_state->foc_use_rotor_estimator);
+                if (ImGui::SliderInt("Encoder Counts",
+                                     &sim_state->encoder_counts, 16, 65536)) {
+                    retune_rotor_estimator(sim_state);
+                }
+                const EstimatorVector& estimate =
+                    sim_state->rotor_estimator.estimate;
+                ImGui::Text("Estimated Angle %f (true %f)",
+                            estimate(kEstimateAngle),
+                            sim_state->motor.kinematic.rotor_angle);
+                ImGui::Text("Estimated Velocity %f (true %f)",
+                            estimate(kEstimateVel),
+                            sim_state->motor.kinematic.rotor_angular_vel);
+
+                ImGui::NewLine();
+
                 ImGui::Text("PI Params");
                 static bool auto_pi_params = true;
                 ImGui::SameLine();
@@ -919,7 +1345,8 @@ void run_gui(const VizData& viz_data, VizOptions* options,
 
             double dead_time_usec = sim_state->board.gate.dead_time * 1e6;
             if (Slider("Gate Dead Time (usec)", &dead_time_usec, 0.0f, 100)) {
-                sim_state->board.gate.dead_time = dead_time_usec /= 1e6;
+                set_dead_time(dead_time_usec / 1e6, sim_state->dt,
+                              &sim_state->board.gate);
             }
 
             ImGui::Text("PWM Timer Resolution");
@@ -942,8 +1369,11 @@ void run_gui(const VizData& viz_data, VizOptions* options,
         }
 
         if (ImGui::BeginTabItem("Motor Params")) {
-            ImGui::SliderInt("Num Pole Pairs",
-                             &sim_state->motor.params.num_pole_pairs, 1, 8);
+            if (ImGui::SliderInt("Num Pole Pairs",
+                                 &sim_state->motor.params.num_pole_pairs, 1,
+                                 8)) {
+                sim_state->outputs.rotor_frame_stale = true;
+            }
             Slider("Rotor Moment of Inertia (kg m^2)",
                    &sim_state->motor.params.rotor_inertia, 0.1, 10);
             order_of_magnitude_control(
@@ -964,8 +1394,10 @@ void run_gui(const VizData& viz_data, VizOptions* options,
 
     ImGui::End();
 
-    const RollingPlotParams rolling_plot_params = get_rolling_plot_params(
-        viz_data.rolling_buffers, options->rolling_history);
+    const RollingPlotParams rolling_plot_params =
+        get_rolling_plot_params(viz_data.rolling_buffers,
+                                options->rolling_history,
+                                options->decimation_mode, *sim_state);
 
     ImGui::Begin("Rolling Plots");
     if (ImGui::Button("Dump CSV to Clipboard")) {
@@ -1015,9 +1447,30 @@ void run_gui(const VizData& viz_data, VizOptions* options,
 
     ImGui::End();
 
+    ImGui::Begin("Harmonic Analysis");
+    draw_harmonic_analysis(viz_data, options);
+    ImGui::End();
+
+    ImGui::Begin("Signal Statistics");
+    draw_telemetry_stats(&sim_state->telemetry_stats);
+    ImGui::End();
+
+    ImGui::Begin("Scope");
+    draw_scope(&sim_state->scope);
+    ImGui::End();
+
+    ImGui::Begin("Telemetry Export");
+    ImGui::Text("Shared Memory");
+    draw_telemetry_feed(&sim_state->telemetry_feed);
+    ImGui::Separator();
+    ImGui::Text("Socket");
+    draw_telemetry_server(&sim_state->telemetry_server);
+    ImGui::End();
+
     if (options->advanced_motor_config) {
         ImGui::Begin(kAdvancedMotorChars, &options->advanced_motor_config);
-        run_advanced_motor_config(&sim_state->motor);
+        run_advanced_motor_config(sim_state->seed, &sim_state->motor,
+                                  &sim_state->cogging_rng);
         ImGui::End();
     }
 }
@@ -1025,18 +1478,17 @@ void run_gui(const VizData& viz_data, VizOptions* options,
 std::string to_csv(const RollingBuffers& rolling_buffers) {
     std::stringstream ss;
 
-    using NamedField =
-        std::pair<const char*, const std::array<Scalar, kNumRollingPts>*>;
+    using NamedField = std::pair<const char*, int>;
 
     std::array<NamedField, 8> fields{
-        std::make_pair("timestamp", &rolling_buffers.timestamps),
-        std::make_pair("torque", &rolling_buffers.torque),
-        std::make_pair("bEmf_a", &rolling_buffers.bEmfs[0]),
-        std::make_pair("bEmf_b", &rolling_buffers.bEmfs[1]),
-        std::make_pair("bEmf_c", &rolling_buffers.bEmfs[2]),
-        std::make_pair("current_a", &rolling_buffers.phase_currents[0]),
-        std::make_pair("current_b", &rolling_buffers.phase_currents[1]),
-        std::make_pair("current_c", &rolling_buffers.phase_currents[2])};
+        std::make_pair("timestamp", kTelemetryTime),
+        std::make_pair("torque", kTelemetryTorque),
+        std::make_pair("bEmf_a", kTelemetryBEmfA),
+        std::make_pair("bEmf_b", kTelemetryBEmfB),
+        std::make_pair("bEmf_c", kTelemetryBEmfC),
+        std::make_pair("current_a", kTelemetryPhaseCurrentA),
+        std::make_pair("current_b", kTelemetryPhaseCurrentB),
+        std::make_pair("current_c", kTelemetryPhaseCurrentC)};
 
     // write the headers
     for (int col = 0; col < fields.size(); ++col) {
@@ -1048,20 +1500,27 @@ std::string to_csv(const RollingBuffers& rolling_buffers) {
     }
     ss << "\n";
 
-    // write the values
-    const int num_rows = get_rolling_buffer_count(rolling_buffers.ctx);
-    for (int row = 0; row < num_rows; ++row) {
-        for (int col = 0; col < fields.size(); ++col) {
-            // write the value
-            ss << (*fields[col].second)[row];
-            if (col + 1 != fields.size()) {
-                // write the separator
-                ss << ",";
+    const auto write_rows = [&](const TelemetrySample* rows,
+                                const int num_rows) {
+        for (int row = 0; row < num_rows; ++row) {
+            for (int col = 0; col < fields.size(); ++col) {
+                // write the value
+                ss << rows[row][fields[col].second];
+                if (col + 1 != fields.size()) {
+                    // write the separator
+                    ss << ",";
+                }
             }
+            // row finished
+            ss << "\n";
         }
-        // row finished
-        ss << "\n";
-    }
+    };
+
+    // write the values, oldest first
+    const RollingBufferSpans<TelemetrySample> spans =
+        get_rolling_buffer_spans(rolling_buffers.samples);
+    write_rows(spans.first, spans.first_count);
+    write_rows(spans.second, spans.second_count);
 
     return ss.str();
 }
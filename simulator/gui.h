@@ -1,34 +1,21 @@
 #pragma once
 
+#include "analysis/harmonic_analysis.h"
 #include "config/scalar.h"
+#include "sim_history.h"
 #include "sim_state.h"
+#include "telemetry.h"
+#include "util/decimation.h"
 #include "util/rolling_buffer.h"
 #include <array>
 
 constexpr int kNumRollingPts = 200;
 
 struct RollingBuffers {
+    RollingBuffer<TelemetrySample> samples;
 
-    RollingBufferContext ctx{kNumRollingPts};
-
-    std::array<Scalar, kNumRollingPts> timestamps;
-
-    std::array<std::array<Scalar, kNumRollingPts>, 3> phase_vs;
-    std::array<std::array<Scalar, kNumRollingPts>, 3> phase_currents;
-    std::array<std::array<Scalar, kNumRollingPts>, 3> bEmfs;
-    std::array<std::array<Scalar, kNumRollingPts>, 3> normed_bEmfs;
-    std::array<Scalar, kNumRollingPts> torque;
-    std::array<Scalar, kNumRollingPts> rotor_angular_vel;
-    std::array<Scalar, kNumRollingPts> pwm_level;
-    std::array<std::array<Scalar, kNumRollingPts>, 3> pwm_duties;
-    std::array<std::array<Scalar, kNumRollingPts>, 3> gate_states;
-    std::array<Scalar, kNumRollingPts> current_q;
-    std::array<Scalar, kNumRollingPts> current_d;
-    std::array<Scalar, kNumRollingPts> current_q_err;
-    std::array<Scalar, kNumRollingPts> current_q_integral;
-    std::array<Scalar, kNumRollingPts> current_d_err;
-    std::array<Scalar, kNumRollingPts> current_d_integral;
-    std::array<Scalar, kNumRollingPts> power_draw; // power drawn from v_bus
+    // summary of samples, for drawing long histories
+    DecimationPyramid<TelemetrySample> pyramid;
 };
 
 std::string to_csv(const RollingBuffers& rolling_buffers);
@@ -38,6 +25,10 @@ struct VizOptions {
     float rolling_history = 1;   // sec
     std::array<bool, 3> coil_visible = {true, false, false};
     bool advanced_motor_config = false;
+    int harmonic_signal = 0; // which spectrum to display
+    int num_rolling_pts = kNumRollingPts;
+    bool record_every_step = false; // otherwise record once per frame
+    int decimation_mode = kDecimateMinMax;
 };
 
 struct VizData {
@@ -46,13 +37,31 @@ struct VizData {
     std::array<uint32_t, 3> coil_colors;
 
     RollingBuffers rolling_buffers;
+
+    HarmonicAnalyzer harmonic_analyzer;
+    std::array<HarmonicSpectrum, 3> phase_current_spectra;
+    std::array<HarmonicSpectrum, 3> bEmf_spectra;
+    HarmonicSpectrum torque_spectrum;
 };
 
 void init_viz_data(VizData* viz_data);
 
-void update_rolling_buffers(const Scalar time, const BoardState& board,
-                            const MotorState& motor, const FocState& foc,
+// reallocates the rolling buffers if the capacity has changed
+void resize_rolling_buffers(const int num_rolling_pts,
                             RollingBuffers* buffers);
 
+// the plots need an increasing time column, so after resuming from an earlier
+// point in the history the samples from that time on are dropped
+void rewind_rolling_buffers(const Scalar time, RollingBuffers* buffers);
+
+// analyzes the latest electrical periods in the rolling buffers
+void update_harmonic_spectra(const MotorState& motor, VizData* viz_data);
+
+void push_rolling_buffers(const TelemetrySample& sample,
+                          RollingBuffers* buffers);
+
+void update_rolling_buffers(const SimState& state, RollingBuffers* buffers);
+
+// history is scrubbed from the gui while paused
 void run_gui(const VizData& viz_data, VizOptions* viz_options,
-             SimState* sim_state);
+             SimHistory* history, SimState* sim_state);
@@ -0,0 +1,65 @@
+#include "config/scalar.h"
+#include "motor_state.h"
+#include "parameter_identification.h"
+#include <cstdio>
+#include <gflags/gflags.h>
+
+// Fits motor parameters to a bench capture, see parameter_identification.h
+// for the trace format. The flags other than the trace are the initial
+// guess, which should be within a factor of a few of the real motor.
+
+DEFINE_string(trace, "", "csv of time, va, vb, vc, ia, ib, ic, rotor_angle");
+DEFINE_int32(num_pole_pairs, 4, "known, not fit");
+DEFINE_double(resistance, 1.0, "phase resistance guess (ohm)");
+DEFINE_double(inductance, 1e-3, "phase inductance guess (H)");
+DEFINE_double(bEmf_constant, 0.01,
+              "back emf guess, per electrical rad/s (V . s)");
+DEFINE_double(inertia, 0.1, "rotor inertia guess (kg . m^2)");
+DEFINE_int32(substeps, 10, "simulation steps per trace sample");
+DEFINE_double(angle_weight, 1, "of angle errors (rad) against currents (A)");
+DEFINE_int32(max_iterations, 100, "");
+DEFINE_int32(num_threads, 0, "0 uses all hardware threads");
+
+int main(int argc, char* argv[]) {
+    gflags::ParseCommandLineFlags(&argc, &argv, /*remove_flags*/ true);
+
+    MotorTrace trace;
+    if (!load_motor_trace_csv(FLAGS_trace, &trace)) {
+        std::fprintf(stderr, "Could not read %s\n", FLAGS_trace.c_str());
+        return 1;
+    }
+
+    MotorParams params;
+    params.num_pole_pairs = FLAGS_num_pole_pairs;
+    params.phase_resistance = FLAGS_resistance;
+    params.phase_inductance = FLAGS_inductance;
+    params.rotor_inertia = FLAGS_inertia;
+    params.normed_bEmf_coeffs.setZero(1);
+    params.normed_bEmf_coeffs(0) = FLAGS_bEmf_constant;
+    // cogging is left out of the fit
+    params.cogging_torque_map = std::make_shared<const std::vector<Scalar>>();
+
+    IdentificationOptions options;
+    options.substeps = FLAGS_substeps;
+    options.angle_weight = FLAGS_angle_weight;
+    options.max_iterations = FLAGS_max_iterations;
+    options.num_threads = FLAGS_num_threads;
+
+    IdentificationResult result;
+    if (!identify_motor_params(trace, options, &params, &result)) {
+        std::fprintf(stderr, "Could not fit %d samples\n", int(trace.size()));
+        return 1;
+    }
+
+    std::printf("phase_resistance %g\n", params.phase_resistance);
+    std::printf("phase_inductance %g\n", params.phase_inductance);
+    std::printf("bEmf_constant %g\n", params.normed_bEmf_coeffs(0));
+    std::printf("rotor_inertia %g\n", params.rotor_inertia);
+    std::printf("initial_rotor_angular_vel %g\n",
+                result.initial_rotor_angular_vel);
+    std::printf("rms_current_error %g\n", result.rms_current_error);
+    std::printf("rms_angle_error %g\n", result.rms_angle_error);
+    std::printf("%d iterations, %d simulations\n", result.num_iterations,
+                result.num_simulations);
+    return 0;
+}
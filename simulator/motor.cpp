@@ -56,60 +56,82 @@ on
 }
 */
 
-Eigen::Matrix<Scalar, 3, 1>
-get_phase_voltages(const Eigen::Matrix<Scalar, 3, 1>& pole_voltages,
-                   const Eigen::Matrix<Scalar, 3, 1>& bEmfs) {
+template <int kNumPhases>
+Eigen::Matrix<Scalar, kNumPhases, 1>
+get_phase_voltages(const Eigen::Matrix<Scalar, kNumPhases, 1>& pole_voltages,
+                   const Eigen::Matrix<Scalar, kNumPhases, 1>& bEmfs) {
     // todo: derivation
-    const Eigen::Matrix<Scalar, 3, 1> phase_voltages =
-        pole_voltages - Eigen::Matrix<Scalar, 3, 1>::Ones() *
+    const Eigen::Matrix<Scalar, kNumPhases, 1> phase_voltages =
+        pole_voltages - Eigen::Matrix<Scalar, kNumPhases, 1>::Ones() *
                             (pole_voltages.mean() - bEmfs.mean());
     return phase_voltages;
 };
 
-Eigen::Matrix<Scalar, 3, 1>
+template <int kNumPhases>
+Eigen::Matrix<Scalar, kNumPhases, 1>
 get_di_dt(const Scalar phase_resistance, const Scalar phase_inductance,
-          const Eigen::Matrix<Scalar, 3, 1>& pole_voltages,
-          const Eigen::Matrix<Scalar, 3, 1>& bEmfs,
-          const Eigen::Matrix<Scalar, 3, 1>& phase_currents) {
+          const Eigen::Matrix<Scalar, kNumPhases, 1>& pole_voltages,
+          const Eigen::Matrix<Scalar, kNumPhases, 1>& bEmfs,
+          const Eigen::Matrix<Scalar, kNumPhases, 1>& phase_currents) {
     // zero series components
-    const Eigen::Matrix<Scalar, 3, 1> pole_voltages_zs =
-        pole_voltages.mean() * Eigen::Matrix<Scalar, 3, 1>::Ones();
-    const Eigen::Matrix<Scalar, 3, 1> bEmfs_zs =
-        bEmfs.mean() * Eigen::Matrix<Scalar, 3, 1>::Ones();
+    const Eigen::Matrix<Scalar, kNumPhases, 1> pole_voltages_zs =
+        pole_voltages.mean() * Eigen::Matrix<Scalar, kNumPhases, 1>::Ones();
+    const Eigen::Matrix<Scalar, kNumPhases, 1> bEmfs_zs =
+        bEmfs.mean() * Eigen::Matrix<Scalar, kNumPhases, 1>::Ones();
 
-    Eigen::Matrix<Scalar, 3, 1> di_dt =
+    Eigen::Matrix<Scalar, kNumPhases, 1> di_dt =
         ((pole_voltages - pole_voltages_zs) - (bEmfs - bEmfs_zs) -
          phase_currents * phase_resistance) /
         phase_inductance;
     return di_dt;
 };
 
-void step_motor_electrical(const Scalar dt,
-                           const Eigen::Matrix<Scalar, 3, 1>& pole_voltages,
-                           const Scalar electrical_angle,
-                           const Scalar electrical_angular_vel,
-                           const MotorParams& motor_params,
-                           MotorElectricalState* motor_electrical) {
-    get_bEmfs(motor_params.normed_bEmf_coeffs, electrical_angle,
-              electrical_angular_vel, &motor_electrical->normed_bEmfs,
-              &motor_electrical->bEmfs);
+template <int kNumPhases>
+void step_motor_electrical(
+    const Scalar dt, const Eigen::Matrix<Scalar, kNumPhases, 1>& pole_voltages,
+    const Eigen::Matrix<Scalar, kNumPhases, 1>& min_phase_currents,
+    const Eigen::Matrix<Scalar, kNumPhases, 1>& max_phase_currents,
+    const Scalar electrical_angle, const Scalar electrical_angular_vel,
+    const MotorParams& motor_params,
+    BasicMotorElectricalState<kNumPhases>* motor_electrical) {
+    get_bEmfs(motor_params.normed_bEmf_coeffs, motor_params.normed_bEmf_series,
+              electrical_angle, electrical_angular_vel,
+              &motor_electrical->normed_bEmfs, &motor_electrical->bEmfs);
 
     // todo: handle the case where di_dt = infinity due to too small inductance
-    const Eigen::Matrix<Scalar, 3, 1> di_dt =
+    const Eigen::Matrix<Scalar, kNumPhases, 1> di_dt =
         get_di_dt(motor_params.phase_resistance, motor_params.phase_inductance,
                   pole_voltages, motor_electrical->bEmfs,
                   motor_electrical->phase_currents);
 
-    motor_electrical->phase_currents += di_dt * dt;
+    const Eigen::Matrix<Scalar, kNumPhases, 1> unbounded_currents =
+        motor_electrical->phase_currents + di_dt * dt;
+    motor_electrical->phase_currents =
+        unbounded_currents.cwiseMax(min_phase_currents)
+            .cwiseMin(max_phase_currents);
+
+    // bounded phases carry no more current than the bound, so the free
+    // phases rebalance around them
+    const Eigen::Array<Scalar, kNumPhases, 1> free =
+        (motor_electrical->phase_currents.array() ==
+         unbounded_currents.array())
+            .template cast<Scalar>();
+    const Scalar num_free = free.sum();
+    if (num_free > 0 && num_free < kNumPhases) {
+        motor_electrical->phase_currents -=
+            (free * (motor_electrical->phase_currents.sum() / num_free))
+                .matrix();
+    }
 }
 
-void step_motor_kinematic(const Scalar dt, const Scalar load_torque,
-                          const Eigen::Matrix<Scalar, 3, 1>& phase_currents,
-                          const Eigen::Matrix<Scalar, 3, 1>& normed_bEmfs,
-                          const MotorParams& motor_params,
-                          MotorKinematicState* motor_kinematic) {
+template <int kNumPhases>
+void step_motor_kinematic(
+    const Scalar dt, const Scalar load_torque,
+    const Eigen::Matrix<Scalar, kNumPhases, 1>& phase_currents,
+    const Eigen::Matrix<Scalar, kNumPhases, 1>& normed_bEmfs,
+    const MotorParams& motor_params, MotorKinematicState* motor_kinematic) {
     const Scalar cogging_torque = interp_cogging_torque(
-        motor_kinematic->rotor_angle, motor_params.cogging_torque_map);
+        motor_kinematic->rotor_angle, *motor_params.cogging_torque_map);
     motor_kinematic->torque =
         phase_currents.dot(normed_bEmfs) + cogging_torque + load_torque;
     motor_kinematic->rotor_angular_accel =
@@ -124,19 +146,70 @@ void step_motor_kinematic(const Scalar dt, const Scalar load_torque,
     }
 }
 
+template <int kNumPhases>
 void step_motor(const Scalar dt, const Scalar load_torque,
-                const Eigen::Matrix<Scalar, 3, 1>& pole_voltages,
-                MotorState* motor) {
+                const Eigen::Matrix<Scalar, kNumPhases, 1>& pole_voltages,
+                const Eigen::Matrix<Scalar, kNumPhases, 1>& min_phase_currents,
+                const Eigen::Matrix<Scalar, kNumPhases, 1>& max_phase_currents,
+                BasicMotorState<kNumPhases>* motor) {
 
     const Scalar electrical_angle = get_electrical_angle(
         motor->params.num_pole_pairs, motor->kinematic.rotor_angle);
     const Scalar electrical_angular_vel =
         motor->kinematic.rotor_angular_vel * motor->params.num_pole_pairs;
 
-    step_motor_electrical(dt, pole_voltages, electrical_angle,
+    step_motor_electrical(dt, pole_voltages, min_phase_currents,
+                          max_phase_currents, electrical_angle,
                           electrical_angular_vel, motor->params,
                           &motor->electrical);
     step_motor_kinematic(dt, load_torque, motor->electrical.phase_currents,
                          motor->electrical.normed_bEmfs, motor->params,
                          &motor->kinematic);
 }
+
+// explicit instantiations, see motor.h
+template Eigen::Matrix<Scalar, 3, 1>
+get_phase_voltages<3>(const Eigen::Matrix<Scalar, 3, 1>&,
+                      const Eigen::Matrix<Scalar, 3, 1>&);
+template void step_motor_electrical<3>(const Scalar,
+                                       const Eigen::Matrix<Scalar, 3, 1>&,
+                                       const Eigen::Matrix<Scalar, 3, 1>&,
+                                       const Eigen::Matrix<Scalar, 3, 1>&,
+                                       const Scalar, const Scalar,
+                                       const MotorParams&,
+                                       BasicMotorElectricalState<3>*);
+template void step_motor<3>(const Scalar, const Scalar,
+                            const Eigen::Matrix<Scalar, 3, 1>&,
+                            const Eigen::Matrix<Scalar, 3, 1>&,
+                            const Eigen::Matrix<Scalar, 3, 1>&,
+                            BasicMotorState<3>*);
+template Eigen::Matrix<Scalar, 5, 1>
+get_phase_voltages<5>(const Eigen::Matrix<Scalar, 5, 1>&,
+                      const Eigen::Matrix<Scalar, 5, 1>&);
+template void step_motor_electrical<5>(const Scalar,
+                                       const Eigen::Matrix<Scalar, 5, 1>&,
+                                       const Eigen::Matrix<Scalar, 5, 1>&,
+                                       const Eigen::Matrix<Scalar, 5, 1>&,
+                                       const Scalar, const Scalar,
+                                       const MotorParams&,
+                                       BasicMotorElectricalState<5>*);
+template void step_motor<5>(const Scalar, const Scalar,
+                            const Eigen::Matrix<Scalar, 5, 1>&,
+                            const Eigen::Matrix<Scalar, 5, 1>&,
+                            const Eigen::Matrix<Scalar, 5, 1>&,
+                            BasicMotorState<5>*);
+template Eigen::Matrix<Scalar, 6, 1>
+get_phase_voltages<6>(const Eigen::Matrix<Scalar, 6, 1>&,
+                      const Eigen::Matrix<Scalar, 6, 1>&);
+template void step_motor_electrical<6>(const Scalar,
+                                       const Eigen::Matrix<Scalar, 6, 1>&,
+                                       const Eigen::Matrix<Scalar, 6, 1>&,
+                                       const Eigen::Matrix<Scalar, 6, 1>&,
+                                       const Scalar, const Scalar,
+                                       const MotorParams&,
+                                       BasicMotorElectricalState<6>*);
+template void step_motor<6>(const Scalar, const Scalar,
+                            const Eigen::Matrix<Scalar, 6, 1>&,
+                            const Eigen::Matrix<Scalar, 6, 1>&,
+                            const Eigen::Matrix<Scalar, 6, 1>&,
+                            BasicMotorState<6>*);
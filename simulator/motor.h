@@ -4,21 +4,46 @@
 #include "controls/pi_control.h"
 #include "motor_state.h"
 #include <Eigen/Dense>
+#include <limits>
 
 PiParams make_motor_pi_params(Scalar bandwidth, Scalar resistance,
                               Scalar inductance);
 
-Eigen::Matrix<Scalar, 3, 1>
-get_phase_voltages(const Eigen::Matrix<Scalar, 3, 1>& pole_voltages,
-                   const Eigen::Matrix<Scalar, 3, 1>& bEmfs);
+// these are instantiated for 3, 5 and 6 phases in motor.cpp
 
-void step_motor_electrical(const Scalar dt,
-                           const Eigen::Matrix<Scalar, 3, 1>& pole_voltages,
-                           const Scalar electrical_angle,
-                           const Scalar electrical_angular_vel,
-                           const MotorParams& motor_params,
-                           MotorElectricalState* motor_electrical);
+template <int kNumPhases>
+Eigen::Matrix<Scalar, kNumPhases, 1>
+get_phase_voltages(const Eigen::Matrix<Scalar, kNumPhases, 1>& pole_voltages,
+                   const Eigen::Matrix<Scalar, kNumPhases, 1>& bEmfs);
 
+// phase currents stop at min/max_phase_currents within the step, eg at
+// the zero crossing of a diode that stops conducting. the other phases
+// take up the difference so the currents still sum to zero
+template <int kNumPhases>
+void step_motor_electrical(
+    const Scalar dt, const Eigen::Matrix<Scalar, kNumPhases, 1>& pole_voltages,
+    const Eigen::Matrix<Scalar, kNumPhases, 1>& min_phase_currents,
+    const Eigen::Matrix<Scalar, kNumPhases, 1>& max_phase_currents,
+    const Scalar electrical_angle, const Scalar electrical_angular_vel,
+    const MotorParams& motor_params,
+    BasicMotorElectricalState<kNumPhases>* motor_electrical);
+
+template <int kNumPhases>
 void step_motor(const Scalar dt, const Scalar load_torque,
-                const Eigen::Matrix<Scalar, 3, 1>& pole_voltages,
-                MotorState* motor);
+                const Eigen::Matrix<Scalar, kNumPhases, 1>& pole_voltages,
+                const Eigen::Matrix<Scalar, kNumPhases, 1>& min_phase_currents,
+                const Eigen::Matrix<Scalar, kNumPhases, 1>& max_phase_currents,
+                BasicMotorState<kNumPhases>* motor);
+
+// unbounded phase currents
+template <int kNumPhases>
+inline void
+step_motor(const Scalar dt, const Scalar load_torque,
+           const Eigen::Matrix<Scalar, kNumPhases, 1>& pole_voltages,
+           BasicMotorState<kNumPhases>* motor) {
+    constexpr Scalar kInf = std::numeric_limits<Scalar>::infinity();
+    step_motor<kNumPhases>(
+        dt, load_torque, pole_voltages,
+        Eigen::Matrix<Scalar, kNumPhases, 1>::Constant(-kInf),
+        Eigen::Matrix<Scalar, kNumPhases, 1>::Constant(kInf), motor);
+}
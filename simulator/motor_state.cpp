@@ -1,32 +1,77 @@
 #include "motor_state.h"
-#include "util/sine_series.h"
 #include <algorithm>
 
-Scalar get_normed_bEmf(const Eigen::Matrix<Scalar, 5, 1>& normed_bEmf_coeffs,
-                       const Scalar electrical_angle) {
-    Eigen::Matrix<Scalar, 5, 1> sines;
-    generate_odd_sine_series(/*num_terms=*/sines.rows(), electrical_angle,
-                             sines.data());
-    return sines.dot(normed_bEmf_coeffs);
+namespace {
+
+template <int kSeries, int kNumPhases>
+Eigen::Matrix<Scalar, kNumPhases, 1>
+dispatch_normed_bEmfs(const BEmfCoeffs& normed_bEmf_coeffs,
+                      const Scalar electrical_angle) {
+    switch (normed_bEmf_coeffs.size()) {
+    case 1:
+        return get_normed_bEmfs<kSeries, 1, kNumPhases>(normed_bEmf_coeffs,
+                                                        electrical_angle);
+    case 3:
+        return get_normed_bEmfs<kSeries, 3, kNumPhases>(normed_bEmf_coeffs,
+                                                        electrical_angle);
+    case 5:
+        return get_normed_bEmfs<kSeries, 5, kNumPhases>(normed_bEmf_coeffs,
+                                                        electrical_angle);
+    case 8:
+        return get_normed_bEmfs<kSeries, 8, kNumPhases>(normed_bEmf_coeffs,
+                                                        electrical_angle);
+    case 15:
+        return get_normed_bEmfs<kSeries, 15, kNumPhases>(normed_bEmf_coeffs,
+                                                         electrical_angle);
+    default:
+        return get_normed_bEmfs<kSeries, -1, kNumPhases>(normed_bEmf_coeffs,
+                                                         electrical_angle);
+    }
 }
 
-Eigen::Matrix<Scalar, 3, 1>
-get_normed_bEmfs(const Eigen::Matrix<Scalar, 5, 1>& normed_bEmf_coeffs,
-                 const Scalar electrical_angle) {
-    Eigen::Matrix<Scalar, 3, 1> normed_bEmfs;
-    normed_bEmfs << // clang-format off
-        get_normed_bEmf(normed_bEmf_coeffs, electrical_angle),
-        get_normed_bEmf(normed_bEmf_coeffs, electrical_angle - 2 * kPI / 3),
-        get_normed_bEmf(normed_bEmf_coeffs, electrical_angle - 4 * kPI / 3); // clang-format on
-    return normed_bEmfs;
+} // namespace
+
+template <int kNumPhases>
+Eigen::Matrix<Scalar, kNumPhases, 1>
+get_normed_bEmfs(const BEmfCoeffs& normed_bEmf_coeffs,
+                 const int normed_bEmf_series, const Scalar electrical_angle) {
+    if (normed_bEmf_coeffs.size() == 0) {
+        return Eigen::Matrix<Scalar, kNumPhases, 1>::Zero();
+    }
+    if (normed_bEmf_series == kSineSeriesOdd) {
+        return dispatch_normed_bEmfs<kSineSeriesOdd, kNumPhases>(
+            normed_bEmf_coeffs, electrical_angle);
+    }
+    return dispatch_normed_bEmfs<kSineSeriesAll, kNumPhases>(
+        normed_bEmf_coeffs, electrical_angle);
 }
 
-void get_bEmfs(const Eigen::Matrix<Scalar, 5, 1>& normed_bEmf_coeffs,
-               const Scalar electrical_angle,
+Scalar get_normed_bEmf(const BEmfCoeffs& normed_bEmf_coeffs,
+                       const int normed_bEmf_series,
+                       const Scalar electrical_angle) {
+    if (normed_bEmf_coeffs.size() == 0) {
+        return 0;
+    }
+    Scalar sin_angle, cos_angle;
+    fast_sincos(electrical_angle, &sin_angle, &cos_angle);
+    if (normed_bEmf_series == kSineSeriesOdd) {
+        return evaluate_sine_series<kSineSeriesOdd, -1>(
+            normed_bEmf_coeffs.data(), normed_bEmf_coeffs.size(), sin_angle,
+            cos_angle);
+    }
+    return evaluate_sine_series<kSineSeriesAll, -1>(
+        normed_bEmf_coeffs.data(), normed_bEmf_coeffs.size(), sin_angle,
+        cos_angle);
+}
+
+template <int kNumPhases>
+void get_bEmfs(const BEmfCoeffs& normed_bEmf_coeffs,
+               const int normed_bEmf_series, const Scalar electrical_angle,
                const Scalar electrical_angular_vel,
-               Eigen::Matrix<Scalar, 3, 1>* normed_bEmfs,
-               Eigen::Matrix<Scalar, 3, 1>* bEmfs) {
-    *normed_bEmfs = get_normed_bEmfs(normed_bEmf_coeffs, electrical_angle);
+               Eigen::Matrix<Scalar, kNumPhases, 1>* normed_bEmfs,
+               Eigen::Matrix<Scalar, kNumPhases, 1>* bEmfs) {
+    *normed_bEmfs = get_normed_bEmfs<kNumPhases>(
+        normed_bEmf_coeffs, normed_bEmf_series, electrical_angle);
 
     // multiplying by electrical angular vel because normed bEmf map is
     // expressed in electrical angle.
@@ -36,14 +81,36 @@ void get_bEmfs(const Eigen::Matrix<Scalar, 5, 1>& normed_bEmf_coeffs,
     *bEmfs = *normed_bEmfs * electrical_angular_vel;
 }
 
+// explicit instantiations, see motor_state.h
+template Eigen::Matrix<Scalar, 3, 1>
+get_normed_bEmfs<3>(const BEmfCoeffs&, const int, const Scalar);
+template void get_bEmfs<3>(const BEmfCoeffs&, const int, const Scalar,
+                           const Scalar, Eigen::Matrix<Scalar, 3, 1>*,
+                           Eigen::Matrix<Scalar, 3, 1>*);
+template Eigen::Matrix<Scalar, 5, 1>
+get_normed_bEmfs<5>(const BEmfCoeffs&, const int, const Scalar);
+template void get_bEmfs<5>(const BEmfCoeffs&, const int, const Scalar,
+                           const Scalar, Eigen::Matrix<Scalar, 5, 1>*,
+                           Eigen::Matrix<Scalar, 5, 1>*);
+template Eigen::Matrix<Scalar, 6, 1>
+get_normed_bEmfs<6>(const BEmfCoeffs&, const int, const Scalar);
+template void get_bEmfs<6>(const BEmfCoeffs&, const int, const Scalar,
+                           const Scalar, Eigen::Matrix<Scalar, 6, 1>*,
+                           Eigen::Matrix<Scalar, 6, 1>*);
+
 Scalar
 interp_cogging_torque(const Scalar rotor_angle,
-                      const std::array<Scalar, 3600>& cogging_torque_map) {
+                      const std::vector<Scalar>& cogging_torque_map) {
+    if (cogging_torque_map.empty()) {
+        return 0;
+    }
     const Scalar encoder_position =
         cogging_torque_map.size() *
         std::clamp<Scalar>(rotor_angle / (2 * kPI), 0.0, 1.0);
-    const int integral_part = int(encoder_position);
-    const Scalar fractional_part = encoder_position - integral_part;
+    // a full revolution wraps back to the start
+    const int integral_part =
+        int(encoder_position) % int(cogging_torque_map.size());
+    const Scalar fractional_part = encoder_position - int(encoder_position);
     const Scalar t1 = cogging_torque_map[integral_part];
     const Scalar t2 =
         cogging_torque_map[(integral_part + 1) % cogging_torque_map.size()];
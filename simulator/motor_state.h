@@ -1,12 +1,23 @@
 #pragma once
 
 #include "config/scalar.h"
+#include "util/clarke_transform.h"
+#include "util/fast_sincos.h"
 #include "util/math_constants.h"
+#include "util/sine_series.h"
 #include <Eigen/Dense>
 #include <array>
+#include <memory>
+#include <vector>
 
 constexpr Scalar kQAxisOffset = -kPI / 2;
 
+constexpr int kMaxBEmfCoeffs = 16;
+
+// fourier coefficients of the normed bEmf, up to kMaxBEmfCoeffs of them
+using BEmfCoeffs = Eigen::Matrix<Scalar, Eigen::Dynamic, 1, Eigen::ColMajor,
+                                 kMaxBEmfCoeffs, 1>;
+
 struct MotorKinematicState {
     Scalar rotor_angle = 0;
     Scalar rotor_angular_vel = 0;
@@ -14,17 +25,33 @@ struct MotorKinematicState {
     Scalar torque = 0;
 };
 
-struct MotorElectricalState {
-    Eigen::Matrix<Scalar, 3, 1> phase_currents = {};
-    Eigen::Matrix<Scalar, 3, 1> bEmfs = {};
-    Eigen::Matrix<Scalar, 3, 1> normed_bEmfs =
-        {}; // units of V . s,
-            // aka N . m / Amps
-            // same thing as
-            // - phase torque function
-            // - derivative of rotor stator flux linkage wrt angle
+// The phase count is a template parameter, the simulator itself runs the
+// 3 phase aliases. Phase k of a kNumPhases machine lags phase 0 by
+// 2 pi k / kNumPhases electrical radians. The non-inline motor functions
+// are instantiated for 3, 5 and 6 phases.
+template <int kNumPhases>
+struct BasicMotorElectricalState {
+    Eigen::Matrix<Scalar, kNumPhases, 1> phase_currents =
+        Eigen::Matrix<Scalar, kNumPhases, 1>::Zero();
+    Eigen::Matrix<Scalar, kNumPhases, 1> bEmfs =
+        Eigen::Matrix<Scalar, kNumPhases, 1>::Zero();
+    // units of V . s,
+    // aka N . m / Amps
+    // same thing as
+    // - phase torque function
+    // - derivative of rotor stator flux linkage wrt angle
+    Eigen::Matrix<Scalar, kNumPhases, 1> normed_bEmfs =
+        Eigen::Matrix<Scalar, kNumPhases, 1>::Zero();
 };
 
+using MotorElectricalState = BasicMotorElectricalState<3>;
+
+constexpr int kDefaultCoggingMapResolution = 3600;
+
+// Maps are never modified in place, so copies of MotorParams share one
+// without allocating. To change a map, build a new one and replace it.
+using CoggingTorqueMap = std::shared_ptr<const std::vector<Scalar>>;
+
 struct MotorParams {
     // motor characteristics
     int num_pole_pairs = 4;
@@ -32,37 +59,80 @@ struct MotorParams {
     Scalar phase_inductance = 1e-3;
     Scalar phase_resistance = 1.0;
     // normalized bEmf aka torque/current curve
-    // odd coefficients of sine fourier expansion
-    Eigen::Matrix<Scalar, 5, 1> normed_bEmf_coeffs;
-    std::array<Scalar, 3600> cogging_torque_map;
+    // coefficients of sine fourier expansion, over the harmonics of
+    // normed_bEmf_series (kSineSeriesOdd or kSineSeriesAll)
+    BEmfCoeffs normed_bEmf_coeffs;
+    int normed_bEmf_series = kSineSeriesOdd;
+    // over a mechanical revolution, see cogging_torque.h
+    CoggingTorqueMap cogging_torque_map =
+        std::make_shared<const std::vector<Scalar>>(
+            kDefaultCoggingMapResolution);
 };
 
-struct MotorState {
+template <int kNumPhases>
+struct BasicMotorState {
     MotorParams params;
-    MotorElectricalState electrical;
+    BasicMotorElectricalState<kNumPhases> electrical;
     MotorKinematicState kinematic;
 };
 
-inline void init_motor_state(MotorState* motor) {
+using MotorState = BasicMotorState<3>;
+
+template <int kNumPhases>
+inline void init_motor_state(BasicMotorState<kNumPhases>* motor) {
     motor->electrical.phase_currents.setZero();
     motor->electrical.bEmfs.setZero();
-    motor->params.normed_bEmf_coeffs << 0.01, 0, 0, 0, 0;
+    motor->params.normed_bEmf_coeffs.setZero(5);
+    motor->params.normed_bEmf_coeffs(0) = 0.01;
+    motor->params.normed_bEmf_series = kSineSeriesOdd;
 }
 
-Scalar
-get_normed_bEmf(const Eigen::Matrix<Scalar, 5, 1>& normalized_bEmf_coeffs,
-                const Scalar electrical_angle);
+// normed bEmfs of all phases, with the number of coefficients fixed at
+// compile time. kNumCoeffs = -1 handles any number at runtime.
+template <int kSeries, int kNumCoeffs, int kNumPhases = 3>
+Eigen::Matrix<Scalar, kNumPhases, 1>
+get_normed_bEmfs(const BEmfCoeffs& normed_bEmf_coeffs,
+                 const Scalar electrical_angle) {
+    Scalar sin_a, cos_a;
+    fast_sincos(electrical_angle, &sin_a, &cos_a);
+
+    // phase k lags phase 0 by 2 pi k / kNumPhases
+    Eigen::Array<Scalar, kNumPhases, 1> sines;
+    Eigen::Array<Scalar, kNumPhases, 1> cosines;
+    for (int k = 0; k < kNumPhases; ++k) {
+        const Scalar offset_cos = kPhaseOffsetCos<kNumPhases>[k];
+        const Scalar offset_sin = kPhaseOffsetSin<kNumPhases>[k];
+        sines(k) = sin_a * offset_cos - cos_a * offset_sin;
+        cosines(k) = cos_a * offset_cos + sin_a * offset_sin;
+    }
+
+    return evaluate_sine_series<kSeries, kNumCoeffs>(
+               normed_bEmf_coeffs.data(), normed_bEmf_coeffs.size(), sines,
+               cosines)
+        .matrix();
+}
+
+// dispatches to an instantiation of the above for common sizes
+template <int kNumPhases = 3>
+Eigen::Matrix<Scalar, kNumPhases, 1>
+get_normed_bEmfs(const BEmfCoeffs& normed_bEmf_coeffs,
+                 const int normed_bEmf_series, const Scalar electrical_angle);
+
+Scalar get_normed_bEmf(const BEmfCoeffs& normed_bEmf_coeffs,
+                       const int normed_bEmf_series,
+                       const Scalar electrical_angle);
 
 // returns normed_bEmfs and bEmfs via output pointers
-void get_bEmfs(const Eigen::Matrix<Scalar, 5, 1>& normed_bEmf_coeffs,
-               const Scalar electrical_angle,
+template <int kNumPhases>
+void get_bEmfs(const BEmfCoeffs& normed_bEmf_coeffs,
+               const int normed_bEmf_series, const Scalar electrical_angle,
                const Scalar electrical_angular_vel,
-               Eigen::Matrix<Scalar, 3, 1>* normed_bEmfs,
-               Eigen::Matrix<Scalar, 3, 1>* bEmfs);
+               Eigen::Matrix<Scalar, kNumPhases, 1>* normed_bEmfs,
+               Eigen::Matrix<Scalar, kNumPhases, 1>* bEmfs);
 
 Scalar
 interp_cogging_torque(const Scalar rotor_angle,
-                      const std::array<Scalar, 3600>& cogging_torque_map);
+                      const std::vector<Scalar>& cogging_torque_map);
 
 // assumes rotor angle > 0
 Scalar get_electrical_angle(const int num_pole_pairs, const Scalar rotor_angle);
@@ -0,0 +1,324 @@
+#include "parameter_identification.h"
+#include "motor.h"
+#include "util/math_constants.h"
+#include "util/numeric_csv.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+// log resistance, log inductance, log bEmf scale, log inertia, and the
+// initial rotor velocity. logs keep the physical parameters positive and
+// make the steps relative
+constexpr int kNumFitParams = 5;
+using FitParams = Eigen::Matrix<Scalar, kNumFitParams, 1>;
+
+constexpr int kResidualsPerSample = 4;
+
+struct Candidate {
+    FitParams x;
+    Eigen::VectorXd residuals;
+    Scalar cost = 0;
+};
+
+MotorParams get_candidate_params(const FitParams& x,
+                                 const MotorParams& initial_params) {
+    MotorParams params = initial_params;
+    params.phase_resistance = std::exp(x(0));
+    params.phase_inductance = std::exp(x(1));
+    params.normed_bEmf_coeffs =
+        initial_params.normed_bEmf_coeffs * std::exp(x(2));
+    params.rotor_inertia = std::exp(x(3));
+    return params;
+}
+
+// wrapped into [-pi, pi]
+Scalar get_angle_error(const Scalar angle, const Scalar reference) {
+    const Scalar error = angle - reference;
+    return error - 2 * kPI * std::round(error / (2 * kPI));
+}
+
+// Threads that live for a whole identification, so that each batch of
+// candidates only wakes them instead of spawning them. The calling thread
+// works alongside them.
+struct WorkerPool {
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable work_done;
+    // the current batch, set under the mutex before generation is bumped
+    const std::function<void(int)>* work = nullptr;
+    int work_count = 0;
+    std::atomic<int> next_idx{0};
+    int num_busy = 0;
+    int generation = 0;
+    bool stopping = false;
+};
+
+void run_pool_work(WorkerPool* pool) {
+    for (int i = pool->next_idx++; i < pool->work_count;
+         i = pool->next_idx++) {
+        (*pool->work)(i);
+    }
+}
+
+void run_pool_worker(WorkerPool* pool) {
+    int seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(pool->mutex);
+            pool->work_ready.wait(lock, [&]() {
+                return pool->stopping || pool->generation != seen_generation;
+            });
+            if (pool->stopping) {
+                return;
+            }
+            seen_generation = pool->generation;
+        }
+        run_pool_work(pool);
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        if (--pool->num_busy == 0) {
+            pool->work_done.notify_one();
+        }
+    }
+}
+
+void start_worker_pool(const int num_threads, WorkerPool* pool) {
+    for (int t = 1; t < num_threads; ++t) {
+        pool->threads.emplace_back(run_pool_worker, pool);
+    }
+}
+
+void stop_worker_pool(WorkerPool* pool) {
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->stopping = true;
+    }
+    pool->work_ready.notify_all();
+    for (std::thread& thread : pool->threads) {
+        thread.join();
+    }
+    pool->threads.clear();
+}
+
+// calls fn(i) for every i in [0, count), returning once all are done
+void parallel_for(const int count, WorkerPool* pool,
+                  const std::function<void(int)>& fn) {
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->work = &fn;
+        pool->work_count = count;
+        pool->next_idx = 0;
+        pool->num_busy = int(pool->threads.size());
+        ++pool->generation;
+    }
+    pool->work_ready.notify_all();
+    run_pool_work(pool);
+    std::unique_lock<std::mutex> lock(pool->mutex);
+    pool->work_done.wait(lock, [&]() { return pool->num_busy == 0; });
+}
+
+void evaluate_candidates(const MotorTrace& trace,
+                         const MotorParams& initial_params,
+                         const IdentificationOptions& options,
+                         WorkerPool* pool,
+                         std::vector<Candidate>* candidates) {
+    parallel_for(candidates->size(), pool, [&](const int i) {
+        Candidate& candidate = (*candidates)[i];
+        get_motor_trace_residuals(
+            trace, get_candidate_params(candidate.x, initial_params),
+            candidate.x(4), options, &candidate.residuals);
+        candidate.cost = candidate.residuals.squaredNorm();
+        // diverged simulations, eg from an inductance too small for the
+        // step, never win
+        if (!std::isfinite(candidate.cost)) {
+            candidate.cost = std::numeric_limits<Scalar>::infinity();
+        }
+    });
+}
+
+} // namespace
+
+bool load_motor_trace_csv(const std::string& path, MotorTrace* trace) {
+    trace->clear();
+    return read_numeric_csv(
+        path, 9, [&](const Scalar* values, const int num_values) {
+            if (num_values < 8) {
+                return;
+            }
+            MotorTraceSample sample;
+            sample.time = values[0];
+            sample.pole_voltages << values[1], values[2], values[3];
+            sample.phase_currents << values[4], values[5], values[6];
+            sample.rotor_angle = values[7];
+            sample.load_torque = num_values > 8 ? values[8] : 0;
+            trace->push_back(sample);
+        });
+}
+
+void get_motor_trace_residuals(const MotorTrace& trace,
+                               const MotorParams& params,
+                               const Scalar initial_rotor_angular_vel,
+                               const IdentificationOptions& options,
+                               Eigen::VectorXd* residuals) {
+    const int count = trace.size();
+    residuals->resize(kResidualsPerSample * std::max(count - 1, 0));
+    if (count < 2) {
+        return;
+    }
+
+    MotorState motor;
+    motor.params = params;
+    motor.electrical.phase_currents = trace[0].phase_currents;
+    motor.kinematic.rotor_angle = trace[0].rotor_angle;
+    motor.kinematic.rotor_angular_vel = initial_rotor_angular_vel;
+
+    const Scalar angle_scale = std::sqrt(options.angle_weight);
+    for (int i = 1; i < count; ++i) {
+        // the recorded voltages hold until the next sample
+        const MotorTraceSample& prev = trace[i - 1];
+        const Scalar dt = (trace[i].time - prev.time) / options.substeps;
+        for (int s = 0; s < options.substeps; ++s) {
+            step_motor(dt, prev.load_torque, prev.pole_voltages, &motor);
+        }
+
+        const int row = kResidualsPerSample * (i - 1);
+        residuals->segment<3>(row) =
+            motor.electrical.phase_currents - trace[i].phase_currents;
+        (*residuals)(row + 3) =
+            angle_scale *
+            get_angle_error(motor.kinematic.rotor_angle, trace[i].rotor_angle);
+    }
+}
+
+bool identify_motor_params(const MotorTrace& trace,
+                           const IdentificationOptions& options,
+                           MotorParams* params,
+                           IdentificationResult* result) {
+    if (trace.size() < 2 || params->phase_resistance <= 0 ||
+        params->phase_inductance <= 0 || params->rotor_inertia <= 0) {
+        return false;
+    }
+    const int num_threads =
+        options.num_threads > 0
+            ? options.num_threads
+            : std::max<int>(std::thread::hardware_concurrency(), 1);
+    constexpr int kNumDampings = 5;
+    constexpr Scalar kDampingSpread[kNumDampings] = {1e-2, 1e-1, 1, 10, 100};
+    // no more threads than the largest batch of candidates can use
+    WorkerPool pool;
+    start_worker_pool(
+        std::min(num_threads, std::max(kNumFitParams, kNumDampings)), &pool);
+    const MotorParams initial_params = *params;
+    int num_simulations = 0;
+
+    std::vector<Candidate> current(1);
+    current[0].x << std::log(params->phase_resistance),
+        std::log(params->phase_inductance), 0,
+        std::log(params->rotor_inertia),
+        get_angle_error(trace[1].rotor_angle, trace[0].rotor_angle) /
+            (trace[1].time - trace[0].time);
+    evaluate_candidates(trace, initial_params, options, &pool, &current);
+    ++num_simulations;
+    if (!std::isfinite(current[0].cost)) {
+        stop_worker_pool(&pool);
+        return false;
+    }
+
+    Scalar damping = 1e-3;
+    std::vector<Candidate> probes(kNumFitParams);
+    std::vector<Candidate> steps(kNumDampings);
+    int iteration = 0;
+    while (iteration < options.max_iterations) {
+        ++iteration;
+        const Candidate& best = current[0];
+
+        // forward difference jacobian, a column per probe
+        FitParams probe_steps;
+        for (int i = 0; i < kNumFitParams; ++i) {
+            probe_steps(i) =
+                i == 4 ? 1e-6 * std::max<Scalar>(1, std::abs(best.x(4)))
+                       : 1e-6;
+            probes[i].x = best.x;
+            probes[i].x(i) += probe_steps(i);
+        }
+        evaluate_candidates(trace, initial_params, options, &pool, &probes);
+        num_simulations += kNumFitParams;
+
+        Eigen::MatrixXd jacobian(best.residuals.size(), kNumFitParams);
+        for (int i = 0; i < kNumFitParams; ++i) {
+            if (std::isfinite(probes[i].cost)) {
+                jacobian.col(i) =
+                    (probes[i].residuals - best.residuals) / probe_steps(i);
+            } else {
+                jacobian.col(i).setZero();
+            }
+        }
+        const Eigen::Matrix<Scalar, kNumFitParams, kNumFitParams> jtj =
+            jacobian.transpose() * jacobian;
+        const FitParams gradient = jacobian.transpose() * best.residuals;
+
+        // try a spread of dampings around the last good one at once
+        for (int i = 0; i < kNumDampings; ++i) {
+            Eigen::Matrix<Scalar, kNumFitParams, kNumFitParams> damped = jtj;
+            damped.diagonal() +=
+                damping * kDampingSpread[i] *
+                (jtj.diagonal().array() + 1e-12).matrix();
+            steps[i].x = best.x - damped.ldlt().solve(gradient);
+        }
+        evaluate_candidates(trace, initial_params, options, &pool, &steps);
+        num_simulations += kNumDampings;
+
+        int best_step = 0;
+        for (int i = 1; i < kNumDampings; ++i) {
+            if (steps[i].cost < steps[best_step].cost) {
+                best_step = i;
+            }
+        }
+        if (steps[best_step].cost < best.cost) {
+            const Scalar improvement =
+                (best.cost - steps[best_step].cost) / best.cost;
+            damping *= kDampingSpread[best_step];
+            std::swap(current[0], steps[best_step]);
+            if (improvement < options.tolerance) {
+                break;
+            }
+        } else {
+            damping *= 10 * kDampingSpread[kNumDampings - 1];
+            if (damping > 1e12) {
+                break;
+            }
+        }
+    }
+
+    stop_worker_pool(&pool);
+
+    const Candidate& best = current[0];
+    *params = get_candidate_params(best.x, initial_params);
+    if (result != nullptr) {
+        const int num_samples = trace.size() - 1;
+        Scalar current_sq = 0;
+        Scalar angle_sq = 0;
+        for (int i = 0; i < num_samples; ++i) {
+            current_sq += best.residuals.segment<3>(kResidualsPerSample * i)
+                              .squaredNorm();
+            angle_sq +=
+                std::pow(best.residuals(kResidualsPerSample * i + 3), 2);
+        }
+        result->rms_current_error = std::sqrt(current_sq / (3 * num_samples));
+        result->rms_angle_error =
+            options.angle_weight > 0
+                ? std::sqrt(angle_sq / options.angle_weight / num_samples)
+                : 0;
+        result->initial_rotor_angular_vel = best.x(4);
+        result->num_iterations = iteration;
+        result->num_simulations = num_simulations;
+    }
+    return true;
+}
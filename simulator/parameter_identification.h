@@ -0,0 +1,73 @@
+#pragma once
+
+#include "config/scalar.h"
+#include "motor_state.h"
+#include <Eigen/Dense>
+#include <string>
+#include <vector>
+
+// Offline identification of the lumped motor parameters from a bench
+// capture. The recorded pole voltages drive step_motor, held over each
+// sample interval, and the parameters are fit by minimizing the error
+// between the simulated and recorded phase currents and rotor angles.
+
+// one row of a capture
+struct MotorTraceSample {
+    Scalar time = 0;
+    // measured from the negative bus rail, as the board applies them
+    Eigen::Matrix<Scalar, 3, 1> pole_voltages =
+        Eigen::Matrix<Scalar, 3, 1>::Zero();
+    Eigen::Matrix<Scalar, 3, 1> phase_currents =
+        Eigen::Matrix<Scalar, 3, 1>::Zero();
+    Scalar rotor_angle = 0; // mechanical, in [0, 2pi)
+    Scalar load_torque = 0; // any known external torque
+};
+
+using MotorTrace = std::vector<MotorTraceSample>;
+
+struct IdentificationOptions {
+    // simulation steps per sample interval of the trace
+    int substeps = 1;
+    // weight of squared angle errors (rad^2) relative to squared current
+    // errors (A^2)
+    Scalar angle_weight = 1;
+    int max_iterations = 100;
+    // stops when an iteration improves the cost by less than this fraction
+    Scalar tolerance = 1e-12;
+    // 0 uses all hardware threads
+    int num_threads = 0;
+};
+
+struct IdentificationResult {
+    Scalar rms_current_error = 0;
+    Scalar rms_angle_error = 0;
+    // fit alongside the parameters, since the trace need not start at rest
+    Scalar initial_rotor_angular_vel = 0;
+    int num_iterations = 0;
+    int num_simulations = 0;
+};
+
+// Reads "time, va, vb, vc, ia, ib, ic, rotor_angle[, load_torque]" rows, see
+// read_numeric_csv. Returns false if the file can not be read.
+bool load_motor_trace_csv(const std::string& path, MotorTrace* trace);
+
+// Replays the trace from its first sample, filling residuals with the
+// simulated minus recorded phase currents and the weighted angle error of
+// each following sample.
+void get_motor_trace_residuals(const MotorTrace& trace,
+                               const MotorParams& params,
+                               const Scalar initial_rotor_angular_vel,
+                               const IdentificationOptions& options,
+                               Eigen::VectorXd* residuals);
+
+// Fits phase_resistance, phase_inductance, rotor_inertia and the scale of
+// normed_bEmf_coeffs, keeping the shape of the bEmf, by Levenberg-Marquardt
+// with finite difference jacobians. params holds the initial guess and the
+// parameters that are not fit. The jacobian columns and a spread of
+// damping factors are simulated in parallel each iteration. Returns false,
+// leaving params unchanged, if the trace is too short or the initial guess
+// does not simulate.
+bool identify_motor_params(const MotorTrace& trace,
+                           const IdentificationOptions& options,
+                           MotorParams* params,
+                           IdentificationResult* result = nullptr);
@@ -0,0 +1,117 @@
+#include "motor.h"
+#include "parameter_identification.h"
+#include "util/math_constants.h"
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+
+namespace {
+
+MotorParams get_true_params() {
+    MotorParams params;
+    params.num_pole_pairs = 4;
+    params.phase_resistance = 0.5;
+    params.phase_inductance = 5e-4;
+    params.rotor_inertia = 1e-4;
+    params.normed_bEmf_coeffs.setZero(2);
+    params.normed_bEmf_coeffs << 0.02, 0.002;
+    return params;
+}
+
+// spins the motor up open loop with a rotating voltage, recording every
+// kSubsteps simulation steps
+constexpr int kSubsteps = 10;
+MotorTrace record_trace(const MotorParams& params) {
+    constexpr Scalar kDt = 1e-5;
+    MotorState motor;
+    motor.params = params;
+    motor.kinematic.rotor_angular_vel = 5;
+
+    MotorTrace trace;
+    for (int i = 0; i < 2000; ++i) {
+        const Scalar t = i * kSubsteps * kDt;
+        const Scalar angle = 2 * kPI * 20 * t * t;
+        MotorTraceSample sample;
+        sample.time = t;
+        for (int k = 0; k < 3; ++k) {
+            sample.pole_voltages(k) =
+                12 + 2 * std::cos(angle - 2 * kPI * k / 3);
+        }
+        sample.phase_currents = motor.electrical.phase_currents;
+        sample.rotor_angle = motor.kinematic.rotor_angle;
+        trace.push_back(sample);
+        for (int s = 0; s < kSubsteps; ++s) {
+            step_motor(kDt, 0, sample.pole_voltages, &motor);
+        }
+    }
+    return trace;
+}
+
+} // namespace
+
+TEST(get_motor_trace_residuals, zero_for_true_params) {
+    const MotorParams params = get_true_params();
+    const MotorTrace trace = record_trace(params);
+    IdentificationOptions options;
+    options.substeps = kSubsteps;
+    Eigen::VectorXd residuals;
+    get_motor_trace_residuals(trace, params, /*initial_rotor_angular_vel=*/5,
+                              options, &residuals);
+    ASSERT_EQ(residuals.size(), 4 * (trace.size() - 1));
+    EXPECT_LT(residuals.cwiseAbs().maxCoeff(), 1e-12);
+}
+
+TEST(identify_motor_params, recovers_params) {
+    const MotorParams true_params = get_true_params();
+    const MotorTrace trace = record_trace(true_params);
+
+    MotorParams params = true_params;
+    params.phase_resistance *= 1.5;
+    params.phase_inductance *= 0.7;
+    params.rotor_inertia *= 2;
+    params.normed_bEmf_coeffs *= 0.8;
+
+    IdentificationOptions options;
+    options.substeps = kSubsteps;
+    options.num_threads = 4;
+    IdentificationResult result;
+    ASSERT_TRUE(identify_motor_params(trace, options, &params, &result));
+
+    EXPECT_NEAR(params.phase_resistance, true_params.phase_resistance, 1e-6);
+    EXPECT_NEAR(params.phase_inductance, true_params.phase_inductance, 1e-9);
+    EXPECT_NEAR(params.rotor_inertia, true_params.rotor_inertia, 1e-9);
+    for (int i = 0; i < 2; ++i) {
+        EXPECT_NEAR(params.normed_bEmf_coeffs(i),
+                    true_params.normed_bEmf_coeffs(i), 1e-8);
+    }
+    EXPECT_NEAR(result.initial_rotor_angular_vel, 5, 1e-4);
+    EXPECT_LT(result.rms_current_error, 1e-6);
+    EXPECT_LT(result.rms_angle_error, 1e-6);
+}
+
+TEST(identify_motor_params, rejects_short_trace) {
+    MotorParams params = get_true_params();
+    MotorTrace trace(1);
+    EXPECT_FALSE(identify_motor_params(trace, {}, &params));
+    EXPECT_EQ(params.phase_resistance, get_true_params().phase_resistance);
+}
+
+TEST(load_motor_trace_csv, reads_rows) {
+    const std::string csv_path = testing::TempDir() + "trace.csv";
+    {
+        std::ofstream csv(csv_path);
+        csv << "t, va, vb, vc, ia, ib, ic, angle\n";
+        csv << "0, 1, 2, 3, 0.1, 0.2, -0.3, 0.5\n";
+        csv << "1e-4, 4, 5, 6, 0.4, 0.5, -0.9, 0.6, 0.01\n";
+    }
+    MotorTrace trace;
+    ASSERT_TRUE(load_motor_trace_csv(csv_path, &trace));
+    ASSERT_EQ(trace.size(), 2);
+    EXPECT_EQ(trace[0].pole_voltages(2), 3);
+    EXPECT_EQ(trace[0].phase_currents(1), 0.2);
+    EXPECT_EQ(trace[0].rotor_angle, 0.5);
+    EXPECT_EQ(trace[0].load_torque, 0);
+    EXPECT_EQ(trace[1].time, 1e-4);
+    EXPECT_EQ(trace[1].load_torque, 0.01);
+    std::remove(csv_path.c_str());
+}
@@ -0,0 +1,84 @@
+#include "controls/space_vector_modulation.h"
+#include "foc_replay.h"
+#include "motor.h"
+#include <chrono>
+#include <cstdio>
+#include <gflags/gflags.h>
+
+// Streams a recorded trace through the FOC current controller and the
+// modulator without the motor, see foc_replay.h for the trace format.
+// Reports the throughput of the control stack alone, and with --reference
+// checks that the commanded duties are bit for bit those of an earlier run
+// saved with --output.
+
+DEFINE_string(trace, "", "csv of electrical_angle, ia, ib, ic[, torque]");
+DEFINE_string(output, "", "saves the commanded duties here if set");
+DEFINE_string(reference, "", "duties of an earlier run to compare against");
+DEFINE_int32(repeat, 10, "timed runs over the trace, the fastest counts");
+DEFINE_double(torque, 0, "desired torque where the trace has none (N . m)");
+DEFINE_double(bEmf_constant, 0.01, "first normed bEmf coefficient (V . s)");
+DEFINE_double(resistance, 1.0, "phase resistance for the PI gains (ohm)");
+DEFINE_double(inductance, 1e-3, "phase inductance for the PI gains (H)");
+DEFINE_double(bandwidth, 10000, "current loop bandwidth (rad/s)");
+DEFINE_double(period, 1.0 / 10000, "controller period (sec)");
+DEFINE_double(bus_voltage, 24, "");
+DEFINE_bool(anti_windup, true, "");
+DEFINE_int32(pwm_strategy, kPwmCentered, "kPwm* constant");
+DEFINE_int32(overmodulation_mode, kOvermodulationClip,
+             "kOvermodulation* constant");
+
+int main(int argc, char* argv[]) {
+    gflags::ParseCommandLineFlags(&argc, &argv, /*remove_flags*/ true);
+
+    std::vector<ReplaySample> trace;
+    if (!load_replay_trace_csv(FLAGS_trace, FLAGS_torque, &trace)) {
+        std::fprintf(stderr, "Could not read %s\n", FLAGS_trace.c_str());
+        return 1;
+    }
+
+    ReplayParams params;
+    params.foc.period = FLAGS_period;
+    params.foc.i_controller_params = make_motor_pi_params(
+        FLAGS_bandwidth, FLAGS_resistance, FLAGS_inductance);
+    params.normed_bEmf0 = FLAGS_bEmf_constant;
+    params.bus_voltage = FLAGS_bus_voltage;
+    params.anti_windup = FLAGS_anti_windup;
+    params.pwm_strategy = FLAGS_pwm_strategy;
+    params.overmodulation_mode = FLAGS_overmodulation_mode;
+
+    std::vector<ReplayDuties> duties;
+    double best_sec = 0;
+    for (int i = 0; i < std::max(FLAGS_repeat, 1); ++i) {
+        const auto begin = std::chrono::steady_clock::now();
+        replay_foc(params, trace, &duties);
+        const std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - begin;
+        if (i == 0 || elapsed.count() < best_sec) {
+            best_sec = elapsed.count();
+        }
+    }
+    std::printf("%d cycles in %g sec, %g ns per cycle\n", int(trace.size()),
+                best_sec, best_sec * 1e9 / std::max<int>(trace.size(), 1));
+
+    if (!FLAGS_output.empty() && !save_replay_duties(FLAGS_output, duties)) {
+        std::fprintf(stderr, "Could not write %s\n", FLAGS_output.c_str());
+        return 1;
+    }
+
+    if (!FLAGS_reference.empty()) {
+        std::vector<ReplayDuties> reference;
+        if (!load_replay_duties(FLAGS_reference, &reference)) {
+            std::fprintf(stderr, "Could not read %s\n",
+                         FLAGS_reference.c_str());
+            return 1;
+        }
+        const int mismatch = find_first_duty_mismatch(duties, reference);
+        if (mismatch >= 0) {
+            std::printf("duties differ from %s at cycle %d\n",
+                        FLAGS_reference.c_str(), mismatch);
+            return 2;
+        }
+        std::printf("duties match %s\n", FLAGS_reference.c_str());
+    }
+    return 0;
+}
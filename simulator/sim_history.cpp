@@ -0,0 +1,153 @@
+#include "sim_history.h"
+#include "simulation.h"
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+bool is_same_motor_params(const MotorParams& a, const MotorParams& b) {
+    return a.num_pole_pairs == b.num_pole_pairs &&
+           a.rotor_inertia == b.rotor_inertia &&
+           a.phase_inductance == b.phase_inductance &&
+           a.phase_resistance == b.phase_resistance &&
+           a.normed_bEmf_series == b.normed_bEmf_series &&
+           a.normed_bEmf_coeffs.size() == b.normed_bEmf_coeffs.size() &&
+           a.normed_bEmf_coeffs == b.normed_bEmf_coeffs &&
+           (a.cogging_torque_map == b.cogging_torque_map ||
+            *a.cogging_torque_map == *b.cogging_torque_map);
+}
+
+void take_sim_snapshot(const SimState& state,
+                       std::shared_ptr<const MotorParams> motor_params,
+                       SimSnapshot* snapshot) {
+    snapshot->time = state.time;
+    snapshot->dt = state.dt;
+    snapshot->load_torque = state.load_torque;
+
+    snapshot->board = state.board;
+    snapshot->motor_params = std::move(motor_params);
+    snapshot->electrical = state.motor.electrical;
+    snapshot->kinematic = state.motor.kinematic;
+
+    snapshot->commutation_mode = state.commutation_mode;
+    snapshot->six_step_phase_advance = state.six_step_phase_advance;
+    snapshot->foc_desired_torque = state.foc_desired_torque;
+    snapshot->foc_use_qd_decoupling = state.foc_use_qd_decoupling;
+    snapshot->foc_use_cogging_compensation =
+        state.foc_use_cogging_compensation;
+    snapshot->foc_non_sinusoidal_drive_mode =
+        state.foc_non_sinusoidal_drive_mode;
+    snapshot->foc_pi_anti_windup = state.foc_pi_anti_windup;
+    snapshot->foc_use_rotor_estimator = state.foc_use_rotor_estimator;
+    snapshot->foc_pwm_strategy = state.foc_pwm_strategy;
+    snapshot->foc_overmodulation_mode = state.foc_overmodulation_mode;
+    snapshot->foc = state.foc;
+
+    snapshot->encoder_counts = state.encoder_counts;
+    snapshot->rotor_estimator = state.rotor_estimator;
+
+    snapshot->outputs = state.outputs;
+}
+
+void restore_sim_snapshot(const SimSnapshot& snapshot, SimState* state) {
+    state->time = snapshot.time;
+    state->dt = snapshot.dt;
+    state->load_torque = snapshot.load_torque;
+
+    state->board = snapshot.board;
+    state->motor.params = *snapshot.motor_params;
+    state->motor.electrical = snapshot.electrical;
+    state->motor.kinematic = snapshot.kinematic;
+
+    state->commutation_mode = snapshot.commutation_mode;
+    state->six_step_phase_advance = snapshot.six_step_phase_advance;
+    state->foc_desired_torque = snapshot.foc_desired_torque;
+    state->foc_use_qd_decoupling = snapshot.foc_use_qd_decoupling;
+    state->foc_use_cogging_compensation =
+        snapshot.foc_use_cogging_compensation;
+    state->foc_non_sinusoidal_drive_mode =
+        snapshot.foc_non_sinusoidal_drive_mode;
+    state->foc_pi_anti_windup = snapshot.foc_pi_anti_windup;
+    state->foc_use_rotor_estimator = snapshot.foc_use_rotor_estimator;
+    state->foc_pwm_strategy = snapshot.foc_pwm_strategy;
+    state->foc_overmodulation_mode = snapshot.foc_overmodulation_mode;
+    state->foc = snapshot.foc;
+
+    state->encoder_counts = snapshot.encoder_counts;
+    state->rotor_estimator = snapshot.rotor_estimator;
+
+    state->outputs = snapshot.outputs;
+}
+
+} // namespace
+
+void record_sim_snapshot(const SimState& state, SimHistory* history) {
+    if (state.commutation_mode == kCommutationModePlugin ||
+        state.commutation_mode == kCommutationModeCoSim) {
+        clear_sim_history(history);
+        return;
+    }
+
+    std::deque<SimSnapshot>& snapshots = history->snapshots;
+    while (!snapshots.empty() && snapshots.back().time > state.time) {
+        snapshots.pop_back();
+    }
+    // only the settings can differ from a snapshot at the same time
+    if (!snapshots.empty() && snapshots.back().time == state.time) {
+        snapshots.pop_back();
+    }
+
+    std::shared_ptr<const MotorParams> motor_params;
+    if (!snapshots.empty() &&
+        is_same_motor_params(*snapshots.back().motor_params,
+                             state.motor.params)) {
+        motor_params = snapshots.back().motor_params;
+    } else {
+        motor_params = std::make_shared<const MotorParams>(state.motor.params);
+    }
+
+    snapshots.emplace_back();
+    take_sim_snapshot(state, std::move(motor_params), &snapshots.back());
+    while (int(snapshots.size()) > std::max(history->capacity, 1)) {
+        snapshots.pop_front();
+    }
+    history->end_time = state.time;
+}
+
+bool seek_sim_history(const SimHistory& history, const Scalar time,
+                      SimState* state) {
+    const std::deque<SimSnapshot>& snapshots = history.snapshots;
+    if (snapshots.empty() || time < snapshots.front().time) {
+        return false;
+    }
+    const Scalar target = std::min(time, history.end_time);
+
+    // the last snapshot at or before the target
+    const auto after = std::upper_bound(
+        snapshots.begin(), snapshots.end(), target,
+        [](const Scalar t, const SimSnapshot& snapshot) {
+            return t < snapshot.time;
+        });
+    restore_sim_snapshot(*std::prev(after), state);
+
+    // set aside while replaying, these saw the steps the first time
+    TelemetryStats telemetry_stats;
+    TriggerCapture<TelemetrySample> scope;
+    TelemetryFeedWriter telemetry_feed;
+    TelemetryServer telemetry_server;
+    std::swap(telemetry_stats, state->telemetry_stats);
+    std::swap(scope, state->scope);
+    std::swap(telemetry_feed, state->telemetry_feed);
+    std::swap(telemetry_server, state->telemetry_server);
+
+    TelemetrySample sample;
+    while (target - state->time > state->dt / 2) {
+        step_simulation(state, &sample);
+    }
+
+    std::swap(telemetry_stats, state->telemetry_stats);
+    std::swap(scope, state->scope);
+    std::swap(telemetry_feed, state->telemetry_feed);
+    std::swap(telemetry_server, state->telemetry_server);
+    return true;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "board/board_state.h"
+#include "config/scalar.h"
+#include "controls/foc_state.h"
+#include "controls/kalman_estimator.h"
+#include "motor_state.h"
+#include "sim_outputs.h"
+#include "sim_state.h"
+#include <deque>
+#include <memory>
+
+// Time travel through recent history. Snapshots of the simulation are
+// kept in a bounded ring, and since stepping is deterministic any earlier
+// time is reached by restoring the nearest snapshot before it and
+// stepping forward again, rather than storing every step.
+//
+// Snapshots are taken between batches of steps, before each batch, so
+// settings changed from the gui take effect at a snapshot and a replay
+// applies them at the same step. The motor params are only copied when
+// they change, snapshots in between share them.
+//
+// Plugin and co-sim controllers keep state outside the simulation that
+// can not be rewound, so no history is kept while they are running.
+
+// what a step reads and writes, without the gui's analysis state or the
+// exports to other processes
+struct SimSnapshot {
+    Scalar time = 0;
+    Scalar dt = 0;
+    Scalar load_torque = 0;
+
+    BoardState board;
+    std::shared_ptr<const MotorParams> motor_params;
+    MotorElectricalState electrical;
+    MotorKinematicState kinematic;
+
+    int commutation_mode = kCommutationModeManual;
+    Scalar six_step_phase_advance = 0;
+    Scalar foc_desired_torque = 0;
+    bool foc_use_qd_decoupling = false;
+    bool foc_use_cogging_compensation = false;
+    bool foc_non_sinusoidal_drive_mode = false;
+    bool foc_pi_anti_windup = true;
+    bool foc_use_rotor_estimator = false;
+    int foc_pwm_strategy = kPwmCentered;
+    int foc_overmodulation_mode = kOvermodulationClip;
+    FocState foc;
+
+    int encoder_counts = 0;
+    KalmanEstimator rotor_estimator;
+
+    SimOutputs outputs;
+};
+
+struct SimHistory {
+    int capacity = 4096; // snapshots, the oldest are dropped beyond this
+    std::deque<SimSnapshot> snapshots; // oldest first
+    Scalar end_time = 0; // latest time simulated, see extend_sim_history
+};
+
+inline void clear_sim_history(SimHistory* history) {
+    history->snapshots.clear();
+    history->end_time = 0;
+}
+
+// Call before each batch of steps. Snapshots after the state's time, left
+// by seeking back, are dropped, since the run now branches from here.
+void record_sim_snapshot(const SimState& state, SimHistory* history);
+
+// call after each batch of steps
+inline void extend_sim_history(const SimState& state, SimHistory* history) {
+    if (!history->snapshots.empty()) {
+        history->end_time = state.time;
+    }
+}
+
+inline Scalar get_sim_history_begin_time(const SimHistory& history) {
+    return history.snapshots.empty() ? 0 : history.snapshots.front().time;
+}
+
+// Sets the state to how it was at the time, clamped to the end of the
+// history, by replaying from the nearest snapshot. The replay leaves the
+// telemetry statistics, the scope and the telemetry exports alone.
+// Returns false if the time is before the history.
+bool seek_sim_history(const SimHistory& history, const Scalar time,
+                      SimState* state);
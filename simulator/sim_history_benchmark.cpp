@@ -0,0 +1,65 @@
+#include "simulator/motor.h"
+#include "simulator/sim_history.h"
+#include "simulator/simulation.h"
+#include "util/random.h"
+#include <benchmark/benchmark.h>
+
+namespace {
+
+// a second of foc in batches of steps_per_snapshot
+void init_history(const int steps_per_snapshot, SimState* state,
+                  SimHistory* history) {
+    init_sim_state(state);
+    state->foc.i_controller_params = make_motor_pi_params(
+        /*bandwidth=*/10000, state->motor.params.phase_resistance,
+        state->motor.params.phase_inductance);
+    state->commutation_mode = kCommutationModeFOC;
+    state->foc_desired_torque = 0.05;
+    history->capacity = 1000000 / steps_per_snapshot;
+    TelemetrySample sample;
+    for (int i = 0; i < history->capacity; ++i) {
+        record_sim_snapshot(*state, history);
+        for (int j = 0; j < steps_per_snapshot; ++j) {
+            step_simulation(state, &sample);
+        }
+        extend_sim_history(*state, history);
+    }
+}
+
+} // namespace
+
+// the cost of a scrub, on average half a snapshot interval of replay
+static void BM_SeekSimHistory(benchmark::State& bm_state) {
+    SimState state;
+    SimHistory history;
+    init_history(bm_state.range(0), &state, &history);
+    const Scalar begin = get_sim_history_begin_time(history);
+    const Scalar span = history.end_time - begin;
+    RandomStream rng;
+    init_random_stream(/*seed=*/0, /*stream=*/0, /*instance=*/0, &rng);
+    for (auto _ : bm_state) {
+        const Scalar time = begin + span * random_uniform(&rng);
+        if (!seek_sim_history(history, time, &state)) {
+            bm_state.SkipWithError("seek before the history");
+            break;
+        }
+        benchmark::DoNotOptimize(state.motor.kinematic.rotor_angle);
+    }
+}
+BENCHMARK(BM_SeekSimHistory)
+    ->ArgName("steps_per_snapshot")
+    ->Arg(100)
+    ->Arg(1000)
+    ->Unit(benchmark::kMicrosecond);
+
+// the cost of recording, once per batch of steps
+static void BM_RecordSimSnapshot(benchmark::State& bm_state) {
+    SimState state;
+    SimHistory history;
+    init_history(1000, &state, &history);
+    for (auto _ : bm_state) {
+        // the same time replaces the last snapshot, keeping the size
+        record_sim_snapshot(state, &history);
+    }
+}
+BENCHMARK(BM_RecordSimSnapshot);
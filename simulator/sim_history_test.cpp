@@ -0,0 +1,137 @@
+#include "simulator/sim_history.h"
+#include "simulator/motor.h"
+#include "simulator/simulation.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace {
+
+void init_foc_sim_state(SimState* state) {
+    init_sim_state(state);
+    state->foc.i_controller_params = make_motor_pi_params(
+        /*bandwidth=*/10000, state->motor.params.phase_resistance,
+        state->motor.params.phase_inductance);
+    state->commutation_mode = kCommutationModeFOC;
+    state->foc_desired_torque = 0.05;
+}
+
+// runs batches of steps like the gui, recording before each batch
+void run_batches(const int num_batches, const int batch_size,
+                 SimState* state, SimHistory* history,
+                 std::vector<TelemetrySample>* samples) {
+    TelemetrySample sample;
+    for (int i = 0; i < num_batches; ++i) {
+        record_sim_snapshot(*state, history);
+        for (int j = 0; j < batch_size; ++j) {
+            step_simulation(state, &sample);
+            if (samples != nullptr) {
+                samples->push_back(sample);
+            }
+        }
+        extend_sim_history(*state, history);
+    }
+}
+
+// what a replayed step reports, which covers the state it read
+TelemetrySample step_once(SimState* state) {
+    TelemetrySample sample;
+    step_simulation(state, &sample);
+    return sample;
+}
+
+} // namespace
+
+TEST(sim_history, seek_replays_exactly) {
+    SimState state;
+    init_foc_sim_state(&state);
+    SimHistory history;
+    std::vector<TelemetrySample> samples;
+    run_batches(50, 100, &state, &history, &samples);
+    ASSERT_EQ(history.snapshots.size(), 50u);
+
+    // between snapshots, on one, and at the very end
+    for (const int step : {1234, 2000, 4321, 4998}) {
+        const Scalar time = samples[step][kTelemetryTime];
+        ASSERT_TRUE(seek_sim_history(history, time, &state));
+        EXPECT_EQ(state.time, time);
+        // bit for bit, so later steps match too
+        EXPECT_EQ(step_once(&state), samples[step + 1]) << step;
+    }
+
+    // back to the end, then forward from where the run left off
+    ASSERT_TRUE(seek_sim_history(history, history.end_time, &state));
+    EXPECT_EQ(state.time, samples.back()[kTelemetryTime]);
+}
+
+TEST(sim_history, replay_follows_settings_changes) {
+    SimState state;
+    init_foc_sim_state(&state);
+    SimHistory history;
+    std::vector<TelemetrySample> samples;
+    run_batches(10, 100, &state, &history, &samples);
+    // as the gui would, between batches
+    state.foc_desired_torque = -0.05;
+    state.motor.params.phase_resistance *= 2;
+    std::vector<Scalar> cogging_torque_map =
+        *state.motor.params.cogging_torque_map;
+    cogging_torque_map[0] = 0.01;
+    state.motor.params.cogging_torque_map =
+        std::make_shared<const std::vector<Scalar>>(cogging_torque_map);
+    run_batches(10, 100, &state, &history, &samples);
+
+    // only the snapshots after the change hold new params
+    EXPECT_EQ(history.snapshots[0].motor_params,
+              history.snapshots[9].motor_params);
+    EXPECT_NE(history.snapshots[9].motor_params,
+              history.snapshots[10].motor_params);
+
+    ASSERT_TRUE(seek_sim_history(history, samples[500][kTelemetryTime],
+                                 &state));
+    EXPECT_EQ(state.foc_desired_torque, 0.05);
+    EXPECT_EQ((*state.motor.params.cogging_torque_map)[0], 0);
+    EXPECT_EQ(step_once(&state), samples[501]);
+
+    ASSERT_TRUE(seek_sim_history(history, samples[1500][kTelemetryTime],
+                                 &state));
+    EXPECT_EQ(state.foc_desired_torque, -0.05);
+    EXPECT_EQ(step_once(&state), samples[1501]);
+}
+
+TEST(sim_history, bounded_and_branches) {
+    SimState state;
+    init_foc_sim_state(&state);
+    SimHistory history;
+    history.capacity = 8;
+    std::vector<TelemetrySample> samples;
+    run_batches(20, 10, &state, &history, &samples);
+    EXPECT_EQ(history.snapshots.size(), 8u);
+    EXPECT_FALSE(seek_sim_history(history, 0, &state));
+
+    // resuming from an earlier time discards the old future
+    const Scalar time = samples[150][kTelemetryTime];
+    ASSERT_TRUE(seek_sim_history(history, time, &state));
+    run_batches(1, 10, &state, &history, nullptr);
+    EXPECT_EQ(history.snapshots.back().time, time);
+    EXPECT_EQ(history.end_time, state.time);
+}
+
+TEST(sim_history, replay_leaves_exports_and_stats_alone) {
+    SimState state;
+    init_foc_sim_state(&state);
+    SimHistory history;
+    run_batches(10, 100, &state, &history, nullptr);
+    const int64_t count = state.telemetry_stats.signals[0].total.count;
+
+    ASSERT_TRUE(seek_sim_history(history, state.time / 2, &state));
+    EXPECT_EQ(state.telemetry_stats.signals[0].total.count, count);
+}
+
+TEST(sim_history, skips_external_controllers) {
+    SimState state;
+    init_foc_sim_state(&state);
+    SimHistory history;
+    run_batches(5, 10, &state, &history, nullptr);
+    state.commutation_mode = kCommutationModePlugin;
+    run_batches(5, 10, &state, &history, nullptr);
+    EXPECT_TRUE(history.snapshots.empty());
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "config/scalar.h"
+#include <Eigen/Dense>
+#include <complex>
+
+// Signals derived from the simulation state by step_simulation and shared
+// by the controllers, GUI and telemetry. The rotor frame is derived at the
+// end of each step and the next step's controllers reuse it. The drive
+// outputs are what the board applied over the latest step.
+struct SimOutputs {
+    // set when the state was edited outside step_simulation in a way that
+    // moves the rotor frame, eg. a fresh state or a new pole pair count
+    bool rotor_frame_stale = true;
+    Scalar electrical_angle = 0;
+    std::complex<Scalar> park_transform = 1; // rotates ab frame into qd frame
+    std::complex<Scalar> current_qd = 0;
+
+    // what the board applies with its current gate state
+    Eigen::Matrix<Scalar, 3, 1> pole_voltages =
+        Eigen::Matrix<Scalar, 3, 1>::Zero();
+    Eigen::Matrix<Scalar, 3, 1> phase_voltages =
+        Eigen::Matrix<Scalar, 3, 1>::Zero();
+    Scalar power_draw = 0; // power drawn from v_bus
+};
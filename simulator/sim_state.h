@@ -1,16 +1,30 @@
 #pragma once
 
+#include "analysis/trigger.h"
 #include "board/board_state.h"
 #include "config/scalar.h"
+#include "controller_plugin_host.h"
 #include "controls/foc_state.h"
+#include "controls/kalman_estimator.h"
 #include "controls/pi_control.h"
+#include "controls/space_vector_modulation.h"
+#include "ipc/lockstep_channel.h"
+#include "ipc/telemetry_feed.h"
+#include "ipc/telemetry_stream.h"
 #include "motor_state.h"
+#include "sim_outputs.h"
+#include "telemetry.h"
+#include "util/random.h"
 #include <Eigen/Dense>
 
 constexpr int kCommutationModeManual = 0;
 constexpr int kCommutationModeSixStep = 1;
 constexpr int kCommutationModeFOC = 2;
+constexpr int kCommutationModePlugin = 3;
+constexpr int kCommutationModeCoSim = 4;
 
+// fields that steps read or write also belong in SimSnapshot, see
+// sim_history.h
 struct SimState {
     Scalar time = 0;
     bool paused = false;
@@ -19,6 +33,10 @@ struct SimState {
 
     Scalar load_torque = 0;
 
+    // streams of random numbers are keyed by this, see util/random.h
+    uint64_t seed = 0;
+    RandomStream cogging_rng;
+
     BoardState board;
     MotorState motor;
 
@@ -33,10 +51,65 @@ struct SimState {
     bool foc_use_cogging_compensation = false;
     bool foc_non_sinusoidal_drive_mode = false;
     bool foc_pi_anti_windup = true;
+    // read the rotor through the encoder and estimator instead of exactly
+    bool foc_use_rotor_estimator = false;
+    int foc_pwm_strategy = kPwmCentered;
+    int foc_overmodulation_mode = kOvermodulationClip;
     FocState foc;
+
+    // plugin state, loaded from the gui. the plugin also reads
+    // foc_desired_torque
+    ControllerPlugin controller_plugin;
+
+    // co-simulation state. the gui creates the channel and a controller in
+    // another process answers on it, see ipc/cosim_controller.cpp. a
+    // controller that does not answer within the timeout pauses the sim
+    LockstepEndpoint cosim;
+    Scalar cosim_period = 1.0 / 10000; // sec
+    Scalar cosim_timer = 0;
+    double cosim_timeout = 0.5; // sec of wall time
+    bool cosim_timed_out = false;
+    BiroControllerOutputs cosim_outputs = {};
+
+    // rotor encoder, read by the estimator at the foc rate
+    int encoder_counts = 4096; // per revolution
+    KalmanEstimator rotor_estimator;
+
+    // derived signals of the latest step
+    SimOutputs outputs;
+
+    // summary statistics, updated every step
+    TelemetryStats telemetry_stats;
+
+    // oscilloscope style capture at the full step rate
+    TriggerCapture<TelemetrySample> scope;
+
+    // every sample, for other processes, when opened from the gui
+    TelemetryFeedWriter telemetry_feed;
+    TelemetryServer telemetry_server;
 };
 
+// starts from the true rotor angle, at rest
+inline void init_rotor_estimator(SimState* state) {
+    KalmanEstimatorParams params;
+    params.dt = state->foc.period;
+    params.measurement_variance = get_encoder_variance(state->encoder_counts);
+    init_kalman_estimator(params, state->motor.kinematic.rotor_angle,
+                          &state->rotor_estimator);
+}
+
+// call when the encoder or the foc period changes, tracking carries on
+// from the current estimate
+inline void retune_rotor_estimator(SimState* state) {
+    const EstimatorVector estimate = state->rotor_estimator.estimate;
+    init_rotor_estimator(state);
+    state->rotor_estimator.estimate = estimate;
+}
+
 inline void init_sim_state(SimState* state) {
     init_motor_state(&state->motor);
-    state->board.gate.dead_time = 2 * state->dt;
+    set_dead_time(2 * state->dt, state->dt, &state->board.gate);
+    init_random_stream(state->seed, kRandomStreamCogging, /*instance=*/0,
+                       &state->cogging_rng);
+    init_rotor_estimator(state);
 }
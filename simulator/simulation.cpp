@@ -0,0 +1,285 @@
+#include "simulation.h"
+#include "controls/foc.h"
+#include "controls/kalman_estimator.h"
+#include "controls/pi_control.h"
+#include "controls/six_step.h"
+#include "controls/space_vector_modulation.h"
+#include "motor.h"
+#include "util/clarke_transform.h"
+#include "util/math_constants.h"
+#include "util/quantization.h"
+#include "util/rotation.h"
+#include "util/time.h"
+#include <array>
+
+namespace {
+
+// the encoder reports the middle of the count the rotor is in
+Scalar read_encoder(const int counts_per_rev, const Scalar rotor_angle) {
+    const Scalar resolution = 2 * kPI / counts_per_rev;
+    return quantize(resolution, rotor_angle) + resolution / 2;
+}
+
+// the rotor as the controllers see it
+struct ControllerRotor {
+    Scalar rotor_angle;
+    Scalar rotor_angular_vel;
+    std::complex<Scalar> park_transform;
+    std::complex<Scalar> current_qd;
+    Eigen::Matrix<Scalar, 3, 1> normed_bEmfs;
+};
+
+ControllerRotor get_controller_rotor(const SimState& state) {
+    if (!state.foc_use_rotor_estimator) {
+        return {state.motor.kinematic.rotor_angle,
+                state.motor.kinematic.rotor_angular_vel,
+                state.outputs.park_transform, state.outputs.current_qd,
+                state.motor.electrical.normed_bEmfs};
+    }
+
+    // extrapolated from the last estimator update
+    ControllerRotor rotor;
+    rotor.rotor_angle =
+        extrapolate_kalman_angle(state.rotor_estimator, state.foc.timer);
+    rotor.rotor_angular_vel = state.rotor_estimator.estimate(kEstimateVel);
+    const Scalar electrical_angle = get_electrical_angle(
+        state.motor.params.num_pole_pairs, rotor.rotor_angle);
+    rotor.park_transform = get_rotation(-(electrical_angle + kQAxisOffset));
+    rotor.current_qd = abc_to_qd(state.motor.electrical.phase_currents,
+                                 rotor.park_transform);
+    rotor.normed_bEmfs = get_normed_bEmfs(state.motor.params.normed_bEmf_coeffs,
+                                          state.motor.params.normed_bEmf_series,
+                                          electrical_angle);
+    return rotor;
+}
+
+void step_foc(const bool new_pwm_cycle, SimState* state_ptr) {
+    SimState& state = *state_ptr; // convenience ref
+
+    if (periodic_timer(state.foc.period, state.dt, &state.foc.timer)) {
+        step_kalman_estimator(
+            read_encoder(state.encoder_counts,
+                         state.motor.kinematic.rotor_angle),
+            &state.rotor_estimator);
+        const ControllerRotor rotor = get_controller_rotor(state);
+
+        Scalar desired_torque = state.foc_desired_torque;
+        if (state.foc_use_cogging_compensation) {
+            desired_torque -= interp_cogging_torque(
+                rotor.rotor_angle, *state.motor.params.cogging_torque_map);
+        }
+
+        std::complex<Scalar> desired_current_qd;
+        if (state.foc_non_sinusoidal_drive_mode) {
+            desired_current_qd = get_desired_current_qd_non_sinusoidal(
+                desired_torque, rotor.park_transform, rotor.normed_bEmfs);
+        } else {
+            desired_current_qd = get_desired_current_qd(
+                desired_torque, state.motor.params.normed_bEmf_coeffs(0));
+        }
+
+        step_foc_current_controller(desired_current_qd, rotor.current_qd,
+                                    &state.foc);
+
+        if (state.foc_pi_anti_windup) {
+            unwind_foc_current_controller(state.board.bus_voltage, &state.foc);
+        }
+    }
+
+    // assert the requested qd voltage with PWM
+    if (new_pwm_cycle) {
+        const ControllerRotor rotor = get_controller_rotor(state);
+        const std::complex<Scalar> inv_park_transform =
+            std::conj(rotor.park_transform);
+
+        std::complex<Scalar> voltage_ab =
+            inv_park_transform * state.foc.voltage_qd;
+
+        if (state.foc_use_qd_decoupling) {
+            const std::complex<Scalar> existing_back_emf_ab =
+                clarke_transform(rotor.normed_bEmfs) * rotor.rotor_angular_vel;
+            voltage_ab += existing_back_emf_ab;
+        }
+
+        state.foc.modulation_index =
+            get_modulation_index(state.board.bus_voltage, voltage_ab);
+        state.board.pwm.duties = get_pwm_duties(
+            state.board.bus_voltage, voltage_ab, state.foc_pwm_strategy,
+            state.foc_overmodulation_mode);
+    }
+}
+
+BiroControllerInputs get_controller_inputs(const SimState& state) {
+    BiroControllerInputs inputs = {};
+    inputs.time = state.time;
+    for (int i = 0; i < 3; ++i) {
+        inputs.phase_currents[i] = state.motor.electrical.phase_currents(i);
+    }
+    inputs.rotor_angle = state.motor.kinematic.rotor_angle;
+    inputs.rotor_angular_vel = state.motor.kinematic.rotor_angular_vel;
+    inputs.bus_voltage = state.board.bus_voltage;
+    inputs.desired_torque = state.foc_desired_torque;
+    return inputs;
+}
+
+// new_outputs is set on the steps the controller ran, duties only
+// take effect then. returns the gate command
+GateMask apply_controller_outputs(const BiroControllerOutputs& outputs,
+                                  const bool new_outputs,
+                                  SimState* state_ptr) {
+    SimState& state = *state_ptr; // convenience ref
+    if (outputs.mode == BIRO_CONTROLLER_OUTPUT_GATES) {
+        return outputs.gates & kAllPhasesMask<3>;
+    }
+    if (new_outputs) {
+        for (int i = 0; i < 3; ++i) {
+            state.board.pwm.duties[i] = outputs.duties[i];
+        }
+    }
+    return get_pwm_gate_command(state.board.pwm);
+}
+
+// steps the plugin at its own rate, returns the gate command
+GateMask step_controller_plugin(SimState* state_ptr) {
+    SimState& state = *state_ptr; // convenience ref
+    ControllerPlugin& plugin = state.controller_plugin;
+    if (!is_controller_plugin_loaded(plugin)) {
+        return 0;
+    }
+
+    const bool update = periodic_timer(plugin.period, state.dt, &plugin.timer);
+    if (update) {
+        const BiroControllerInputs inputs = get_controller_inputs(state);
+        plugin.api->step(plugin.controller, &inputs, &plugin.outputs);
+    }
+    return apply_controller_outputs(plugin.outputs, update, &state);
+}
+
+// exchanges with the external controller at its rate, blocking until it
+// answers. returns the gate command
+GateMask step_cosim_controller(SimState* state_ptr) {
+    SimState& state = *state_ptr; // convenience ref
+    if (!is_lockstep_channel_open(state.cosim)) {
+        return 0;
+    }
+
+    // once a timeout paused the sim, later steps must not wait on the
+    // controller again. resuming retries it
+    const bool update =
+        periodic_timer(state.cosim_period, state.dt, &state.cosim_timer) &&
+        !state.paused;
+    if (update) {
+        state.cosim_timed_out = !exchange_lockstep(
+            get_controller_inputs(state), state.cosim_timeout, &state.cosim,
+            &state.cosim_outputs);
+        if (state.cosim_timed_out) {
+            // hold the last outputs until the controller is back
+            state.paused = true;
+        }
+    }
+    return apply_controller_outputs(state.cosim_outputs,
+                                    update && !state.cosim_timed_out, &state);
+}
+
+void update_rotor_frame(const MotorState& motor, SimOutputs* outputs) {
+    outputs->rotor_frame_stale = false;
+    outputs->electrical_angle = get_electrical_angle(
+        motor.params.num_pole_pairs, motor.kinematic.rotor_angle);
+    outputs->park_transform =
+        get_rotation(-(outputs->electrical_angle + kQAxisOffset));
+    outputs->current_qd =
+        abc_to_qd(motor.electrical.phase_currents, outputs->park_transform);
+}
+
+void update_drive_outputs(const BoardState& board, const MotorState& motor,
+                          const Eigen::Matrix<Scalar, 3, 1>& pole_voltages,
+                          SimOutputs* outputs) {
+    outputs->pole_voltages = pole_voltages;
+    outputs->phase_voltages =
+        get_phase_voltages(outputs->pole_voltages, motor.electrical.bEmfs);
+
+    // power is v*i for all i's that are flowing into the gates
+    outputs->power_draw = 0;
+    for (int i = 0; i < 3; ++i) {
+        const int high = (board.gate.high >> i) & 1;
+        outputs->power_draw +=
+            high * board.bus_voltage * motor.electrical.phase_currents(i);
+    }
+}
+
+} // namespace
+
+void step_simulation(SimState* state_ptr, TelemetrySample* sample) {
+    SimState& state = *state_ptr; // convenience ref
+    SimOutputs& outputs = state.outputs;
+
+    const bool new_pwm_cycle = step_pwm_state(state.dt, &state.board.pwm);
+
+    // the previous step left the rotor frame of the current state, shared by
+    // every controller
+    if (outputs.rotor_frame_stale) {
+        update_rotor_frame(state.motor, &outputs);
+    }
+
+    GateMask gate_command = 0;
+
+    // update relevant commutation modes
+    if (state.commutation_mode == kCommutationModeManual) {
+        // maintain the existing the gate command
+        // which has probably been set from the GUI
+        gate_command = state.board.gate.commanded;
+    }
+
+    if (state.commutation_mode == kCommutationModeSixStep) {
+        gate_command = to_gate_mask(six_step_commutate(
+            outputs.electrical_angle, state.six_step_phase_advance));
+    }
+
+    if (state.commutation_mode == kCommutationModeFOC) {
+        step_foc(new_pwm_cycle, &state);
+        gate_command = get_pwm_gate_command(state.board.pwm);
+    }
+
+    if (state.commutation_mode == kCommutationModePlugin) {
+        gate_command = step_controller_plugin(&state);
+    }
+
+    if (state.commutation_mode == kCommutationModeCoSim) {
+        gate_command = step_cosim_controller(&state);
+    }
+
+    state.board.gate.commanded = gate_command;
+    update_gate_state(&state.board.gate);
+
+    const Eigen::Matrix<Scalar, 3, 1> pole_voltages = get_pole_voltages(
+        state.board.bus_voltage, state.motor.electrical.phase_currents,
+        state.motor.electrical.bEmfs, state.board.gate);
+    Eigen::Matrix<Scalar, 3, 1> min_phase_currents;
+    Eigen::Matrix<Scalar, 3, 1> max_phase_currents;
+    get_phase_current_bounds(state.board.bus_voltage, pole_voltages,
+                             state.motor.electrical.phase_currents,
+                             state.board.gate, &min_phase_currents,
+                             &max_phase_currents);
+    update_drive_outputs(state.board, state.motor, pole_voltages, &outputs);
+
+    step_motor(state.dt, state.load_torque, pole_voltages, min_phase_currents,
+               max_phase_currents, &state.motor);
+
+    state.time += state.dt;
+
+    // telemetry and the gui see the rotor at the end of the step, which is
+    // also where the next step starts
+    update_rotor_frame(state.motor, &outputs);
+
+    get_telemetry_sample(state.time, state.board, state.motor, state.foc,
+                         outputs, sample);
+    update_telemetry_stats(*sample, &state.telemetry_stats);
+    step_trigger_capture(*sample, &state.scope);
+    if (is_telemetry_feed_open(state.telemetry_feed)) {
+        publish_telemetry_sample(sample->data(), &state.telemetry_feed);
+    }
+    if (is_telemetry_server_running(state.telemetry_server)) {
+        publish_telemetry_stream_sample(sample->data(),
+                                        &state.telemetry_server);
+    }
+}
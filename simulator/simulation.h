@@ -0,0 +1,9 @@
+#pragma once
+
+#include "sim_state.h"
+#include "telemetry.h"
+
+// Advances the board, controllers and motor by state->dt, updating
+// state->outputs, the telemetry statistics and the scope.
+// The telemetry of the step is written to sample.
+void step_simulation(SimState* state, TelemetrySample* sample);
@@ -0,0 +1,39 @@
+#include "simulator/simulation.h"
+#include <chrono>
+#include <gtest/gtest.h>
+#include <string>
+#include <unistd.h>
+
+TEST(step_simulation, cosim_timeout_pauses_once) {
+    SimState state;
+    init_sim_state(&state);
+    state.commutation_mode = kCommutationModeCoSim;
+    state.cosim_period = state.dt; // an exchange every step
+    state.cosim_timeout = 0.01;
+
+    // no controller ever attaches
+    const std::string name =
+        "/biro_simulation_test_" + std::to_string(getpid());
+    std::string error;
+    ASSERT_TRUE(create_lockstep_channel(
+        name,
+        get_controller_plugin_config(state.cosim_period, state.motor.params),
+        &state.cosim, &error))
+        << error;
+
+    // a frame's worth of steps, as the simulator runs them
+    const auto start = std::chrono::steady_clock::now();
+    TelemetrySample sample;
+    for (int i = 0; i < 1000; ++i) {
+        step_simulation(&state, &sample);
+    }
+    const double elapsed = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    EXPECT_TRUE(state.paused);
+    EXPECT_TRUE(state.cosim_timed_out);
+    // waited once, not once per step
+    EXPECT_LT(elapsed, 100 * state.cosim_timeout);
+
+    close_lockstep_channel(&state.cosim);
+}
@@ -1,29 +1,34 @@
 #include "config/scalar.h"
-#include "controls/foc.h"
-#include "controls/pi_control.h"
-#include "controls/six_step.h"
-#include "controls/space_vector_modulation.h"
 #include "gui.h"
+#include "ipc/lockstep_channel.h"
+#include "ipc/telemetry_feed.h"
+#include "ipc/telemetry_stream.h"
 #include "motor.h"
-#include "util/clarke_transform.h"
+#include "sim_history.h"
+#include "simulation.h"
+#include "telemetry.h"
 #include "util/conversions.h"
 #include "util/math_constants.h"
-#include "util/rotation.h"
-#include "util/time.h"
 #include "wrappers/sdl_context.h"
 #include "wrappers/sdl_imgui.h"
 #include "wrappers/sdl_imgui_context.h"
 #include <Eigen/Dense>
 #include <absl/strings/str_format.h>
-#include <array>
+#include <gflags/gflags.h>
 #include <glad/glad.h>
 #include <implot.h>
 #include <iostream>
 
 using namespace biro;
 
+DEFINE_uint64(seed, /*default=*/0,
+              "seeds all randomness, runs with equal seeds are identical");
+
 int main(int argc, char* argv[]) {
+    gflags::ParseCommandLineFlags(&argc, &argv, /*remove_flags*/ true);
+
     SimState state;
+    state.seed = FLAGS_seed;
     init_sim_state(&state);
     state.foc.i_controller_params = make_motor_pi_params(
         /*bandwidth=*/10000,
@@ -35,6 +40,8 @@ int main(int argc, char* argv[]) {
 
     VizOptions viz_options;
 
+    SimHistory history;
+
     wrappers::SdlContext sdl_context("Biro Motor Simulator",
                                      /*width=*/1920 / 2,
                                      /*height=*/1080 / 2);
@@ -60,118 +67,39 @@ int main(int argc, char* argv[]) {
 
         wrappers::sdl_imgui_newframe(sdl_context.window_);
 
+        resize_rolling_buffers(viz_options.num_rolling_pts,
+                               &viz_data.rolling_buffers);
+        if (!state.paused) {
+            rewind_rolling_buffers(state.time, &viz_data.rolling_buffers);
+        }
+        if (!state.paused && !viz_options.record_every_step) {
+            update_rolling_buffers(state, &viz_data.rolling_buffers);
+        }
         if (!state.paused) {
-            update_rolling_buffers(state.time, state.board, state.motor,
-                                   state.foc, &viz_data.rolling_buffers);
+            update_harmonic_spectra(state.motor, &viz_data);
         }
-        run_gui(viz_data, &viz_options, &state);
+        run_gui(viz_data, &viz_options, &history, &state);
 
         if (!state.paused) {
+            // after the gui, so the snapshot has the settings the steps use
+            record_sim_snapshot(state, &history);
             for (int i = 0; i < state.step_multiplier; ++i) {
-                const bool new_pwm_cycle =
-                    step_pwm_state(state.dt, &state.board.pwm);
-
-                std::array<bool, 3> gate_command = {};
-
-                // update relevant commutation modes
-                if (state.commutation_mode == kCommutationModeManual) {
-                    // maintain the existing the gate command
-                    // which has probably been set from the GUI
-                    gate_command = state.board.gate.commanded;
+                TelemetrySample sample;
+                step_simulation(&state, &sample);
+                if (viz_options.record_every_step) {
+                    push_rolling_buffers(sample, &viz_data.rolling_buffers);
                 }
-
-                if (state.commutation_mode == kCommutationModeSixStep) {
-                    gate_command = six_step_commutate(
-                        get_electrical_angle(state.motor.params.num_pole_pairs,
-                                             state.motor.kinematic.rotor_angle),
-                        state.six_step_phase_advance);
-                }
-
-                if (state.commutation_mode == kCommutationModeFOC) {
-                    if (periodic_timer(state.foc.period, state.dt,
-                                       &state.foc.timer)) {
-                        Scalar desired_torque = state.foc_desired_torque;
-                        if (state.foc_use_cogging_compensation) {
-                            desired_torque -= interp_cogging_torque(
-                                state.motor.kinematic.rotor_angle,
-                                state.motor.params.cogging_torque_map);
-                        }
-
-                        std::complex<Scalar> desired_current_qd;
-                        if (state.foc_non_sinusoidal_drive_mode) {
-                            desired_current_qd =
-                                get_desired_current_qd_non_sinusoidal(
-                                    desired_torque, state.motor);
-                        } else {
-                            desired_current_qd = get_desired_current_qd(
-                                desired_torque,
-                                state.motor.params.normed_bEmf_coeffs(0));
-                        }
-
-                        step_foc_current_controller(desired_current_qd,
-                                                    state.motor, &state.foc);
-
-                        // anti-windup
-                        if (state.foc_pi_anti_windup) {
-                            const Scalar voltage_qd_norm =
-                                std::abs(state.foc.voltage_qd);
-                            if (voltage_qd_norm >
-                                state.board.bus_voltage * kClarkeScale) {
-                                const std::complex<Scalar>
-                                    voltage_qd_saturation =
-                                        state.foc.voltage_qd *
-                                        (state.board.bus_voltage *
-                                         kClarkeScale / voltage_qd_norm);
-                                // unwind integral terms
-                                pi_unwind(state.foc.i_controller_params,
-                                          voltage_qd_saturation.real(),
-                                          &state.foc.iq_controller);
-                                pi_unwind(state.foc.i_controller_params,
-                                          voltage_qd_saturation.imag(),
-                                          &state.foc.id_controller);
-                            }
-                        }
-                    }
-
-                    // assert the requested qd voltage with PWM
-                    if (new_pwm_cycle) {
-                        const std::complex<Scalar> inv_park_transform =
-                            get_rotation(get_q_axis_electrical_angle(
-                                state.motor.params.num_pole_pairs,
-                                state.motor.kinematic.rotor_angle));
-
-                        std::complex<Scalar> voltage_ab =
-                            inv_park_transform * state.foc.voltage_qd;
-
-                        if (state.foc_use_qd_decoupling) {
-                            const std::complex<Scalar> existing_back_emf_ab =
-                                clarke_transform(
-                                    state.motor.electrical.normed_bEmfs) *
-                                state.motor.kinematic.rotor_angular_vel;
-                            voltage_ab += existing_back_emf_ab;
-                        }
-
-                        state.board.pwm.duties =
-                            get_pwm_duties(state.board.bus_voltage, voltage_ab);
-                    }
-
-                    gate_command = get_pwm_gate_command(state.board.pwm);
+                // a co-sim controller timed out
+                if (state.paused) {
+                    break;
                 }
-
-                state.board.gate.commanded = gate_command;
-                update_gate_state(state.dt, &state.board.gate);
-
-                const auto pole_voltages = get_pole_voltages(
-                    state.board.bus_voltage,
-                    state.motor.electrical.phase_currents, state.board.gate);
-
-                step_motor(state.dt, state.load_torque, pole_voltages,
-                           &state.motor);
-
-                state.time += state.dt;
             }
+            extend_sim_history(state, &history);
         }
 
+        // accepts clients and sends what the steps batched up
+        poll_telemetry_server(&state.telemetry_server);
+
         ImGui::Render();
         int display_w, display_h;
         SDL_GetWindowSize(sdl_context.window_, &display_w, &display_h);
@@ -183,5 +111,9 @@ int main(int argc, char* argv[]) {
         SDL_GL_SwapWindow(sdl_context.window_);
     }
 
+    // so the shared memory names do not outlive us
+    close_lockstep_channel(&state.cosim);
+    close_telemetry_feed(&state.telemetry_feed);
+    stop_telemetry_server(&state.telemetry_server);
     return 0;
 }
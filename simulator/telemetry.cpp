@@ -0,0 +1,89 @@
+#include "telemetry.h"
+#include "util/math_constants.h"
+
+const std::array<const char*, kNumTelemetrySignals> kTelemetrySignalNames = {
+    "time",
+    "electrical_angle",
+    "phase_voltage_a",
+    "phase_voltage_b",
+    "phase_voltage_c",
+    "current_a",
+    "current_b",
+    "current_c",
+    "bEmf_a",
+    "bEmf_b",
+    "bEmf_c",
+    "normed_bEmf_a",
+    "normed_bEmf_b",
+    "normed_bEmf_c",
+    "torque",
+    "rotor_angular_vel",
+    "pwm_level",
+    "pwm_duty_a",
+    "pwm_duty_b",
+    "pwm_duty_c",
+    "gate_state_a",
+    "gate_state_b",
+    "gate_state_c",
+    "current_q",
+    "current_d",
+    "current_q_err",
+    "current_q_integral",
+    "current_d_err",
+    "current_d_integral",
+    "power_draw",
+};
+
+void get_telemetry_sample(const Scalar time, const BoardState& board,
+                          const MotorState& motor, const FocState& foc,
+                          const SimOutputs& outputs,
+                          TelemetrySample* sample_ptr) {
+    TelemetrySample& sample = *sample_ptr; // convenience ref
+
+    sample[kTelemetryTime] = time;
+    sample[kTelemetryElectricalAngle] = outputs.electrical_angle;
+
+    for (int i = 0; i < 3; ++i) {
+        sample[kTelemetryPhaseVoltageA + i] = outputs.phase_voltages(i);
+        sample[kTelemetryPhaseCurrentA + i] =
+            motor.electrical.phase_currents(i);
+        sample[kTelemetryBEmfA + i] = motor.electrical.bEmfs(i);
+        sample[kTelemetryNormedBEmfA + i] = motor.electrical.normed_bEmfs(i);
+        sample[kTelemetryPwmDutyA + i] = board.pwm.duties[i];
+
+        Scalar gate_state = get_gate(board.gate, i);
+        if (gate_state == OFF) {
+            // map the indeterminate state to -0.5
+            gate_state = -0.5;
+        }
+        sample[kTelemetryGateStateA + i] = gate_state;
+    }
+
+    sample[kTelemetryTorque] = motor.kinematic.torque;
+    sample[kTelemetryRotorAngularVel] = motor.kinematic.rotor_angular_vel;
+    sample[kTelemetryPwmLevel] = board.pwm.level;
+
+    sample[kTelemetryCurrentQ] = outputs.current_qd.real();
+    sample[kTelemetryCurrentD] = outputs.current_qd.imag();
+
+    sample[kTelemetryCurrentQErr] = foc.iq_controller.err;
+    sample[kTelemetryCurrentQIntegral] = foc.iq_controller.integral;
+    sample[kTelemetryCurrentDErr] = foc.id_controller.err;
+    sample[kTelemetryCurrentDIntegral] = foc.id_controller.integral;
+
+    sample[kTelemetryPowerDraw] = outputs.power_draw;
+}
+
+void update_telemetry_stats(const TelemetrySample& sample,
+                            TelemetryStats* stats) {
+    // a new electrical cycle starts whenever the angle wraps around,
+    // in either direction
+    const Scalar electrical_angle = sample[kTelemetryElectricalAngle];
+    const bool new_cycle =
+        std::abs(electrical_angle - stats->last_electrical_angle) > kPI;
+    stats->last_electrical_angle = electrical_angle;
+
+    for (int i = 0; i < kNumTelemetrySignals; ++i) {
+        update_cycle_stats(sample[i], new_cycle, &stats->signals[i]);
+    }
+}
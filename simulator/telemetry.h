@@ -0,0 +1,68 @@
+#pragma once
+
+#include "analysis/online_stats.h"
+#include "board/board_state.h"
+#include "config/scalar.h"
+#include "controls/foc_state.h"
+#include "motor_state.h"
+#include "sim_outputs.h"
+#include <array>
+
+// Every signal the simulator reports, one column per signal
+enum TelemetrySignal {
+    kTelemetryTime = 0,
+    kTelemetryElectricalAngle,
+    kTelemetryPhaseVoltageA,
+    kTelemetryPhaseVoltageB,
+    kTelemetryPhaseVoltageC,
+    kTelemetryPhaseCurrentA,
+    kTelemetryPhaseCurrentB,
+    kTelemetryPhaseCurrentC,
+    kTelemetryBEmfA,
+    kTelemetryBEmfB,
+    kTelemetryBEmfC,
+    kTelemetryNormedBEmfA,
+    kTelemetryNormedBEmfB,
+    kTelemetryNormedBEmfC,
+    kTelemetryTorque,
+    kTelemetryRotorAngularVel,
+    kTelemetryPwmLevel,
+    kTelemetryPwmDutyA,
+    kTelemetryPwmDutyB,
+    kTelemetryPwmDutyC,
+    kTelemetryGateStateA,
+    kTelemetryGateStateB,
+    kTelemetryGateStateC,
+    kTelemetryCurrentQ,
+    kTelemetryCurrentD,
+    kTelemetryCurrentQErr,
+    kTelemetryCurrentQIntegral,
+    kTelemetryCurrentDErr,
+    kTelemetryCurrentDIntegral,
+    kTelemetryPowerDraw, // power drawn from v_bus
+    kNumTelemetrySignals
+};
+
+extern const std::array<const char*, kNumTelemetrySignals>
+    kTelemetrySignalNames;
+
+// one row of telemetry, indexed by TelemetrySignal
+using TelemetrySample = std::array<Scalar, kNumTelemetrySignals>;
+
+// gathers the state and the derived outputs of a step,
+// nothing is recomputed here
+void get_telemetry_sample(const Scalar time, const BoardState& board,
+                          const MotorState& motor, const FocState& foc,
+                          const SimOutputs& outputs, TelemetrySample* sample);
+
+// per signal statistics since the last reset,
+// and windowed over the last electrical cycle
+struct TelemetryStats {
+    std::array<CycleStats, kNumTelemetrySignals> signals;
+    Scalar last_electrical_angle = 0;
+};
+
+void update_telemetry_stats(const TelemetrySample& sample,
+                            TelemetryStats* stats);
+
+inline void reset_telemetry_stats(TelemetryStats* stats) { *stats = {}; }
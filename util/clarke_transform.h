@@ -1,25 +1,203 @@
 #pragma once
 
+#include "util/constexpr_math.h"
 #include "util/conversions.h"
+#include "util/fast_sincos.h"
+#include "util/math_constants.h"
 #include <Eigen/Dense>
+#include <array>
+#include <cmath>
 #include <complex>
 
-// these are the power invariant Clarke transforms
-extern const Eigen::Matrix<double, 3, 3> kClarkeTransform3x3;
-extern const Eigen::Matrix<double, 2, 3> kClarkeTransform2x3;
+// magnitude scaling factor going from regular voltages to space vector
+constexpr double kClarkeScale = constexpr_sqrt(2.0 / 3);
 
-extern const double kClarkeScale; // magnitude scaling factor going from regular
-                                  // voltages to space vector
+constexpr float kClarkeScalef = kClarkeScale; // float version of the above
 
-extern const float kClarkeScalef; // float version of the above
+namespace clarke_internal {
+constexpr double kSqrt2 = constexpr_sqrt(2.0);
+constexpr double kSqrt3 = constexpr_sqrt(3.0);
+} // namespace clarke_internal
+
+// the power invariant Clarke transform, row major
+constexpr std::array<std::array<double, 3>, 3> kClarkeTransform = {{
+    // clang-format off
+    {kClarkeScale, -kClarkeScale / 2, -kClarkeScale / 2},
+    {0, clarke_internal::kSqrt2 / 2, -clarke_internal::kSqrt2 / 2},
+    {1 / clarke_internal::kSqrt3, 1 / clarke_internal::kSqrt3,
+     1 / clarke_internal::kSqrt3},
+    // clang-format on
+}};
+
+// Eigen copies of the table above. These are built at the call site so
+// the coefficients fold into the surrounding code.
+template <typename TScalar = double>
+inline Eigen::Matrix<TScalar, 3, 3> get_clarke_transform_3x3() {
+    Eigen::Matrix<TScalar, 3, 3> result;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            result(i, j) = static_cast<TScalar>(kClarkeTransform[i][j]);
+        }
+    }
+    return result;
+}
+
+template <typename TScalar = double>
+inline Eigen::Matrix<TScalar, 2, 3> get_clarke_transform_2x3() {
+    return get_clarke_transform_3x3<TScalar>().template topRows<2>();
+}
+
+namespace clarke_internal {
+// entries of kClarkeTransform, spelled out for the kernels below
+constexpr double kAlphaGain = kClarkeTransform[0][0];
+constexpr double kBetaGain = kClarkeTransform[1][1];
+} // namespace clarke_internal
+
+template <typename TScalar>
+inline std::complex<TScalar> clarke_transform(const TScalar a, const TScalar b,
+                                              const TScalar c) {
+    constexpr TScalar kAlphaGain = clarke_internal::kAlphaGain;
+    constexpr TScalar kBetaGain = clarke_internal::kBetaGain;
+    return {kAlphaGain * (a - TScalar(0.5) * (b + c)), kBetaGain * (b - c)};
+}
 
 inline std::complex<double>
 clarke_transform(const Eigen::Matrix<double, 3, 1>& state) {
-    return to_complex<double>((kClarkeTransform2x3 * state).head<2>());
+    return clarke_transform(state(0), state(1), state(2));
 }
 
 inline std::complex<float>
 clarke_transform(const Eigen::Matrix<float, 3, 1>& state) {
-    return to_complex<float>(
-        (kClarkeTransform2x3.cast<float>() * state).head<2>());
+    return clarke_transform(state(0), state(1), state(2));
+}
+
+namespace clarke_internal {
+template <int kNumPhases, bool kSine>
+constexpr std::array<double, kNumPhases> make_phase_offsets() {
+    std::array<double, kNumPhases> offsets = {};
+    for (int k = 0; k < kNumPhases; ++k) {
+        const double angle = 2 * kPI * k / kNumPhases;
+        offsets[k] = kSine ? constexpr_sin(angle) : constexpr_cos(angle);
+    }
+    return offsets;
+}
+
+// rotation * ab, expanded to skip the inf/nan handling of std::complex
+// multiplication
+template <typename TScalar>
+inline std::complex<TScalar> rotate(const std::complex<TScalar>& ab,
+                                    const std::complex<TScalar>& rotation) {
+    const TScalar re = rotation.real();
+    const TScalar im = rotation.imag();
+    return {re * ab.real() - im * ab.imag(), im * ab.real() + re * ab.imag()};
+}
+} // namespace clarke_internal
+
+// cos and sin of 2 pi k / kNumPhases, the electrical offset of phase k in a
+// symmetric machine
+template <int kNumPhases>
+constexpr std::array<double, kNumPhases> kPhaseOffsetCos =
+    clarke_internal::make_phase_offsets<kNumPhases, false>();
+template <int kNumPhases>
+constexpr std::array<double, kNumPhases> kPhaseOffsetSin =
+    clarke_internal::make_phase_offsets<kNumPhases, true>();
+
+// Power invariant Clarke transform of a symmetric machine with any number
+// of phases, keeping the fundamental plane. Overload resolution prefers the
+// hand written 3 phase versions above.
+template <typename TScalar, int kNumPhases>
+inline std::complex<TScalar>
+clarke_transform(const Eigen::Matrix<TScalar, kNumPhases, 1>& state) {
+    constexpr TScalar kScale = constexpr_sqrt(2.0 / kNumPhases);
+    TScalar alpha = 0;
+    TScalar beta = 0;
+    for (int k = 0; k < kNumPhases; ++k) {
+        alpha += TScalar(kPhaseOffsetCos<kNumPhases>[k]) * state(k);
+        beta += TScalar(kPhaseOffsetSin<kNumPhases>[k]) * state(k);
+    }
+    return {kScale * alpha, kScale * beta};
+}
+
+// Inverse of the above, with no zero sequence or higher plane components
+template <int kNumPhases, typename TScalar>
+inline Eigen::Matrix<TScalar, kNumPhases, 1>
+inverse_clarke_transform(const std::complex<TScalar>& ab) {
+    constexpr TScalar kScale = constexpr_sqrt(2.0 / kNumPhases);
+    Eigen::Matrix<TScalar, kNumPhases, 1> result;
+    for (int k = 0; k < kNumPhases; ++k) {
+        result(k) =
+            kScale * (TScalar(kPhaseOffsetCos<kNumPhases>[k]) * ab.real() +
+                      TScalar(kPhaseOffsetSin<kNumPhases>[k]) * ab.imag());
+    }
+    return result;
+}
+
+// Fused Clarke + Park transforms. park_transform is
+// get_rotation(-q_axis_electrical_angle), so that a caller working at a
+// fixed angle pays for the sin/cos once.
+template <typename TScalar>
+inline std::complex<TScalar>
+abc_to_qd(const TScalar a, const TScalar b, const TScalar c,
+          const std::complex<TScalar>& park_transform) {
+    return clarke_internal::rotate(clarke_transform(a, b, c), park_transform);
+}
+
+template <typename TScalar, int kNumPhases>
+inline std::complex<TScalar>
+abc_to_qd(const Eigen::Matrix<TScalar, kNumPhases, 1>& phases,
+          const std::complex<TScalar>& park_transform) {
+    return clarke_internal::rotate(clarke_transform(phases), park_transform);
+}
+
+// Inverse of abc_to_qd, the result has no zero sequence component
+template <int kNumPhases = 3, typename TScalar>
+inline Eigen::Matrix<TScalar, kNumPhases, 1>
+qd_to_abc(const std::complex<TScalar>& qd,
+          const std::complex<TScalar>& park_transform) {
+    // rotate by the conjugate of park_transform
+    const std::complex<TScalar> ab = clarke_internal::rotate(
+        qd, std::complex<TScalar>{park_transform.real(),
+                                  -park_transform.imag()});
+    if constexpr (kNumPhases == 3) {
+        constexpr TScalar kAlphaGain = clarke_internal::kAlphaGain;
+        constexpr TScalar kBetaGain = clarke_internal::kBetaGain;
+        const TScalar half_alpha = TScalar(0.5) * kAlphaGain * ab.real();
+        return {kAlphaGain * ab.real(), -half_alpha + kBetaGain * ab.imag(),
+                -half_alpha - kBetaGain * ab.imag()};
+    } else {
+        return inverse_clarke_transform<kNumPhases>(ab);
+    }
+}
+
+// Batched versions over recorded traces, one sample per index.
+// q_axis_angles are the q axis electrical angles of each sample.
+template <typename TScalar>
+void abc_to_qd(const TScalar* as, const TScalar* bs, const TScalar* cs,
+               const TScalar* q_axis_angles, const int count, TScalar* qs,
+               TScalar* ds) {
+    for (int i = 0; i < count; ++i) {
+        TScalar sin_angle, cos_angle;
+        fast_sincos(q_axis_angles[i], &sin_angle, &cos_angle);
+        const std::complex<TScalar> park_transform = {cos_angle, -sin_angle};
+        const std::complex<TScalar> qd =
+            abc_to_qd(as[i], bs[i], cs[i], park_transform);
+        qs[i] = qd.real();
+        ds[i] = qd.imag();
+    }
+}
+
+template <typename TScalar>
+void qd_to_abc(const TScalar* qs, const TScalar* ds,
+               const TScalar* q_axis_angles, const int count, TScalar* as,
+               TScalar* bs, TScalar* cs) {
+    for (int i = 0; i < count; ++i) {
+        TScalar sin_angle, cos_angle;
+        fast_sincos(q_axis_angles[i], &sin_angle, &cos_angle);
+        const std::complex<TScalar> park_transform = {cos_angle, -sin_angle};
+        const Eigen::Matrix<TScalar, 3, 1> abc =
+            qd_to_abc(std::complex<TScalar>{qs[i], ds[i]}, park_transform);
+        as[i] = abc(0);
+        bs[i] = abc(1);
+        cs[i] = abc(2);
+    }
 }
@@ -0,0 +1,84 @@
+#include "clarke_transform.h"
+#include "rotation.h"
+#include <Eigen/Dense>
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <vector>
+
+using Scalar = double;
+constexpr Scalar angle = 1.2345;
+constexpr int kNumSamples = 4096;
+
+static void BM_Abc_To_Qd_Composed(benchmark::State& state) {
+    Eigen::Matrix<Scalar, 3, 1> abc = {1.5, -0.25, -1.25};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(abc);
+        const std::complex<Scalar> qd =
+            get_rotation(-angle) * clarke_transform(abc);
+        benchmark::DoNotOptimize(qd);
+    }
+}
+BENCHMARK(BM_Abc_To_Qd_Composed);
+
+static void BM_Abc_To_Qd_Fused(benchmark::State& state) {
+    Eigen::Matrix<Scalar, 3, 1> abc = {1.5, -0.25, -1.25};
+    const std::complex<Scalar> park_transform = get_rotation(-angle);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(abc);
+        const std::complex<Scalar> qd = abc_to_qd(abc, park_transform);
+        benchmark::DoNotOptimize(qd);
+    }
+}
+BENCHMARK(BM_Abc_To_Qd_Fused);
+
+struct Trace {
+    std::vector<Scalar> as, bs, cs, angles, qs, ds;
+};
+
+static Trace make_trace() {
+    Trace trace;
+    for (int i = 0; i < kNumSamples; ++i) {
+        const Scalar theta = 0.01 * i;
+        trace.as.push_back(std::cos(theta));
+        trace.bs.push_back(std::cos(theta - 2.0944));
+        trace.cs.push_back(std::cos(theta + 2.0944));
+        trace.angles.push_back(theta);
+    }
+    trace.qs.resize(kNumSamples);
+    trace.ds.resize(kNumSamples);
+    return trace;
+}
+
+static void BM_Abc_To_Qd_Trace_Composed(benchmark::State& state) {
+    Trace trace = make_trace();
+    for (auto _ : state) {
+        for (int i = 0; i < kNumSamples; ++i) {
+            const Eigen::Matrix<Scalar, 3, 1> abc = {trace.as[i], trace.bs[i],
+                                                     trace.cs[i]};
+            const std::complex<Scalar> qd =
+                get_rotation(-trace.angles[i]) * clarke_transform(abc);
+            trace.qs[i] = qd.real();
+            trace.ds[i] = qd.imag();
+        }
+        benchmark::DoNotOptimize(trace.qs.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kNumSamples);
+}
+BENCHMARK(BM_Abc_To_Qd_Trace_Composed);
+
+static void BM_Abc_To_Qd_Trace_Batched(benchmark::State& state) {
+    Trace trace = make_trace();
+    for (auto _ : state) {
+        abc_to_qd(trace.as.data(), trace.bs.data(), trace.cs.data(),
+                  trace.angles.data(), kNumSamples, trace.qs.data(),
+                  trace.ds.data());
+        benchmark::DoNotOptimize(trace.qs.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kNumSamples);
+}
+BENCHMARK(BM_Abc_To_Qd_Trace_Batched);
+
+// Run the benchmark
+BENCHMARK_MAIN();
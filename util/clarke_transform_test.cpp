@@ -1,20 +1,109 @@
 #include "clarke_transform.h"
 #include "config/scalar.h"
+#include "rotation.h"
+#include <array>
 #include <Eigen/Dense>
 #include <gtest/gtest.h>
 
-TEST(kClarkeTransform2x3, zero_series_invariant) {
+static_assert(kClarkeScale > 0.8164965 && kClarkeScale < 0.8164966,
+              "kClarkeScale is sqrt(2/3)");
+
+TEST(get_clarke_transform_2x3, zero_series_invariant) {
     const Eigen::Matrix<Scalar, 3, 1> ones =
         Eigen::Matrix<Scalar, 3, 1>::Ones();
-    const Eigen::Matrix<Scalar, 2, 1> result = kClarkeTransform2x3 * ones;
+    const Eigen::Matrix<Scalar, 2, 1> result =
+        get_clarke_transform_2x3() * ones;
 
     EXPECT_LT(result.norm(), 1e-7);
 }
 
-TEST(kClarkeTransform3x3, unitary) {
+TEST(get_clarke_transform_3x3, unitary) {
     const Eigen::Matrix<Scalar, 3, 3> delta =
-        kClarkeTransform3x3 * kClarkeTransform3x3.transpose() -
+        get_clarke_transform_3x3() * get_clarke_transform_3x3().transpose() -
         Eigen::Matrix<Scalar, 3, 3>::Identity();
 
     EXPECT_LT(delta.norm(), 1e-7);
 }
+
+TEST(clarke_transform, matches_matrix) {
+    const Eigen::Matrix<Scalar, 3, 1> abc = {1.5, -0.25, 0.75};
+    const std::complex<Scalar> expected =
+        to_complex<Scalar>(get_clarke_transform_2x3() * abc);
+    const std::complex<Scalar> ab = clarke_transform(abc);
+
+    EXPECT_NEAR(ab.real(), expected.real(), 1e-12);
+    EXPECT_NEAR(ab.imag(), expected.imag(), 1e-12);
+}
+
+TEST(abc_to_qd, matches_clarke_then_park) {
+    const Eigen::Matrix<Scalar, 3, 1> abc = {1.5, -0.25, 0.75};
+    for (Scalar angle = -4; angle < 4; angle += 0.37) {
+        const std::complex<Scalar> park_transform = get_rotation(-angle);
+        const std::complex<Scalar> expected =
+            park_transform *
+            to_complex<Scalar>(get_clarke_transform_2x3() * abc);
+        const std::complex<Scalar> qd = abc_to_qd(abc, park_transform);
+
+        EXPECT_NEAR(qd.real(), expected.real(), 1e-12);
+        EXPECT_NEAR(qd.imag(), expected.imag(), 1e-12);
+    }
+}
+
+TEST(qd_to_abc, inverts_abc_to_qd) {
+    // no zero sequence component, so the round trip is exact
+    const Eigen::Matrix<Scalar, 3, 1> abc = {1.5, -0.25, -1.25};
+    const std::complex<Scalar> park_transform = get_rotation(-0.8);
+    const Eigen::Matrix<Scalar, 3, 1> result =
+        qd_to_abc(abc_to_qd(abc, park_transform), park_transform);
+
+    EXPECT_LT((result - abc).norm(), 1e-12);
+}
+
+TEST(abc_to_qd, batch_matches_single) {
+    constexpr int kCount = 17;
+    std::array<Scalar, kCount> as, bs, cs, angles, qs, ds, as2, bs2, cs2;
+    for (int i = 0; i < kCount; ++i) {
+        as[i] = std::sin(0.3 * i);
+        bs[i] = std::cos(0.7 * i);
+        cs[i] = -as[i] - bs[i];
+        angles[i] = 0.45 * i - 3;
+    }
+    abc_to_qd(as.data(), bs.data(), cs.data(), angles.data(), kCount,
+              qs.data(), ds.data());
+    qd_to_abc(qs.data(), ds.data(), angles.data(), kCount, as2.data(),
+              bs2.data(), cs2.data());
+
+    for (int i = 0; i < kCount; ++i) {
+        const std::complex<Scalar> qd = abc_to_qd(
+            as[i], bs[i], cs[i], get_rotation(-angles[i]));
+        EXPECT_NEAR(qs[i], qd.real(), 1e-12);
+        EXPECT_NEAR(ds[i], qd.imag(), 1e-12);
+        EXPECT_NEAR(as2[i], as[i], 1e-12);
+        EXPECT_NEAR(bs2[i], bs[i], 1e-12);
+        EXPECT_NEAR(cs2[i], cs[i], 1e-12);
+    }
+}
+
+TEST(clarke_transform, n_phase_matches_three_phase) {
+    const Eigen::Matrix<Scalar, 3, 1> abc = {1.5, -0.25, 0.75};
+    const std::complex<Scalar> expected = clarke_transform(abc);
+    const std::complex<Scalar> result =
+        clarke_transform<Scalar, 3>(Eigen::Matrix<Scalar, 3, 1>(abc));
+
+    EXPECT_NEAR(result.real(), expected.real(), 1e-12);
+    EXPECT_NEAR(result.imag(), expected.imag(), 1e-12);
+}
+
+TEST(qd_to_abc, five_phase_round_trip) {
+    const std::complex<Scalar> qd = {0.7, -0.2};
+    const std::complex<Scalar> park_transform = get_rotation(-1.3);
+    const Eigen::Matrix<Scalar, 5, 1> phases = qd_to_abc<5>(qd, park_transform);
+
+    // balanced, and power invariant
+    EXPECT_NEAR(phases.sum(), 0, 1e-12);
+    EXPECT_NEAR(phases.squaredNorm(), std::norm(qd), 1e-12);
+
+    const std::complex<Scalar> result = abc_to_qd(phases, park_transform);
+    EXPECT_NEAR(result.real(), qd.real(), 1e-12);
+    EXPECT_NEAR(result.imag(), qd.imag(), 1e-12);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "util/math_constants.h"
+
+// Compile time versions of std::sqrt, std::sin and std::cos for building
+// constant tables. They are accurate to a few ulp but slow, so they
+// should not be called at runtime.
+
+constexpr double constexpr_sqrt(const double x) {
+    if (!(x > 0) || x + x == x) {
+        // zero, negative, nan or inf
+        return x == 0 || x + x == x ? x : 0.0 / 0.0;
+    }
+
+    // Newton's method from above decreases monotonically until it
+    // converges
+    double guess = x > 1 ? x : 1;
+    while (true) {
+        const double next = 0.5 * (guess + x / guess);
+        if (next >= guess) {
+            return guess;
+        }
+        guess = next;
+    }
+}
+
+constexpr double constexpr_sin(const double x) {
+    // reduce to [-pi, pi]
+    const double turns = x / (2 * kPI);
+    const long long nearest_turn =
+        static_cast<long long>(turns < 0 ? turns - 0.5 : turns + 0.5);
+    double r = x - nearest_turn * (2 * kPI);
+
+    // reduce to [-pi/2, pi/2] by symmetry about +-pi/2
+    if (r > kPI / 2) {
+        r = kPI - r;
+    } else if (r < -kPI / 2) {
+        r = -kPI - r;
+    }
+
+    // taylor series
+    double term = r;
+    double result = r;
+    for (int i = 1; i < 15; ++i) {
+        term *= -r * r / ((2 * i) * (2 * i + 1));
+        result += term;
+    }
+    return result;
+}
+
+constexpr double constexpr_cos(const double x) {
+    return constexpr_sin(x + kPI / 2);
+}
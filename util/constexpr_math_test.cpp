@@ -0,0 +1,22 @@
+#include "constexpr_math.h"
+#include <cmath>
+#include <gtest/gtest.h>
+
+// usable in constant expressions
+static_assert(constexpr_sqrt(4.0) == 2.0, "");
+static_assert(constexpr_sin(0.0) == 0.0, "");
+
+TEST(constexpr_sqrt, matches_std) {
+    for (double x : {0.0, 1e-300, 1e-9, 0.5, 2.0 / 3, 1.0, 2.0, 3.0, 1e9,
+                     1e300}) {
+        EXPECT_NEAR(constexpr_sqrt(x), std::sqrt(x), 1e-15 * std::sqrt(x));
+    }
+    EXPECT_TRUE(std::isnan(constexpr_sqrt(-1.0)));
+}
+
+TEST(constexpr_sincos, matches_std) {
+    for (double x = -20; x < 20; x += 0.0123) {
+        EXPECT_NEAR(constexpr_sin(x), std::sin(x), 1e-14);
+        EXPECT_NEAR(constexpr_cos(x), std::cos(x), 1e-14);
+    }
+}
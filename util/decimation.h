@@ -0,0 +1,323 @@
+#pragma once
+
+#include "config/scalar.h"
+#include "rolling_buffer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Multi-resolution summary of a RollingBuffer of rows, for plotting long
+// histories. Level k holds buckets of kDecimationFactor^(k+1) consecutive
+// rows, each bucket keeping the per-column min, max and mean. The pyramid is
+// updated incrementally as rows are pushed, at an amortized cost of slightly
+// more than one min/max/sum per column per row.
+//
+// T must be an indexable row of Scalars with a size(), eg. std::array.
+
+constexpr int kDecimationFactor = 8;
+
+// decimation modes
+constexpr int kDecimateMinMax = 0; // min/max envelope of each bucket
+constexpr int kDecimateLttb = 1;   // largest triangle three buckets
+
+template <typename T> struct DecimationBucket {
+    T min;
+    T max;
+    T mean;
+};
+
+template <typename T> struct DecimationLevel {
+    RollingBuffer<DecimationBucket<T>> buckets;
+
+    // bucket in progress
+    DecimationBucket<T> partial;
+    int partial_count = 0;
+};
+
+template <typename T> struct DecimationPyramid {
+    std::vector<DecimationLevel<T>> levels;
+    int64_t num_pushed = 0;
+};
+
+// sizes the pyramid to summarize a rolling buffer with the given capacity
+template <typename T>
+void init_decimation_pyramid(const size_t capacity,
+                             DecimationPyramid<T>* pyramid) {
+    pyramid->levels.clear();
+    pyramid->num_pushed = 0;
+
+    // stop once a level is coarse enough to draw in a handful of points
+    constexpr size_t kMinTopLevelBuckets = 64;
+    size_t bucket_size = kDecimationFactor;
+    while (capacity / bucket_size >= kMinTopLevelBuckets) {
+        pyramid->levels.emplace_back();
+        // two spare buckets, so the level always covers the raw history
+        init_rolling_buffer(capacity / bucket_size + 2,
+                            &pyramid->levels.back().buckets);
+        bucket_size *= kDecimationFactor;
+    }
+}
+
+namespace decimation_internal {
+
+template <typename T>
+void merge_into_partial(const T& min, const T& max, const T& mean,
+                        DecimationLevel<T>* level) {
+    DecimationBucket<T>& partial = level->partial;
+    if (level->partial_count == 0) {
+        partial.min = min;
+        partial.max = max;
+        partial.mean = mean;
+    } else {
+        for (size_t i = 0; i < partial.min.size(); ++i) {
+            partial.min[i] = std::min(partial.min[i], min[i]);
+            partial.max[i] = std::max(partial.max[i], max[i]);
+            partial.mean[i] += mean[i];
+        }
+    }
+    ++level->partial_count;
+}
+
+template <typename T> void close_partial(DecimationLevel<T>* level) {
+    for (auto& mean : level->partial.mean) {
+        mean /= kDecimationFactor;
+    }
+    rolling_buffer_push(level->partial, &level->buckets);
+    level->partial_count = 0;
+}
+
+} // namespace decimation_internal
+
+// call along with every rolling_buffer_push of the summarized buffer
+template <typename T>
+void decimation_pyramid_push(const T& row, DecimationPyramid<T>* pyramid) {
+    using namespace decimation_internal;
+
+    ++pyramid->num_pushed;
+    if (pyramid->levels.empty()) {
+        return;
+    }
+
+    merge_into_partial(row, row, row, &pyramid->levels[0]);
+    for (size_t k = 0; k < pyramid->levels.size(); ++k) {
+        DecimationLevel<T>& level = pyramid->levels[k];
+        if (level.partial_count < kDecimationFactor) {
+            break;
+        }
+        close_partial(&level);
+        if (k + 1 < pyramid->levels.size()) {
+            const DecimationBucket<T>& closed =
+                get_rolling_buffer_back_row(level.buckets);
+            merge_into_partial(closed.min, closed.max, closed.mean,
+                               &pyramid->levels[k + 1]);
+        }
+    }
+}
+
+// Recomputes the pyramid from the rows of the summarized buffer, for when
+// they changed other than by pushing, eg. truncate_rolling_buffer.
+template <typename T>
+void rebuild_decimation_pyramid(const RollingBuffer<T>& raw,
+                                DecimationPyramid<T>* pyramid) {
+    init_decimation_pyramid(raw.ctx.capacity, pyramid);
+    const int count = get_rolling_buffer_count(raw.ctx);
+    for (int i = 0; i < count; ++i) {
+        decimation_pyramid_push(get_rolling_buffer_row(raw, i), pyramid);
+    }
+}
+
+// Reduces a series of count points to at most threshold points, keeping the
+// visually significant ones.
+// https://skemman.is/bitstream/1946/15343/3/SS_MSthesis.pdf
+inline void lttb_decimate(const Scalar* xs, const Scalar* ys, const int count,
+                          const int threshold, std::vector<Scalar>* out_xs,
+                          std::vector<Scalar>* out_ys) {
+    out_xs->clear();
+    out_ys->clear();
+    if (threshold >= count || threshold < 3) {
+        out_xs->assign(xs, xs + count);
+        out_ys->assign(ys, ys + count);
+        return;
+    }
+
+    // first and last points are always kept
+    const Scalar bucket_size = Scalar(count - 2) / (threshold - 2);
+    int a = 0;
+    out_xs->push_back(xs[0]);
+    out_ys->push_back(ys[0]);
+
+    for (int i = 0; i < threshold - 2; ++i) {
+        // average of the next bucket
+        const int next_begin = int((i + 1) * bucket_size) + 1;
+        const int next_end = std::min(int((i + 2) * bucket_size) + 1, count);
+        Scalar avg_x = 0;
+        Scalar avg_y = 0;
+        for (int j = next_begin; j < next_end; ++j) {
+            avg_x += xs[j];
+            avg_y += ys[j];
+        }
+        const int next_count = std::max(next_end - next_begin, 1);
+        avg_x /= next_count;
+        avg_y /= next_count;
+
+        // pick the point in this bucket with the largest triangle
+        const int begin = int(i * bucket_size) + 1;
+        const int end = int((i + 1) * bucket_size) + 1;
+        Scalar max_area = -1;
+        int max_idx = begin;
+        for (int j = begin; j < end; ++j) {
+            const Scalar area =
+                std::abs((xs[a] - avg_x) * (ys[j] - ys[a]) -
+                         (xs[a] - xs[j]) * (avg_y - ys[a]));
+            if (area > max_area) {
+                max_area = area;
+                max_idx = j;
+            }
+        }
+
+        out_xs->push_back(xs[max_idx]);
+        out_ys->push_back(ys[max_idx]);
+        a = max_idx;
+    }
+
+    out_xs->push_back(xs[count - 1]);
+    out_ys->push_back(ys[count - 1]);
+}
+
+namespace decimation_internal {
+
+// appends rows [i0, i1) of the summarized buffer at the given level,
+// where rows are numbered since the pyramid was initialized and level -1
+// is the raw buffer. Partial buckets at either end come from finer levels.
+template <typename T>
+void append_range(const RollingBuffer<T>& raw,
+                  const DecimationPyramid<T>& pyramid, const int level,
+                  const int x_column, const int y_column, const int mode,
+                  const int64_t i0, const int64_t i1, std::vector<Scalar>* xs,
+                  std::vector<Scalar>* ys) {
+    if (i0 >= i1) {
+        return;
+    }
+
+    if (level < 0) {
+        const int64_t first_row =
+            pyramid.num_pushed - get_rolling_buffer_count(raw.ctx);
+        for (int64_t i = i0; i < i1; ++i) {
+            const T& row = get_rolling_buffer_row(raw, int(i - first_row));
+            xs->push_back(row[x_column]);
+            ys->push_back(row[y_column]);
+        }
+        return;
+    }
+
+    int64_t bucket_size = kDecimationFactor;
+    for (int k = 0; k < level; ++k) {
+        bucket_size *= kDecimationFactor;
+    }
+    const int64_t j0 = (i0 + bucket_size - 1) / bucket_size;
+    const int64_t j1 = i1 / bucket_size;
+    if (j0 >= j1) {
+        append_range(raw, pyramid, level - 1, x_column, y_column, mode, i0, i1,
+                     xs, ys);
+        return;
+    }
+
+    append_range(raw, pyramid, level - 1, x_column, y_column, mode, i0,
+                 j0 * bucket_size, xs, ys);
+
+    const RollingBuffer<DecimationBucket<T>>& buckets =
+        pyramid.levels[level].buckets;
+    const int64_t first_bucket =
+        pyramid.num_pushed / bucket_size - get_rolling_buffer_count(buckets.ctx);
+    for (int64_t j = j0; j < j1; ++j) {
+        const DecimationBucket<T>& bucket =
+            get_rolling_buffer_row(buckets, int(j - first_bucket));
+        if (mode == kDecimateMinMax) {
+            xs->push_back(bucket.mean[x_column]);
+            ys->push_back(bucket.min[y_column]);
+            xs->push_back(bucket.mean[x_column]);
+            ys->push_back(bucket.max[y_column]);
+        } else {
+            xs->push_back(bucket.mean[x_column]);
+            ys->push_back(bucket.mean[y_column]);
+        }
+    }
+
+    append_range(raw, pyramid, level - 1, x_column, y_column, mode,
+                 j1 * bucket_size, i1, xs, ys);
+}
+
+} // namespace decimation_internal
+
+// Fetches about max_points points of column y_column against x_column
+// covering [x_begin, x_end], using the coarsest detail that still gives
+// max_points. x_column must be increasing, eg. a timestamp. The cost depends
+// only on max_points and the number of levels, not the history length.
+template <typename T>
+void decimate_for_plot(const RollingBuffer<T>& raw,
+                       const DecimationPyramid<T>& pyramid, const int x_column,
+                       const int y_column, const Scalar x_begin,
+                       const Scalar x_end, const int max_points, const int mode,
+                       std::vector<Scalar>* xs, std::vector<Scalar>* ys) {
+    xs->clear();
+    ys->clear();
+
+    const int count = get_rolling_buffer_count(raw.ctx);
+    if (count == 0) {
+        return;
+    }
+
+    // binary search the visible rows, plus one row either side
+    const auto first_at_or_after = [&](const Scalar x) {
+        int lo = 0;
+        int hi = count;
+        while (lo < hi) {
+            const int mid = (lo + hi) / 2;
+            if (get_rolling_buffer_row(raw, mid)[x_column] < x) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    };
+    const int begin = std::max(first_at_or_after(x_begin) - 1, 0);
+    const int end = std::min(first_at_or_after(x_end) + 1, count);
+
+    const int64_t first_row = pyramid.num_pushed - count;
+    const int64_t i0 = first_row + begin;
+    const int64_t i1 = first_row + end;
+
+    // min/max uses the finest level with at most max_points buckets,
+    // lttb picks from the coarsest level with at least max_points buckets
+    int level = -1;
+    int64_t bucket_size = 1;
+    while (level + 1 < int(pyramid.levels.size())) {
+        const int64_t next_count = (i1 - i0) / (bucket_size * kDecimationFactor);
+        const bool coarsen = mode == kDecimateLttb
+                                 ? next_count >= max_points
+                                 : (i1 - i0) / bucket_size > max_points;
+        if (!coarsen) {
+            break;
+        }
+        ++level;
+        bucket_size *= kDecimationFactor;
+    }
+
+    if (mode == kDecimateLttb) {
+        static thread_local std::vector<Scalar> oversampled_xs;
+        static thread_local std::vector<Scalar> oversampled_ys;
+        oversampled_xs.clear();
+        oversampled_ys.clear();
+        decimation_internal::append_range(raw, pyramid, level, x_column,
+                                          y_column, mode, i0, i1,
+                                          &oversampled_xs, &oversampled_ys);
+        lttb_decimate(oversampled_xs.data(), oversampled_ys.data(),
+                      oversampled_xs.size(), max_points, xs, ys);
+        return;
+    }
+
+    decimation_internal::append_range(raw, pyramid, level, x_column, y_column,
+                                      mode, i0, i1, xs, ys);
+}
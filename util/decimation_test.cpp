@@ -0,0 +1,124 @@
+#include "decimation.h"
+#include <array>
+#include <cmath>
+#include <gtest/gtest.h>
+
+// time, value
+using Row = std::array<Scalar, 2>;
+
+struct History {
+    RollingBuffer<Row> raw;
+    DecimationPyramid<Row> pyramid;
+};
+
+void push(const Row& row, History* history) {
+    rolling_buffer_push(row, &history->raw);
+    decimation_pyramid_push(row, &history->pyramid);
+}
+
+void init_history(const int capacity, const int num_rows, History* history) {
+    init_rolling_buffer(capacity, &history->raw);
+    init_decimation_pyramid(capacity, &history->pyramid);
+    for (int i = 0; i < num_rows; ++i) {
+        push(Row{Scalar(i), std::sin(i * 0.001) + (i % 7 == 0 ? 0.5 : 0)},
+             history);
+    }
+}
+
+TEST(decimate_for_plot, small_history_is_not_decimated) {
+    History history;
+    init_history(200, 150, &history);
+    EXPECT_TRUE(history.pyramid.levels.empty());
+
+    std::vector<Scalar> xs, ys;
+    decimate_for_plot(history.raw, history.pyramid, 0, 1, 0, 1000, 500,
+                      kDecimateMinMax, &xs, &ys);
+    ASSERT_EQ(xs.size(), 150);
+    for (int i = 0; i < 150; ++i) {
+        EXPECT_EQ(xs[i], i);
+    }
+}
+
+TEST(decimate_for_plot, min_max_envelope) {
+    // wrapped around several times
+    History history;
+    init_history(100000, 345678, &history);
+
+    const Scalar x_begin = 300000;
+    const Scalar x_end = 340000;
+    std::vector<Scalar> xs, ys;
+    decimate_for_plot(history.raw, history.pyramid, 0, 1, x_begin, x_end, 500,
+                      kDecimateMinMax, &xs, &ys);
+
+    // coarse enough, covering the whole range in order
+    EXPECT_LT(xs.size(), 4 * 500);
+    EXPECT_GT(xs.size(), 500 / 4);
+    EXPECT_LE(xs.front(), x_begin + 10);
+    EXPECT_GE(xs.back(), x_end - 10);
+    for (int i = 1; i < int(xs.size()); ++i) {
+        EXPECT_LE(xs[i - 1], xs[i]);
+    }
+
+    // the envelope keeps the extremes of the raw data
+    Scalar raw_min = 1e9;
+    Scalar raw_max = -1e9;
+    for (int i = 0; i < get_rolling_buffer_count(history.raw.ctx); ++i) {
+        const Row& row = get_rolling_buffer_row(history.raw, i);
+        if (row[0] >= x_begin && row[0] <= x_end) {
+            raw_min = std::min(raw_min, row[1]);
+            raw_max = std::max(raw_max, row[1]);
+        }
+    }
+    EXPECT_NEAR(*std::min_element(ys.begin(), ys.end()), raw_min, 1e-3);
+    EXPECT_NEAR(*std::max_element(ys.begin(), ys.end()), raw_max, 1e-3);
+}
+
+TEST(decimate_for_plot, after_truncating) {
+    History history;
+    init_history(100000, 345678, &history);
+
+    // back to x = 300000, after wrapping around
+    const int num_kept = 300000 - (345678 - 100000);
+    truncate_rolling_buffer(num_kept, &history.raw);
+    rebuild_decimation_pyramid(history.raw, &history.pyramid);
+    for (int i = 300000; i < 310000; ++i) {
+        push(Row{Scalar(i), 0}, &history);
+    }
+
+    std::vector<Scalar> xs, ys;
+    decimate_for_plot(history.raw, history.pyramid, 0, 1, 250000, 310000, 500,
+                      kDecimateMinMax, &xs, &ys);
+    EXPECT_LE(xs.front(), 250000 + 10);
+    EXPECT_GE(xs.back(), 310000 - 10);
+    for (int i = 1; i < int(xs.size()); ++i) {
+        EXPECT_LE(xs[i - 1], xs[i]);
+    }
+}
+
+TEST(decimate_for_plot, lttb) {
+    History history;
+    init_history(100000, 250000, &history);
+
+    std::vector<Scalar> xs, ys;
+    decimate_for_plot(history.raw, history.pyramid, 0, 1, 160000, 240000, 300,
+                      kDecimateLttb, &xs, &ys);
+    EXPECT_EQ(xs.size(), 300);
+    for (int i = 1; i < int(xs.size()); ++i) {
+        EXPECT_LT(xs[i - 1], xs[i]);
+    }
+}
+
+TEST(lttb_decimate, keeps_spike) {
+    std::vector<Scalar> xs(1000), ys(1000, 0.0);
+    for (int i = 0; i < 1000; ++i) {
+        xs[i] = i;
+    }
+    ys[567] = 10;
+
+    std::vector<Scalar> out_xs, out_ys;
+    lttb_decimate(xs.data(), ys.data(), 1000, 50, &out_xs, &out_ys);
+    ASSERT_EQ(out_xs.size(), 50);
+    EXPECT_EQ(out_xs.front(), 0);
+    EXPECT_EQ(out_xs.back(), 999);
+    EXPECT_EQ(*std::max_element(out_ys.begin(), out_ys.end()), 10);
+}
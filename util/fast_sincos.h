@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+// Accuracy levels of fast_sincos, given as the max absolute error for
+// angles up to about 1e6 radians
+constexpr int kSincosFast = 0;    // ~1e-5
+constexpr int kSincosMedium = 1;  // ~3e-8, enough for float
+constexpr int kSincosPrecise = 2; // ~1e-16, on par with std::sin/std::cos
+
+namespace sincos_internal {
+// pi/4 split into three parts so that the range reduction stays exact
+// for the first two products (from cephes)
+constexpr double kPiOver4A = 7.85398125648498535156e-1;
+constexpr double kPiOver4B = 3.77489470793079817668e-8;
+constexpr double kPiOver4C = 2.69515142907905952645e-15;
+constexpr double k4OverPi = 1.27323954473516268615;
+
+// polynomial coefficients in z^2, lowest order first.
+// sin(z) ~ z * p(z^2) and cos(z) ~ q(z^2)
+constexpr double kSinFast[] = {0.99999856940993381, -0.16662480163377094,
+                               0.0081516355068933788};
+constexpr double kCosFast[] = {0.99999003492502481, -0.49970813996218821,
+                               0.040398535329276453};
+constexpr double kSinMedium[] = {0.99999999692633312, -0.16666650699218419,
+                                 0.0083320368765290205,
+                                 -0.00019504022186433883};
+constexpr double kCosMedium[] = {0.99999997242342153, -0.49999856696048844,
+                                 0.041655026891529494,
+                                 -0.0013585908580779275};
+// cephes sin.c coefficients
+constexpr double kSinPrecise[] = {
+    1.0,
+    -1.66666666666666307295e-1,
+    8.33333333332211858878e-3,
+    -1.98412698295895385996e-4,
+    2.75573136213857245213e-6,
+    -2.50507477628578072866e-8,
+    1.58962301576546568060e-10,
+};
+constexpr double kCosPrecise[] = {
+    1.0,
+    -0.5,
+    4.16666666666665929218e-2,
+    -1.38888888888730564116e-3,
+    2.48015872888517045348e-5,
+    -2.75573141792967388112e-7,
+    2.08757008419747316778e-9,
+    -1.13585365213876817300e-11,
+};
+
+template <int N>
+inline double horner(const double (&coeffs)[N], const double x) {
+    double result = coeffs[N - 1];
+    for (int i = N - 2; i >= 0; --i) {
+        result = result * x + coeffs[i];
+    }
+    return result;
+}
+
+// sin and cos of z in [-pi/4, pi/4]
+template <int kAccuracy>
+inline void sincos_kernel(const double z, double* sin_z, double* cos_z) {
+    const double zz = z * z;
+    if constexpr (kAccuracy == kSincosFast) {
+        *sin_z = z * horner(kSinFast, zz);
+        *cos_z = horner(kCosFast, zz);
+    } else if constexpr (kAccuracy == kSincosMedium) {
+        *sin_z = z * horner(kSinMedium, zz);
+        *cos_z = horner(kCosMedium, zz);
+    } else {
+        static_assert(kAccuracy == kSincosPrecise, "unknown sincos accuracy");
+        *sin_z = z * horner(kSinPrecise, zz);
+        *cos_z = horner(kCosPrecise, zz);
+    }
+}
+} // namespace sincos_internal
+
+// Computes sin and cos of angle together, sharing one range reduction.
+template <int kAccuracy = kSincosPrecise, typename TScalar>
+inline void fast_sincos(const TScalar angle, TScalar* sin_angle,
+                        TScalar* cos_angle) {
+    using namespace sincos_internal;
+
+    // reduce |angle| to z + quadrant * pi/2, with z in [-pi/4, pi/4]
+    const double x = std::abs(static_cast<double>(angle));
+    int64_t octant = static_cast<int64_t>(x * k4OverPi);
+    octant += octant & 1;
+    const double y = static_cast<double>(octant);
+    const double z = ((x - y * kPiOver4A) - y * kPiOver4B) - y * kPiOver4C;
+
+    double sin_z, cos_z;
+    sincos_kernel<kAccuracy>(z, &sin_z, &cos_z);
+
+    double sin_x, cos_x;
+    switch ((octant >> 1) & 3) {
+    case 0:
+        sin_x = sin_z;
+        cos_x = cos_z;
+        break;
+    case 1:
+        sin_x = cos_z;
+        cos_x = -sin_z;
+        break;
+    case 2:
+        sin_x = -sin_z;
+        cos_x = -cos_z;
+        break;
+    default:
+        sin_x = -cos_z;
+        cos_x = sin_z;
+        break;
+    }
+
+    // sin is odd, cos is even
+    *sin_angle = static_cast<TScalar>(angle < 0 ? -sin_x : sin_x);
+    *cos_angle = static_cast<TScalar>(cos_x);
+}
@@ -0,0 +1,44 @@
+#include "fast_sincos.h"
+#include "rotation.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+
+using Scalar = double;
+constexpr Scalar angle_step = 0.0123;
+
+static void BM_Sincos_Std(benchmark::State& state) {
+    Scalar angle = 1.2345;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(std::sin(angle));
+        benchmark::DoNotOptimize(std::cos(angle));
+        angle += angle_step;
+    }
+}
+BENCHMARK(BM_Sincos_Std);
+
+template <int kAccuracy>
+static void BM_Sincos_Fast(benchmark::State& state) {
+    Scalar angle = 1.2345;
+    for (auto _ : state) {
+        Scalar s, c;
+        fast_sincos<kAccuracy>(angle, &s, &c);
+        benchmark::DoNotOptimize(s);
+        benchmark::DoNotOptimize(c);
+        angle += angle_step;
+    }
+}
+BENCHMARK_TEMPLATE(BM_Sincos_Fast, kSincosFast);
+BENCHMARK_TEMPLATE(BM_Sincos_Fast, kSincosMedium);
+BENCHMARK_TEMPLATE(BM_Sincos_Fast, kSincosPrecise);
+
+static void BM_Sincos_Recurrence(benchmark::State& state) {
+    RotationRecurrence<Scalar> recurrence;
+    init_rotation_recurrence<Scalar>(1.2345, angle_step, &recurrence);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(advance_rotation_recurrence(&recurrence));
+    }
+}
+BENCHMARK(BM_Sincos_Recurrence);
+
+// Run the benchmark
+BENCHMARK_MAIN();
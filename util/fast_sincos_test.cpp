@@ -0,0 +1,51 @@
+#include "fast_sincos.h"
+#include "rotation.h"
+#include <cmath>
+#include <gtest/gtest.h>
+
+template <int kAccuracy>
+double get_max_sincos_error(const double begin, const double end) {
+    double max_error = 0;
+    for (double x = begin; x < end; x += 0.000731) {
+        double s, c;
+        fast_sincos<kAccuracy>(x, &s, &c);
+        max_error = std::max(max_error, std::abs(s - std::sin(x)));
+        max_error = std::max(max_error, std::abs(c - std::cos(x)));
+    }
+    return max_error;
+}
+
+TEST(fast_sincos, fast_accuracy) {
+    EXPECT_LT(get_max_sincos_error<kSincosFast>(-100, 100), 1e-5);
+}
+
+TEST(fast_sincos, medium_accuracy) {
+    EXPECT_LT(get_max_sincos_error<kSincosMedium>(-100, 100), 3e-8);
+}
+
+TEST(fast_sincos, precise_accuracy) {
+    EXPECT_LT(get_max_sincos_error<kSincosPrecise>(-100, 100), 3e-16);
+    EXPECT_LT(get_max_sincos_error<kSincosPrecise>(1e6, 1e6 + 10), 1e-15);
+}
+
+TEST(fast_sincos, float) {
+    float s, c;
+    fast_sincos<kSincosMedium>(2.5f, &s, &c);
+    EXPECT_NEAR(s, std::sin(2.5f), 1e-7);
+    EXPECT_NEAR(c, std::cos(2.5f), 1e-7);
+}
+
+TEST(RotationRecurrence, tracks_angle) {
+    const double angle_step = 0.0123;
+    RotationRecurrence<double> recurrence;
+    init_rotation_recurrence(0.5, angle_step, &recurrence);
+
+    for (int i = 1; i <= 100000; ++i) {
+        const std::complex<double> rotation =
+            advance_rotation_recurrence(&recurrence);
+        const double angle = 0.5 + i * angle_step;
+        ASSERT_NEAR(rotation.real(), std::cos(angle), 1e-10);
+        ASSERT_NEAR(rotation.imag(), std::sin(angle), 1e-10);
+    }
+    EXPECT_NEAR(std::abs(recurrence.rotation), 1.0, 1e-14);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "config/scalar.h"
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Parses the leading numeric fields of a comma separated row, stopping at the
+// first field that is not a number or after max_values. Returns the number
+// of values parsed, 0 for headers and blank rows.
+inline int parse_numeric_csv_row(const char* row, const int max_values,
+                                 Scalar* values) {
+    int count = 0;
+    const char* field = row;
+    while (count < max_values) {
+        char* end;
+        const Scalar value = std::strtod(field, &end);
+        if (end == field) {
+            break;
+        }
+        values[count++] = value;
+        while (*end == ' ' || *end == '\t') {
+            ++end;
+        }
+        if (*end != ',') {
+            break;
+        }
+        field = end + 1;
+    }
+    return count;
+}
+
+// Reads a csv file of numbers, calling on_row with the leading numeric
+// fields of each row that has any, up to max_values. Rows that do not start
+// with a number, such as headers, are skipped. Returns false if the file can
+// not be read.
+inline bool read_numeric_csv(
+    const std::string& path, const int max_values,
+    const std::function<void(const Scalar* values, int num_values)>& on_row) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    std::string line;
+    std::vector<Scalar> values(max_values);
+    while (std::getline(file, line)) {
+        const int num_values =
+            parse_numeric_csv_row(line.c_str(), max_values, values.data());
+        if (num_values > 0) {
+            on_row(values.data(), num_values);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,42 @@
+#include "numeric_csv.h"
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <vector>
+
+TEST(parse_numeric_csv_row, leading_fields) {
+    Scalar values[4] = {};
+    EXPECT_EQ(parse_numeric_csv_row(" 1.5 , -2,3e2\r", 4, values), 3);
+    EXPECT_EQ(values[0], 1.5);
+    EXPECT_EQ(values[1], -2);
+    EXPECT_EQ(values[2], 300);
+
+    // stops at the first field that is not a number
+    EXPECT_EQ(parse_numeric_csv_row("1, x, 3", 4, values), 1);
+    EXPECT_EQ(parse_numeric_csv_row("1 2", 4, values), 1);
+    EXPECT_EQ(parse_numeric_csv_row("1, 2, 3", 2, values), 2);
+    EXPECT_EQ(parse_numeric_csv_row("angle, torque", 4, values), 0);
+    EXPECT_EQ(parse_numeric_csv_row("", 4, values), 0);
+}
+
+TEST(read_numeric_csv, skips_headers) {
+    const std::string path = testing::TempDir() + "numeric.csv";
+    {
+        std::ofstream csv(path);
+        csv << "a, b\n1, 2\n\n3\n# note\n4, 5, 6\n";
+    }
+
+    std::vector<std::vector<Scalar>> rows;
+    ASSERT_TRUE(read_numeric_csv(
+        path, 2, [&](const Scalar* values, const int num_values) {
+            rows.emplace_back(values, values + num_values);
+        }));
+    ASSERT_EQ(rows.size(), 3u);
+    EXPECT_EQ(rows[0], std::vector<Scalar>({1, 2}));
+    EXPECT_EQ(rows[1], std::vector<Scalar>({3}));
+    EXPECT_EQ(rows[2], std::vector<Scalar>({4, 5}));
+
+    EXPECT_FALSE(read_numeric_csv(testing::TempDir() + "missing.csv", 2,
+                                  [](const Scalar*, int) {}));
+    std::remove(path.c_str());
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "math_constants.h"
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+// Counter based random numbers with Philox4x32-10 (Salmon et al., "Parallel
+// Random Numbers: As Easy as 1, 2, 3"). Every block of output is a pure
+// function of (seed, stream, block index), so streams need no shared state,
+// can be handed to any thread, and any draw can be regenerated from the seed.
+
+// streams of the subsystems that draw randomness. sweeps and other
+// parallel runs tell their copies apart with the stream instance
+constexpr uint32_t kRandomStreamCogging = 0;
+
+namespace random_internal {
+constexpr uint32_t kPhiloxM0 = 0xD2511F53;
+constexpr uint32_t kPhiloxM1 = 0xCD9E8D57;
+constexpr uint32_t kPhiloxW0 = 0x9E3779B9; // golden ratio
+constexpr uint32_t kPhiloxW1 = 0xBB67AE85; // sqrt(3) - 1
+} // namespace random_internal
+
+using PhiloxCounter = std::array<uint32_t, 4>;
+using PhiloxKey = std::array<uint32_t, 2>;
+
+inline PhiloxCounter philox4x32(PhiloxCounter counter, PhiloxKey key) {
+    using namespace random_internal;
+    for (int round = 0; round < 10; ++round) {
+        if (round > 0) {
+            key[0] += kPhiloxW0;
+            key[1] += kPhiloxW1;
+        }
+        const uint64_t product0 = uint64_t(kPhiloxM0) * counter[0];
+        const uint64_t product1 = uint64_t(kPhiloxM1) * counter[2];
+        counter = {uint32_t(product1 >> 32) ^ counter[1] ^ key[0],
+                   uint32_t(product1),
+                   uint32_t(product0 >> 32) ^ counter[3] ^ key[1],
+                   uint32_t(product0)};
+    }
+    return counter;
+}
+
+struct RandomStream {
+    PhiloxKey key = {};
+    uint32_t stream = 0;
+    uint32_t instance = 0;
+    uint64_t block_idx = 0; // next block to generate
+
+    PhiloxCounter block = {};
+    int next_word = 4; // of block, 4 when used up
+
+    // the second of each pair of box-muller normals
+    bool has_spare_normal = false;
+    double spare_normal = 0;
+};
+
+inline void init_random_stream(const uint64_t seed, const uint32_t stream,
+                               const uint32_t instance,
+                               RandomStream* random_stream) {
+    *random_stream = {};
+    random_stream->key = {uint32_t(seed), uint32_t(seed >> 32)};
+    random_stream->stream = stream;
+    random_stream->instance = instance;
+}
+
+inline uint32_t random_u32(RandomStream* random_stream) {
+    if (random_stream->next_word == 4) {
+        const uint64_t block_idx = random_stream->block_idx++;
+        random_stream->block =
+            philox4x32({uint32_t(block_idx), uint32_t(block_idx >> 32),
+                        random_stream->stream, random_stream->instance},
+                       random_stream->key);
+        random_stream->next_word = 0;
+    }
+    return random_stream->block[random_stream->next_word++];
+}
+
+inline uint64_t random_u64(RandomStream* random_stream) {
+    const uint64_t low = random_u32(random_stream);
+    return (uint64_t(random_u32(random_stream)) << 32) | low;
+}
+
+// [0, 1), with 53 random bits
+inline double random_uniform(RandomStream* random_stream) {
+    return (random_u64(random_stream) >> 11) * (1.0 / (uint64_t(1) << 53));
+}
+
+// standard normal, by box-muller
+inline double random_normal(RandomStream* random_stream) {
+    if (random_stream->has_spare_normal) {
+        random_stream->has_spare_normal = false;
+        return random_stream->spare_normal;
+    }
+    // (0, 1] so the log stays finite
+    const double u0 = 1.0 - random_uniform(random_stream);
+    const double u1 = random_uniform(random_stream);
+    const double radius = std::sqrt(-2 * std::log(u0));
+    const double angle = 2 * kPI * u1;
+    random_stream->spare_normal = radius * std::sin(angle);
+    random_stream->has_spare_normal = true;
+    return radius * std::cos(angle);
+}
@@ -0,0 +1,69 @@
+#include "random.h"
+#include <gtest/gtest.h>
+
+// known answers from the Random123 distribution
+TEST(philox4x32, known_answers) {
+    EXPECT_EQ(philox4x32({0, 0, 0, 0}, {0, 0}),
+              PhiloxCounter({0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}));
+    EXPECT_EQ(philox4x32({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+                         {0xffffffff, 0xffffffff}),
+              PhiloxCounter({0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}));
+    EXPECT_EQ(philox4x32({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+                         {0xa4093822, 0x299f31d0}),
+              PhiloxCounter({0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}));
+}
+
+TEST(random_stream, reproducible) {
+    RandomStream a;
+    RandomStream b;
+    init_random_stream(/*seed=*/1234, kRandomStreamCogging, /*instance=*/0,
+                       &a);
+    init_random_stream(/*seed=*/1234, kRandomStreamCogging, /*instance=*/0,
+                       &b);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(random_u32(&a), random_u32(&b));
+    }
+}
+
+TEST(random_stream, independent) {
+    RandomStream base;
+    RandomStream other_seed;
+    RandomStream other_stream;
+    RandomStream other_instance;
+    init_random_stream(1, 0, 0, &base);
+    init_random_stream(2, 0, 0, &other_seed);
+    init_random_stream(1, 1, 0, &other_stream);
+    init_random_stream(1, 0, 1, &other_instance);
+
+    int num_equal = 0;
+    for (int i = 0; i < 1000; ++i) {
+        const uint32_t x = random_u32(&base);
+        num_equal += x == random_u32(&other_seed);
+        num_equal += x == random_u32(&other_stream);
+        num_equal += x == random_u32(&other_instance);
+    }
+    EXPECT_EQ(num_equal, 0);
+}
+
+TEST(random_stream, distributions) {
+    RandomStream stream;
+    init_random_stream(42, 0, 0, &stream);
+
+    constexpr int kNumSamples = 100000;
+    double uniform_sum = 0;
+    double normal_sum = 0;
+    double normal_sum_sq = 0;
+    for (int i = 0; i < kNumSamples; ++i) {
+        const double u = random_uniform(&stream);
+        ASSERT_GE(u, 0);
+        ASSERT_LT(u, 1);
+        uniform_sum += u;
+
+        const double n = random_normal(&stream);
+        normal_sum += n;
+        normal_sum_sq += n * n;
+    }
+    EXPECT_NEAR(uniform_sum / kNumSamples, 0.5, 0.01);
+    EXPECT_NEAR(normal_sum / kNumSamples, 0, 0.02);
+    EXPECT_NEAR(normal_sum_sq / kNumSamples, 1, 0.02);
+}
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <memory>
 
 struct RollingBufferContext {
     RollingBufferContext(size_t capacity) : capacity(capacity) {}
@@ -38,3 +40,77 @@ inline int get_rolling_buffer_begin(const RollingBufferContext& context) {
 inline int get_rolling_buffer_back(const RollingBufferContext& context) {
     return (context.next_idx + context.capacity - 1) % context.capacity;
 }
+
+// Circular buffer of rows of type T, with a runtime capacity.
+// All rows live in a single allocation, so a row of many signals is pushed
+// with one copy, and each signal can be read in place with a stride of
+// sizeof(T).
+template <typename T> struct RollingBuffer {
+    RollingBufferContext ctx{0};
+    std::unique_ptr<T[]> data;
+};
+
+// discards any existing contents
+template <typename T>
+void init_rolling_buffer(const size_t capacity, RollingBuffer<T>* buffer) {
+    buffer->ctx = RollingBufferContext(capacity);
+    buffer->data.reset(new T[capacity]);
+}
+
+template <typename T> void clear_rolling_buffer(RollingBuffer<T>* buffer) {
+    buffer->ctx = RollingBufferContext(buffer->ctx.capacity);
+}
+
+// Keeps the oldest count rows, dropping the newer ones. After a wrap around
+// the rows are first moved so the oldest is at the front.
+template <typename T>
+void truncate_rolling_buffer(const int count, RollingBuffer<T>* buffer) {
+    if (count >= get_rolling_buffer_count(buffer->ctx)) {
+        return;
+    }
+    T* data = buffer->data.get();
+    std::rotate(data, data + get_rolling_buffer_begin(buffer->ctx),
+                data + buffer->ctx.capacity);
+    buffer->ctx.next_idx = std::max(count, 0);
+    buffer->ctx.wrap_around = false;
+}
+
+template <typename T>
+void rolling_buffer_push(const T& row, RollingBuffer<T>* buffer) {
+    buffer->data[buffer->ctx.next_idx] = row;
+    rolling_buffer_advance_idx(&buffer->ctx);
+}
+
+// idx is the logical index, 0 is the oldest row
+template <typename T>
+const T& get_rolling_buffer_row(const RollingBuffer<T>& buffer, const int idx) {
+    return buffer.data[(get_rolling_buffer_begin(buffer.ctx) + idx) %
+                       buffer.ctx.capacity];
+}
+
+// undefined if count == 0
+template <typename T>
+const T& get_rolling_buffer_back_row(const RollingBuffer<T>& buffer) {
+    return buffer.data[get_rolling_buffer_back(buffer.ctx)];
+}
+
+// The contents of a rolling buffer, oldest first, as at most two
+// contiguous spans which can be read in place.
+template <typename T> struct RollingBufferSpans {
+    const T* first = nullptr;
+    int first_count = 0;
+    const T* second = nullptr;
+    int second_count = 0;
+};
+
+template <typename T>
+RollingBufferSpans<T> get_rolling_buffer_spans(const RollingBuffer<T>& buffer) {
+    RollingBufferSpans<T> spans;
+    const int count = get_rolling_buffer_count(buffer.ctx);
+    const int begin = get_rolling_buffer_begin(buffer.ctx);
+    spans.first = buffer.data.get() + begin;
+    spans.first_count = std::min<int>(count, buffer.ctx.capacity - begin);
+    spans.second = buffer.data.get();
+    spans.second_count = count - spans.first_count;
+    return spans;
+}
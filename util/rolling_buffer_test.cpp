@@ -0,0 +1,77 @@
+#include "rolling_buffer.h"
+#include <array>
+#include <gtest/gtest.h>
+
+using Row = std::array<double, 2>;
+
+TEST(rolling_buffer, push_before_wrap) {
+    RollingBuffer<Row> buffer;
+    init_rolling_buffer(4, &buffer);
+    rolling_buffer_push(Row{0, 10}, &buffer);
+    rolling_buffer_push(Row{1, 11}, &buffer);
+
+    EXPECT_EQ(get_rolling_buffer_count(buffer.ctx), 2);
+    EXPECT_EQ(get_rolling_buffer_row(buffer, 0)[1], 10);
+    EXPECT_EQ(get_rolling_buffer_back_row(buffer)[1], 11);
+
+    const RollingBufferSpans<Row> spans = get_rolling_buffer_spans(buffer);
+    EXPECT_EQ(spans.first, buffer.data.get());
+    EXPECT_EQ(spans.first_count, 2);
+    EXPECT_EQ(spans.second_count, 0);
+}
+
+TEST(rolling_buffer, spans_after_wrap) {
+    RollingBuffer<Row> buffer;
+    init_rolling_buffer(4, &buffer);
+    for (int i = 0; i < 6; ++i) {
+        rolling_buffer_push(Row{double(i), 0}, &buffer);
+    }
+
+    const RollingBufferSpans<Row> spans = get_rolling_buffer_spans(buffer);
+    ASSERT_EQ(spans.first_count, 2);
+    ASSERT_EQ(spans.second_count, 2);
+
+    // oldest first
+    EXPECT_EQ(spans.first[0][0], 2);
+    EXPECT_EQ(spans.first[1][0], 3);
+    EXPECT_EQ(spans.second[0][0], 4);
+    EXPECT_EQ(spans.second[1][0], 5);
+
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(get_rolling_buffer_row(buffer, i)[0], 2 + i);
+    }
+}
+
+TEST(rolling_buffer, clear) {
+    RollingBuffer<Row> buffer;
+    init_rolling_buffer(3, &buffer);
+    for (int i = 0; i < 5; ++i) {
+        rolling_buffer_push(Row{double(i), 0}, &buffer);
+    }
+    clear_rolling_buffer(&buffer);
+    EXPECT_EQ(get_rolling_buffer_count(buffer.ctx), 0);
+    EXPECT_EQ(buffer.ctx.capacity, 3);
+}
+
+TEST(rolling_buffer, truncate_after_wrap) {
+    RollingBuffer<Row> buffer;
+    init_rolling_buffer(4, &buffer);
+    for (int i = 0; i < 6; ++i) {
+        rolling_buffer_push(Row{double(i), 0}, &buffer);
+    }
+    truncate_rolling_buffer(3, &buffer);
+    ASSERT_EQ(get_rolling_buffer_count(buffer.ctx), 3);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(get_rolling_buffer_row(buffer, i)[0], 2 + i);
+    }
+
+    // pushing carries on after the kept rows
+    rolling_buffer_push(Row{10, 0}, &buffer);
+    rolling_buffer_push(Row{11, 0}, &buffer);
+    ASSERT_EQ(get_rolling_buffer_count(buffer.ctx), 4);
+    EXPECT_EQ(get_rolling_buffer_row(buffer, 0)[0], 3);
+    EXPECT_EQ(get_rolling_buffer_back_row(buffer)[0], 11);
+
+    truncate_rolling_buffer(0, &buffer);
+    EXPECT_EQ(get_rolling_buffer_count(buffer.ctx), 0);
+}
@@ -1,9 +1,53 @@
 #pragma once
 
+#include "util/fast_sincos.h"
 #include <cmath>
 #include <complex>
 
-template <typename TScalar>
+template <int kAccuracy = kSincosPrecise, typename TScalar>
 std::complex<TScalar> get_rotation(const TScalar angle_radians) {
-    return {std::cos(angle_radians), std::sin(angle_radians)};
+    TScalar sin_angle, cos_angle;
+    fast_sincos<kAccuracy>(angle_radians, &sin_angle, &cos_angle);
+    return {cos_angle, sin_angle};
+}
+
+// Rotation for an angle that advances by a fixed step, updated with one
+// complex multiply per step instead of a sincos. The magnitude is pulled
+// back to 1 every renormalize_period steps. The phase error still grows
+// by about one ulp per step, so long runs should be re-initialized from
+// the true angle now and then.
+template <typename TScalar>
+struct RotationRecurrence {
+    std::complex<TScalar> rotation = 1; // at the current angle
+    std::complex<TScalar> step = 1;     // rotation by the angle step
+    int renormalize_period = 64;
+    int steps_since_renormalize = 0;
+};
+
+template <typename TScalar>
+void init_rotation_recurrence(const TScalar angle, const TScalar angle_step,
+                              RotationRecurrence<TScalar>* recurrence) {
+    recurrence->rotation = get_rotation(angle);
+    recurrence->step = get_rotation(angle_step);
+    recurrence->steps_since_renormalize = 0;
+}
+
+// returns the rotation at the advanced angle
+template <typename TScalar>
+const std::complex<TScalar>&
+advance_rotation_recurrence(RotationRecurrence<TScalar>* recurrence) {
+    // expanded to skip the inf/nan handling of std::complex multiplication
+    const std::complex<TScalar>& r = recurrence->rotation;
+    const std::complex<TScalar>& s = recurrence->step;
+    recurrence->rotation = {r.real() * s.real() - r.imag() * s.imag(),
+                            r.real() * s.imag() + r.imag() * s.real()};
+
+    if (++recurrence->steps_since_renormalize >=
+        recurrence->renormalize_period) {
+        // one newton step towards 1/|r|, which is close to 1
+        const TScalar norm_sq = std::norm(recurrence->rotation);
+        recurrence->rotation *= (3 - norm_sq) / 2;
+        recurrence->steps_since_renormalize = 0;
+    }
+    return recurrence->rotation;
 }
@@ -1,10 +1,53 @@
+#pragma once
+
+#include "util/fast_sincos.h"
 #include <cmath>
+#include <utility>
 
-template <typename Scalar>
-void generate_odd_sine_series(int num_terms, Scalar angle, Scalar* begin) {
-    const Scalar sin_angle = std::sin(angle);
-    const Scalar cos_angle = std::cos(angle);
+constexpr int kSineSeriesOdd = 0; // harmonics 1, 3, 5, ...
+constexpr int kSineSeriesAll = 1; // harmonics 1, 2, 3, ...
+
+// harmonic number of the i'th term of a series
+constexpr int get_sine_series_harmonic(const int series, const int i) {
+    return series == kSineSeriesOdd ? 2 * i + 1 : i + 1;
+}
+
+// Evaluates sum_i coeffs[i] * sin(h_i * angle), h_i being the i'th
+// harmonic of kSeries. kNumTerms (at least 1) fixes the number of terms
+// at compile time so the loop unrolls, pass -1 to use num_terms instead.
+// TValue can be an Eigen array to evaluate several angles at once.
+template <int kSeries, int kNumTerms, typename TValue, typename TCoeff>
+TValue evaluate_sine_series(const TCoeff* coeffs, const int num_terms,
+                            const TValue& sin_angle, const TValue& cos_angle) {
+    const int n = kNumTerms >= 0 ? kNumTerms : num_terms;
+
+    // sin(x + step) = 2 cos(step) sin(x) - sin(x - step)
+    TValue two_cos_step;
+    TValue prev;
+    if (kSeries == kSineSeriesOdd) {
+        two_cos_step = 4 * cos_angle * cos_angle - 2;
+        prev = -sin_angle;
+    } else {
+        two_cos_step = 2 * cos_angle;
+        prev = 0 * sin_angle;
+    }
+    TValue curr = sin_angle;
 
+    TValue result = coeffs[0] * curr;
+    for (int i = 1; i < n; ++i) {
+        TValue next = two_cos_step * curr - prev;
+        prev = curr;
+        curr = next;
+        result += coeffs[i] * curr;
+    }
+    return result;
+}
+
+// fills begin with sin(angle), sin(3*angle), sin(5*angle), ...
+// given the sin and cos of angle
+template <typename Scalar>
+void generate_odd_sine_series(int num_terms, Scalar sin_angle, Scalar cos_angle,
+                              Scalar* begin) {
     Scalar sa = 0;
     Scalar sb = sin_angle;
 
@@ -26,6 +69,13 @@ void generate_odd_sine_series(int num_terms, Scalar angle, Scalar* begin) {
     begin[num_terms - 1] = sb;
 }
 
+template <typename Scalar>
+void generate_odd_sine_series(int num_terms, Scalar angle, Scalar* begin) {
+    Scalar sin_angle, cos_angle;
+    fast_sincos(angle, &sin_angle, &cos_angle);
+    generate_odd_sine_series(num_terms, sin_angle, cos_angle, begin);
+}
+
 template <typename Scalar>
 void generate_odd_sine_series_reference(int num_terms, Scalar angle,
                                         Scalar* begin) {
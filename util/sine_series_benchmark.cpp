@@ -28,5 +28,46 @@ static void BM_Sine_Series_Custom(benchmark::State& state) {
 }
 BENCHMARK(BM_Sine_Series_Custom);
 
+constexpr Scalar coeffs[] = {1.0, 0.278, 0.119, 0.053, 0.029};
+
+// sin and cos of the three phase angles
+static Eigen::Array<Scalar, 3, 2> get_phase_sincos() {
+    Eigen::Array<Scalar, 3, 2> sincos;
+    for (int i = 0; i < 3; ++i) {
+        sincos(i, 0) = std::sin(angle - i * 2.0943951023931953);
+        sincos(i, 1) = std::cos(angle - i * 2.0943951023931953);
+    }
+    return sincos;
+}
+
+// three phases one after another, number of terms known at runtime
+static void BM_Sine_Series_Three_Phase_Runtime(benchmark::State& state) {
+    Eigen::Array<Scalar, 3, 2> sincos = get_phase_sincos();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sincos);
+        Eigen::Matrix<Scalar, 3, 1> values;
+        for (int i = 0; i < 3; ++i) {
+            values(i) = evaluate_sine_series<kSineSeriesOdd, -1>(
+                coeffs, 5, sincos(i, 0), sincos(i, 1));
+        }
+        benchmark::DoNotOptimize(values.sum());
+    }
+}
+BENCHMARK(BM_Sine_Series_Three_Phase_Runtime);
+
+// three phases at once, number of terms fixed at compile time
+static void BM_Sine_Series_Three_Phase_Vectorized(benchmark::State& state) {
+    Eigen::Array<Scalar, 3, 2> sincos = get_phase_sincos();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sincos);
+        const Eigen::Array<Scalar, 3, 1> sines = sincos.col(0);
+        const Eigen::Array<Scalar, 3, 1> cosines = sincos.col(1);
+        const Eigen::Array<Scalar, 3, 1> values =
+            evaluate_sine_series<kSineSeriesOdd, 5>(coeffs, 5, sines, cosines);
+        benchmark::DoNotOptimize(values.sum());
+    }
+}
+BENCHMARK(BM_Sine_Series_Three_Phase_Vectorized);
+
 // Run the benchmark
 BENCHMARK_MAIN();
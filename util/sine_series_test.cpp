@@ -1,5 +1,7 @@
 #include "sine_series.h"
+#include <Eigen/Dense>
 #include <array>
+#include <cmath>
 #include <gtest/gtest.h>
 
 TEST(sine_series, generate_odd_sine_series) {
@@ -11,7 +13,44 @@ TEST(sine_series, generate_odd_sine_series) {
     generate_odd_sine_series_reference(5, angle, ref.data());
     generate_odd_sine_series(5, angle, result.data());
 
-    for (int i = 0; i < result.size(); ++i) {
+    for (int i = 0; i < int(result.size()); ++i) {
         EXPECT_NEAR(ref[i], result[i], 1e-5);
     }
 }
+
+TEST(sine_series, evaluate_odd_sine_series) {
+    const std::array<double, 4> coeffs = {1.0, 0.3, -0.2, 0.05};
+    const double angle = 1.23;
+
+    double expected = 0;
+    for (int i = 0; i < int(coeffs.size()); ++i) {
+        expected += coeffs[i] * std::sin((2 * i + 1) * angle);
+    }
+
+    const double fixed = evaluate_sine_series<kSineSeriesOdd, 4>(
+        coeffs.data(), 4, std::sin(angle), std::cos(angle));
+    const double runtime = evaluate_sine_series<kSineSeriesOdd, -1>(
+        coeffs.data(), 4, std::sin(angle), std::cos(angle));
+
+    EXPECT_NEAR(fixed, expected, 1e-12);
+    EXPECT_NEAR(runtime, expected, 1e-12);
+}
+
+TEST(sine_series, evaluate_all_sine_series_vectorized) {
+    const std::array<double, 6> coeffs = {1.0, -0.4, 0.3, 0.1, -0.2, 0.05};
+    const Eigen::Array<double, 3, 1> angles = {0.1, 2.5, -1.7};
+    const Eigen::Array<double, 3, 1> sines = angles.sin();
+    const Eigen::Array<double, 3, 1> cosines = angles.cos();
+
+    const Eigen::Array<double, 3, 1> result =
+        evaluate_sine_series<kSineSeriesAll, 6>(coeffs.data(), 6, sines,
+                                                cosines);
+
+    for (int j = 0; j < 3; ++j) {
+        double expected = 0;
+        for (int i = 0; i < int(coeffs.size()); ++i) {
+            expected += coeffs[i] * std::sin((i + 1) * angles(j));
+        }
+        EXPECT_NEAR(result(j), expected, 1e-12);
+    }
+}